@@ -0,0 +1,105 @@
+#include <MEII/Utility/ColumnarLog.hpp>
+#include <MEII/Utility/SessionRecorder.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+using namespace mahi::util;
+using namespace meii;
+
+/// converts a session file written by SessionRecorder to a columnar log
+int convert(const std::string& input, const std::string& output, std::size_t time_field, std::size_t chunk_records, const std::string& quantize) {
+    SessionReader reader;
+    if (!reader.open(input))
+        return 1;
+    const RecordSchema& schema = reader.get_schema();
+    if (time_field >= schema.get_field_count()) {
+        LOG(Error) << "Time field " << time_field << " is not in " << input << ".";
+        return 1;
+    }
+
+    ColumnarLogWriter writer(schema, time_field, chunk_records);
+    // quanta are given as comma separated field=quantum pairs, e.g. 1=0.00306796,4=0.00306796
+    std::stringstream pairs(quantize);
+    std::string pair;
+    while (std::getline(pairs, pair, ',')) {
+        std::size_t eq = pair.find('=');
+        if (eq == std::string::npos)
+            continue;
+        std::size_t field = std::strtoul(pair.substr(0, eq).c_str(), nullptr, 10);
+        if (field < schema.get_field_count())
+            writer.set_quantum(field, std::strtod(pair.substr(eq + 1).c_str(), nullptr));
+    }
+    if (!writer.open(output))
+        return 1;
+
+    Clock clock;
+    std::vector<uint8> records;
+    std::size_t n;
+    while ((n = reader.read_chunk(records)) > 0) {
+        for (std::size_t r = 0; r < n; ++r)
+            writer.append(&records[r * schema.get_record_size()]);
+    }
+    if (!writer.close())
+        return 1;
+
+    double raw_bytes = (double)writer.get_records() * schema.get_record_size();
+    print("converted {} records into {} chunks in {:.2f} s", writer.get_records(), writer.get_chunks(), clock.get_elapsed_time().as_seconds());
+    print("{:.0f} bytes of records -> {} bytes ({:.2f} x smaller)", raw_bytes, writer.get_bytes(), raw_bytes / writer.get_bytes());
+    if (reader.is_damaged())
+        LOG(Warning) << input << " ends in a truncated or corrupt chunk, records after it were not converted.";
+    return 0;
+}
+
+/// prints one field of a columnar log between two times
+int query(const std::string& input, std::size_t field, double start, double duration) {
+    ColumnarLogReader reader;
+    if (!reader.open(input))
+        return 1;
+    if (field >= reader.get_schema().get_field_count()) {
+        LOG(Error) << "Field " << field << " is not in " << input << ".";
+        return 1;
+    }
+
+    Clock clock;
+    std::vector<double> times, values;
+    if (!reader.read_range(field, start, start + duration, times, values))
+        return 1;
+    double ms = clock.get_elapsed_time().as_seconds() * 1e3;
+
+    print("{}, {}", reader.get_schema().get_field_name(reader.get_time_field()), reader.get_schema().get_field_name(field));
+    for (std::size_t i = 0; i < times.size(); ++i)
+        print("{:.6f}, {:.9g}", times[i], values[i]);
+    print("read {} of {} records from {} chunks in {:.3f} ms", times.size(), reader.get_record_count(), reader.get_chunk_count(), ms);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+    Options options("ex_columnar_log.exe", "Converts session files to columnar logs, and reads a time range of one signal back");
+    options.add_options()
+        ("i,input", "Session file to convert, or columnar log to read with -f", value<std::string>())
+        ("o,output", "Path of the columnar log, the input path with .meiicol appended by default", value<std::string>())
+        ("t,time", "Index of the field holding the time [s]", value<int>()->default_value("0"))
+        ("c,chunk", "Records per chunk", value<int>()->default_value("4096"))
+        ("q,quantize", "Comma separated field=quantum pairs of quantized fields, e.g. encoder positions", value<std::string>()->default_value(""))
+        ("f,field", "Reads this field of the columnar log given by -i instead of converting", value<int>())
+        ("s,start", "Start of the range to read [s]", value<double>()->default_value("0"))
+        ("d,duration", "Length of the range to read [s]", value<double>()->default_value("1"))
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0 || result.count("input") == 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    const std::string input = result["input"].as<std::string>();
+    if (result.count("field") > 0)
+        return query(input, result["field"].as<int>(), result["start"].as<double>(), result["duration"].as<double>());
+
+    const std::string output = result.count("output") > 0 ? result["output"].as<std::string>() : input + ".meiicol";
+    return convert(input, output, result["time"].as<int>(), result["chunk"].as<int>(), result["quantize"].as<std::string>());
+}
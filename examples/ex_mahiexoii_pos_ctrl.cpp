@@ -77,32 +77,35 @@ int main(int argc, char *argv[]) {
     }
 
     bool save_data = false;
-    std::string filepath = "example_meii_robot_data_log.csv";
-
-    // create robot data log
-    // DataLogger robot_log(WriterType::Buffered, false);
-    std::vector<double> robot_log_row(16);
-    std::vector<std::vector<double>> robot_log;
-    std::vector<std::string> header = { "Time [s]", "MEII EFE Position [rad]", "MEII EFE Velocity [rad/s]", "MEII EFE Commanded Torque [Nm]",
-        "MEII FPS Position [rad]", "MEII FPS Velocity [rad/s]", "MEII FPS Commanded Torque [Nm]",
-        "MEII RPS L1 Position [m]", "MEII RPS L1 Velocity [m/s]", "MEII RPS L1 Commanded Force [N]",
-        "MEII RPS L2 Position [m]", "MEII RPS L2 Velocity [m/s]", "MEII RPS L2 Commanded Force [N]",
-        "MEII RPS L3 Position [m]", "MEII RPS L3 Velocity [m/s]", "MEII RPS L3 Commanded Force [N]" };
-    // robot_log.set_header(log_header);
-    // robot_log.set_record_format(DataFormat::Default, 12);
+    std::string filepath = "example_meii_robot_data_log.meiirec";
+
+    // create robot data log, recorded to disk by a background thread as the demo runs
+    // and exported to CSV with ex_session_to_csv
+    RecordSchema log_schema;
+    log_schema.add_field("Time [s]");
+    const std::vector<std::string> joint_names = { "EFE", "FPS", "RPS L1", "RPS L2", "RPS L3" };
+    const std::vector<std::string> joint_units = { "rad", "rad", "m", "m", "m" };
+    for (std::size_t i = 0; i < joint_names.size(); ++i) {
+        log_schema.add_field("MEII " + joint_names[i] + " Position [" + joint_units[i] + "]");
+        log_schema.add_field("MEII " + joint_names[i] + " Velocity [" + joint_units[i] + "/s]");
+        log_schema.add_field("MEII " + joint_names[i] + (i < 2 ? " Commanded Torque [Nm]" : " Commanded Force [N]"));
+    }
+    SessionRecorder robot_log(log_schema);
+    robot_log.open(filepath);
     
 
-    // make MelShares
+    // make MelShares, only touched by the runtime's worker thread
     MelShare ms_pos("ms_pos");
     MelShare ms_vel("ms_vel");
     MelShare ms_trq("ms_trq");
     MelShare ms_sp("ms_sp");
     MelShare ms_ref("ms_ref");
 
+    bool setpoint_demo = result.count("setpoint") > 0;
+    bool trajectory_demo = result.count("trajectory") > 0;
 
-    // setpoint control with MelScope
-    if (result.count("setpoint") > 0) {
-        LOG(Info) << "MAHI Exo-II Setpoint Control.";
+    if (setpoint_demo || trajectory_demo) {
+        LOG(Info) << (setpoint_demo ? "MAHI Exo-II Setpoint Control." : "MAHI Exo-II Trajectory Following.");
 
         // create initial setpoint and ranges
         std::vector<double> setpoint_deg = { -35, 0, 0, 0, 0.10 };
@@ -110,330 +113,188 @@ int main(int argc, char *argv[]) {
         for (size_t i = 0; i < meii->n_aj - 1; ++i) {
             setpoint_rad[i] = setpoint_deg[i] * DEG2RAD;
         }
-        std::vector<std::vector<double>> setpoint_rad_ranges = { { -90 * DEG2RAD, 0 * DEG2RAD },
-        { -90 * DEG2RAD, 90 * DEG2RAD },
-        { -15 * DEG2RAD, 15 * DEG2RAD },
-        { -15 * DEG2RAD, 15 * DEG2RAD },
-        { 0.08, 0.115 } };
-        ms_sp.write_data(setpoint_deg);
-        
+        setpoint_rad[4] = setpoint_deg[4];
+        MahiExoII::JointArray setpoint_rad_min = {{ -90 * DEG2RAD, -90 * DEG2RAD, -15 * DEG2RAD, -15 * DEG2RAD, 0.08 }};
+        MahiExoII::JointArray setpoint_rad_max = {{ 0 * DEG2RAD, 90 * DEG2RAD, 15 * DEG2RAD, 15 * DEG2RAD, 0.115 }};
+        if (setpoint_demo)
+            ms_sp.write_data(setpoint_deg);
+
         MahiExoII::SmoothReferenceTrajectory anat_ref_(meii->anat_joint_speed, setpoint_rad);
 
+        // linear trajectory from the pose at the end of RPS initialization to this waypoint, evaluated in
+        // place on the real-time thread since mahi::robo::Trajectory allocates its result
+        MahiExoII::JointArray final_waypoint = {{ -35 * DEG2RAD, 20 * DEG2RAD, 15 * DEG2RAD, 0, 0.09 }};
+        MahiExoII::JointArray initial_waypoint = {};
+        Time traj_duration = seconds(5);
+        Time traj_start_time = Time::Zero;
+
         // set up state machine
         std::size_t state = 0;
         Time backdrive_time = seconds(3);
 
-        // create data containers
-        std::vector<double> rj_positions(meii->n_rj);
-        std::vector<double> rj_velocities(meii->n_rj);
+        // create data containers, sized once so the control callback does not allocate
+        MahiExoII::JointArray command_torques = {};
+        MahiExoII::JointArray ref = {};
+        MahiExoII::JointArray new_setpoint;
+        MahiExoII::JointArray sent_setpoint = {};
         std::vector<double> aj_positions(meii->n_aj);
         std::vector<double> aj_velocities(meii->n_aj);
-        std::vector<double> command_torques(meii->n_aj, 0.0);
-        std::vector<double> rps_command_torques(meii->n_qs, 0.0);
-
-        // enable DAQ and exo
-        meii->daq_enable();
-        meii->enable();
+        std::vector<double> trq(meii->n_aj);
+        std::vector<double> ref_out(meii->n_aj);
 
-        // construct timer in hybrid mode to avoid using 100% CPU
-        Timer timer(milliseconds(1), Timer::Hybrid);
+        // setpoints read from MelShare by the worker, and references sent back for MelScope
+        SpscQueue<MahiExoII::JointArray> setpoints(16);
+        SpscQueue<MahiExoII::JointArray> refs(1024);
 
-        // start loop
-        LOG(Info) << "Robot Backdrivable.";
-        meii->daq_watchdog_start();
-        while (!stop) {
-
-            // update all DAQ input channels
-            meii->daq_read_all();
-
-            // update MahiExoII kinematics
-            meii->update_kinematics();
-
-            // store most recent readings from DAQ
-            for (int i = 0; i < meii->n_rj; ++i) {
-                rj_positions[i] = meii->get_robot_joint_position(i);
-                rj_velocities[i] = meii->get_robot_joint_velocity(i);
-            }
-            for (int i = 0; i < meii->n_aj; ++i) {
-                aj_positions[i] = meii->get_anatomical_joint_position(i);
-                aj_velocities[i] = meii->get_anatomical_joint_velocity(i);
-            }
+        MeiiRuntime runtime(*meii, milliseconds(1));
+        runtime.set_watchdog(true);
+        runtime.set_keyboard(true);
 
+        runtime.set_control([&](MahiExoII& exo, Time t) {
             switch (state) {
             case 0: // backdrive
 
+                // update ref, though not being used
+                exo.get_anatomical_joint_positions(ref);
+
                 // command zero torque
-                meii->set_robot_raw_joint_torques(command_torques);
+                exo.set_robot_raw_joint_torques_array(command_torques);
 
                 // check for wait period to end
-                if (timer.get_elapsed_time() >= backdrive_time) {
-                    meii->rps_init_par_ref_.start(meii->get_wrist_parallel_positions(), timer.get_elapsed_time());
+                if (t >= backdrive_time) {
+                    exo.rps_init_par_ref_.start(exo.get_wrist_parallel_positions(), t);
                     state = 1;
-                    LOG(Info) << "Initializing RPS Mechanism.";
+                    runtime.post_message(Info, "Initializing RPS Mechanism.");
                 }
                 break;
 
-            case 1: // initialize rps                
+            case 1: // initialize rps
+
+                // update ref, though not being used
+                exo.get_anatomical_joint_positions(ref);
 
                 // calculate commanded torques
-                rps_command_torques = meii->set_robot_smooth_pos_ctrl_torques(meii->rps_init_par_ref_, timer.get_elapsed_time());
-                std::copy(rps_command_torques.begin(), rps_command_torques.end(), command_torques.begin() + 2);
+                exo.set_robot_smooth_pos_ctrl_torques(exo.rps_init_par_ref_, t, command_torques);
 
                 // check for RPS Initialization target reached
-                if (meii->check_rps_init()) {
-                    LOG(Info) << "RPS initialization complete.";
-                    anat_ref_.start(setpoint_rad, meii->get_anatomical_joint_positions(), timer.get_elapsed_time());
+                if (exo.check_rps_init()) {
+                    runtime.post_message(Info, "RPS initialization complete.");
                     state = 2;
+                    if (setpoint_demo) {
+                        anat_ref_.start(setpoint_rad, exo.get_anatomical_joint_positions(), t);
+                    }
+                    else {
+                        exo.get_anatomical_joint_positions(initial_waypoint);
+                        traj_start_time = t;
+                    }
                 }
                 break;
 
-            case 2: // setpoint control
-
-                // read in setpoint from MelShare
-                setpoint_deg = ms_sp.read_data();
-                for (std::size_t i = 0; i < 4; ++i) {
-                    setpoint_rad[i] = setpoint_deg[i] * DEG2RAD;
+            case 2:
+                if (setpoint_demo) {
+                    // take the latest setpoint from MelShare, saturated to its range
+                    bool changed = false;
+                    while (setpoints.pop(new_setpoint))
+                        changed = true;
+                    if (changed) {
+                        for (std::size_t i = 0; i < exo.n_aj; ++i) {
+                            setpoint_rad[i] = clamp(new_setpoint[i], setpoint_rad_min[i], setpoint_rad_max[i]);
+                        }
+                        anat_ref_.set_ref(setpoint_rad, t);
+                    }
+
+                    // calculate commanded torques
+                    exo.set_anat_smooth_pos_ctrl_torques(anat_ref_, t, command_torques);
                 }
-                setpoint_rad[4] = setpoint_deg[4];
-
-                // update and saturate setpoint
-                for (int i = 0; i < meii->n_aj; ++i) {
-                    setpoint_rad[i] = clamp(setpoint_rad[i], setpoint_rad_ranges[i][0], setpoint_rad_ranges[i][1]);
+                else {
+                    // update reference from trajectory, constrained to be within range
+                    double s = std::min(1.0, (t - traj_start_time).as_seconds() / traj_duration.as_seconds());
+                    for (std::size_t i = 0; i < exo.n_aj; ++i) {
+                        ref[i] = clamp(initial_waypoint[i] + s * (final_waypoint[i] - initial_waypoint[i]), setpoint_rad_min[i], setpoint_rad_max[i]);
+                    }
+
+                    // calculate and set anatomical command torques
+                    exo.set_anat_pos_ctrl_torques(ref, command_torques);
                 }
-                anat_ref_.set_ref(setpoint_rad, timer.get_elapsed_time());
-
-                // calculate commanded torques
-                command_torques = meii->set_anat_smooth_pos_ctrl_torques(anat_ref_, timer.get_elapsed_time());
-
                 break;
             }
-
-            // write to MelShares
-            ms_pos.write_data(aj_positions);
-            ms_vel.write_data(aj_velocities);
-            ms_trq.write_data(command_torques);
-
-            // update all DAQ output channels
-            meii->daq_write_all();
+            if (trajectory_demo)
+                refs.push(ref);
 
             // write to robot data log
-            robot_log_row[0] = timer.get_elapsed_time().as_seconds();
-            for (std::size_t i = 0; i < meii->n_rj; ++i) {
-                robot_log_row[3 * i + 1] = meii->get_robot_joint_position(i);
-                robot_log_row[3 * i + 2] = meii->get_robot_joint_velocity(i);
-                robot_log_row[3 * i + 3] = meii->get_robot_joint_command_torque(i);
+            robot_log.set(0, t.as_seconds());
+            for (std::size_t i = 0; i < exo.n_rj; ++i) {
+                robot_log.set(3 * i + 1, exo.get_robot_joint_position(i));
+                robot_log.set(3 * i + 2, exo.get_robot_joint_velocity(i));
+                robot_log.set(3 * i + 3, exo.get_robot_joint_command_torque(i));
             }
-            robot_log.push_back(robot_log_row);
+            robot_log.commit();
 
-            // check for save key
             // check for stop key
-            int key_press = -1;
-            key_press = get_key_nb();
-            if (key_press == 13) {
-                print("here");
-                stop = true;
+            int key;
+            while (runtime.poll_key(key)) {
+                if (key == 13)
+                    return false;
             }
 
-            // kick watchdog
-            if (!meii->daq_watchdog_kick() || meii->any_limit_exceeded()){
-                stop = true;
-            }
-                
-
-            // wait for remainder of sample period
-            timer.wait();
-
-        }
-    } // end setpoitn control with MelScop
-
-
-    // trajectory following
-    if (result.count("trajectory") > 0) {
-        LOG(Info) << "MAHI Exo-II Trajectory Following.";
-
-        // create ranges
-        std::vector<std::vector<double>> setpoint_rad_ranges = { { -90 * DEG2RAD, 0 * DEG2RAD },
-        { -90 * DEG2RAD, 90 * DEG2RAD },
-        { -15 * DEG2RAD, 15 * DEG2RAD },
-        { -15 * DEG2RAD, 15 * DEG2RAD },
-        { 0.08, 0.115 } };
-
-        // create discrete trajectory at with certain max velocities
-        std::vector<double> traj_max_diff = { 10 * DEG2RAD, 10 * DEG2RAD, 5 * DEG2RAD, 5 * DEG2RAD, 0.01 };
-        //Trajectory::Point initial_waypoint(seconds(0), { -35 * DEG2RAD, 0, 0, 0, 0.10 });
-        //Trajectory::Point final_waypoint(seconds(3), { -5 * DEG2RAD, 0, 0, 0, 0.10 });
-        WayPoint initial_waypoint;
-        WayPoint final_waypoint(seconds(5), { -35 * DEG2RAD, 20 * DEG2RAD, 15 * DEG2RAD, 0, 0.09 });
-        std::vector<WayPoint> waypoints(2);
-        waypoints[1] = final_waypoint;
-        //waypoints.push_back(initial_waypoint);
-        //waypoints.push_back(final_waypoint);
-        //Trajectory ref_traj(MahiExoII::n_aj, waypoints, Trajectory::Linear, traj_max_diff);
-        Trajectory ref_traj;
-
-        // construct for trajectory
-        Clock ref_traj_clock;
-
-        // set up state machine
-        std::size_t state = 0;
-        Time backdrive_time = seconds(3);
-
-        // create data containers
-        std::vector<double> rj_positions(meii->n_rj);
-        std::vector<double> rj_velocities(meii->n_rj);
-        std::vector<double> aj_positions(meii->n_aj);
-        std::vector<double> aj_velocities(meii->n_aj);
-        std::vector<double> command_torques(meii->n_aj, 0.0);
-        std::vector<double> rps_command_torques(meii->n_qs, 0.0);
-        std::vector<double> ref(meii->n_aj, 0.0);
-
-        // enable DAQ and exo
-        meii->daq_enable();
-        meii->enable();
-
-        // construct timer in hybrid mode to avoid using 100% CPU
-        Timer timer(milliseconds(1), Timer::Hybrid);
-
-        // start loop
-        LOG(Info) << "Robot Backdrivable.";
-        meii->daq_watchdog_start();
-        while (!stop) {
-
-            // update all DAQ input channels
-            meii->daq_read_all();
-
-            // update MahiExoII kinematics
-            meii->update_kinematics();
-
-            // store most recent readings from DAQ
-            for (int i = 0; i < meii->n_rj; ++i) {
-                rj_positions[i] = meii->get_robot_joint_position(i);
-                rj_velocities[i] = meii->get_robot_joint_velocity(i);
-            }
-            for (int i = 0; i < meii->n_aj; ++i) {
-                aj_positions[i] = meii->get_anatomical_joint_position(i);
-                aj_velocities[i] = meii->get_anatomical_joint_velocity(i);
-            }
-
-            switch (state) {
-            case 0: // backdrive
-
-                // update ref, though not being used
-                ref = meii->get_anatomical_joint_positions();
-
-                // command zero torque
-                meii->set_robot_raw_joint_torques(command_torques);
-
-                // check for wait period to end
-                if (timer.get_elapsed_time() >= backdrive_time) {
-                    meii->rps_init_par_ref_.start(meii->get_wrist_parallel_positions(), timer.get_elapsed_time());
-                    state = 1;
-                    LOG(Info) << "Initializing RPS Mechanism.";
-                }
-                break;
-
-            case 1: // initialize rps                
-
-                // update ref, though not being used
-                ref = meii->get_anatomical_joint_positions();
-
-                // calculate commanded torques
-                rps_command_torques = meii->set_robot_smooth_pos_ctrl_torques(meii->rps_init_par_ref_, timer.get_elapsed_time());
-                std::copy(rps_command_torques.begin(), rps_command_torques.end(), command_torques.begin() + 2);
-
-                // check for RPS Initialization target reached
-                if (meii->check_rps_init()) {
-                    LOG(Info) << "RPS initialization complete.";
-                    //anat_ref_.start(setpoint_rad, meii->get_anatomical_joint_positions(), timer.get_elapsed_time());
-                    state = 2;
-                    // command_torques = std::vector<double>(meii->n_aj, 0.0);
-                    meii->set_anatomical_raw_joint_torques(command_torques);
-                    initial_waypoint = WayPoint(seconds(0.0), aj_positions);
-                    waypoints[0] = initial_waypoint;
-                    ref_traj.set_waypoints(meii->n_aj, waypoints, Trajectory::Interp::Linear, traj_max_diff);
-                    ref_traj_clock.restart();
-                }
-                break;
-
-            case 2: // trajectory following
-
-                // update reference from trajectory
-                ref = ref_traj.at_time(ref_traj_clock.get_elapsed_time());
-
-                // constraint trajectory to be within range
-                for (int i = 0; i < meii->n_aj; ++i) {
-                    ref[i] = clamp(ref[i], setpoint_rad_ranges[i][0], setpoint_rad_ranges[i][1]);
-                }
-
-                // calculate anatomical command torques
-                command_torques[0] = meii->anatomical_joint_pd_controllers_[0].calculate(ref[0], meii->get_anatomical_joint_position(0), 0, meii->get_anatomical_joint_velocity(0));
-                command_torques[1] = meii->anatomical_joint_pd_controllers_[1].calculate(ref[1], meii->get_anatomical_joint_position(1), 0, meii->get_anatomical_joint_velocity(1));
-                // command_torques[0] = 0;
-                // command_torques[1] = 0;
-                for (int i = 0; i < meii->n_qs; ++i) {
-                    rps_command_torques[i] = meii->anatomical_joint_pd_controllers_[i + 2].calculate(ref[i + 2], meii->get_anatomical_joint_position(i + 2), 0, meii->get_anatomical_joint_velocity(i + 2));
-                    // rps_command_torques[i] = 0;
-                }
-
-                std::copy(rps_command_torques.begin(), rps_command_torques.end(), command_torques.begin() + 2);
-                
-
-                // set anatomical command torques
-                meii->set_anatomical_raw_joint_torques(command_torques);
-                
-
-                break;
-            }
+            // velocity and torque limits, the safety monitor logs the details
+            return !exo.any_limit_exceeded();
+        });
 
+        runtime.set_telemetry([&](const MeiiStateFrame& frame) {
             // write to MelShares
+            std::copy(frame.anatomical_positions.begin(), frame.anatomical_positions.end(), aj_positions.begin());
+            std::copy(frame.anatomical_velocities.begin(), frame.anatomical_velocities.end(), aj_velocities.begin());
+            std::copy(frame.anatomical_torques.begin(), frame.anatomical_torques.end(), trq.begin());
             ms_pos.write_data(aj_positions);
             ms_vel.write_data(aj_velocities);
-            ms_trq.write_data(command_torques);
-            ms_ref.write_data(ref);
-
-            // kick watchdog
-            if (!meii->daq_watchdog_kick() || meii->any_limit_exceeded()){
-                stop = true;
+            ms_trq.write_data(trq);
+            MahiExoII::JointArray ref_frame;
+            if (refs.pop(ref_frame)) {
+                std::copy(ref_frame.begin(), ref_frame.end(), ref_out.begin());
+                ms_ref.write_data(ref_out);
             }
 
-            // update all DAQ output channels
-            if (!stop) meii->daq_write_all();
-
-            // write to robot data log
-            robot_log_row[0] = timer.get_elapsed_time().as_seconds();
-            for (std::size_t i = 0; i < meii->n_rj; ++i) {
-                robot_log_row[3 * i + 1] = meii->get_robot_joint_position(i);
-                robot_log_row[3 * i + 2] = meii->get_robot_joint_velocity(i);
-                robot_log_row[3 * i + 3] = meii->get_robot_joint_command_torque(i);
-            }
-            robot_log.push_back(robot_log_row);
-
-            // check for stop key
-            int key_press = -1;
-            key_press = get_key_nb();
-            if (key_press == 13) {
-                stop = true;
+            // read in setpoint from MelShare, passed on only when it changes
+            if (setpoint_demo) {
+                setpoint_deg = ms_sp.read_data();
+                if (setpoint_deg.size() == meii->n_aj) {
+                    MahiExoII::JointArray sp;
+                    for (std::size_t i = 0; i < 4; ++i) {
+                        sp[i] = setpoint_deg[i] * DEG2RAD;
+                    }
+                    sp[4] = setpoint_deg[4];
+                    if (sp != sent_setpoint && setpoints.push(sp))
+                        sent_setpoint = sp;
+                }
             }
+        });
 
-            // wait for remainder of sample period
-            timer.wait();
+        // enable DAQ and exo
+        meii->daq_enable();
+        meii->enable();
 
-        }
+        // start loop
+        LOG(Info) << "Robot Backdrivable.";
+        runtime.run(stop);
         meii->disable();
         meii->daq_disable();
+
+        RuntimeStats stats = runtime.get_stats();
+        LOG(Info) << "Ran " << stats.ticks << " ticks with " << stats.overruns << " overruns.";
     }
     
     disable_realtime();
 
-    mahi::util::print("Do you want to save the robot data log? (Y/N)");
+    mahi::util::print("Do you want to keep the robot data log? (Y/N)");
     int key_pressed = 0;
     while (key_pressed != 'y' && key_pressed != 'n'){
         key_pressed = get_key();
     }
 
-    if (key_pressed == 'y'){
-        csv_write_row(filepath, header);
-        csv_append_rows("example_meii_robot_data_log.csv", robot_log);
+    robot_log.close();
+    if (key_pressed == 'n'){
+        std::remove(filepath.c_str());
     } 
 
     while (get_key_nb() != 0);
@@ -0,0 +1,135 @@
+#include <MEII/MahiExoII/MahiExoII.hpp>
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+
+using namespace mahi::util;
+using namespace meii;
+
+// count every heap allocation made by the process so we can report allocations per tick
+static std::atomic<std::size_t> g_allocations(0);
+
+#ifdef __GLIBC__
+// Eigen allocates dynamic-size storage with malloc directly, so interpose malloc itself
+extern "C" void* __libc_malloc(std::size_t size);
+extern "C" void* malloc(std::size_t size) {
+    ++g_allocations;
+    return __libc_malloc(size);
+}
+#else
+// elsewhere we can only see allocations that go through operator new
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+#endif
+
+/// Joint whose state lives in memory, so the tick below measures MahiExoII and not a DAQ or MelShare
+class MemoryJoint : public Joint {
+public:
+    MemoryJoint(const std::string& name, double position) :
+        Joint(name, { -1e3, 1e3 }, 1e3, 1e3, mahi::robo::Limiter()),
+        position_(position)
+    { }
+    double get_position() override { return position_; }
+    double get_velocity() override { return velocity_; }
+    void set_torque(double new_torque) override { m_com_torque = new_torque; m_torque = new_torque; }
+    bool enable() override { m_enabled = true; return true; }
+    bool disable() override { m_enabled = false; return true; }
+    void filter_velocity() override { }
+
+    double position_; // position reported to MahiExoII [rad] or [m]
+    double velocity_ = 0; // velocity reported to MahiExoII [rad/s] or [m/s]
+};
+
+/// MahiExoII on MemoryJoints with no DAQ behind it
+class MahiExoIIMemory : public MahiExoII {
+public:
+    MahiExoIIMemory() {
+        const double rest[n_rj] = { -35 * DEG2RAD, 0.0, 0.1, 0.1, 0.1 };
+        for (std::size_t i = 0; i < n_rj; ++i) {
+            joints[i] = std::make_shared<MemoryJoint>("meii_joint_" + std::to_string(i + 1), rest[i]);
+            meii_joints.push_back(joints[i]);
+        }
+    }
+    bool daq_enable() override { return true; }
+    bool daq_disable() override { return true; }
+    bool daq_open() override { return true; }
+    bool daq_close() override { return true; }
+    bool daq_watchdog_start() override { return true; }
+    bool daq_watchdog_kick() override { return true; }
+    bool daq_read_all() override { return true; }
+    bool daq_write_all() override { return true; }
+    bool daq_encoder_write(int index, int32 encoder_offset) override { return true; }
+
+    std::array<std::shared_ptr<MemoryJoint>, n_rj> joints; // the joints, for moving them between ticks
+};
+
+int main(int argc, char* argv[]) {
+
+    Options options("ex_meii_alloc_free_tick.exe", "Counts heap allocations in a MahiExoII control tick using the vector and the fixed-size array APIs");
+    options.add_options()
+        ("n,ticks", "Number of control ticks to run with each API", value<int>()->default_value("10000"))
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    const std::size_t n_ticks = result["ticks"].as<int>();
+
+    MahiExoIIMemory meii;
+    meii.enable();
+
+    // wiggle the links a little every tick so the kinematics are solved rather than read from the cache
+    auto move = [&](std::size_t tick) {
+        for (std::size_t i = 2; i < MahiExoII::n_rj; ++i) {
+            meii.joints[i]->position_ = 0.1 + 0.002 * std::sin(0.01 * tick + i);
+            meii.joints[i]->velocity_ = 0.002 * 0.01 * std::cos(0.01 * tick + i);
+        }
+    };
+
+    // vector API
+    std::vector<double> ref = { -35 * DEG2RAD, 0.0, 0.0, 0.0, 0.1 };
+    std::vector<double> positions, command_torques;
+    std::size_t allocations = g_allocations;
+    for (std::size_t tick = 0; tick < n_ticks; ++tick) {
+        move(tick);
+        meii.update_kinematics();
+        positions = meii.get_anatomical_joint_positions();
+        command_torques = meii.set_anat_pos_ctrl_torques(ref);
+    }
+    double vector_allocs = (double)(g_allocations - allocations) / n_ticks;
+
+    // array API, with every buffer owned by the caller
+    MahiExoII::JointArray ref_array = {{ -35 * DEG2RAD, 0.0, 0.0, 0.0, 0.1 }};
+    MahiExoII::JointArray position_array, velocity_array, torque_array;
+    MahiExoII::WristArray wrist_array;
+    allocations = g_allocations;
+    for (std::size_t tick = 0; tick < n_ticks; ++tick) {
+        move(tick);
+        meii.update_kinematics();
+        meii.get_anatomical_joint_positions(position_array);
+        meii.get_anatomical_joint_velocities(velocity_array);
+        meii.get_wrist_parallel_positions(wrist_array);
+        meii.set_anat_pos_ctrl_torques(ref_array, torque_array);
+    }
+    double array_allocs = (double)(g_allocations - allocations) / n_ticks;
+
+    meii.disable();
+
+    print("vector API: {:.2f} allocations/tick", vector_allocs);
+    print("array API:  {:.2f} allocations/tick", array_allocs);
+
+    return array_allocs == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include <MEII/MahiExoII/CosimLink.hpp>
+#include <MEII/MahiExoII/MeiiPlant.hpp>
+#include <Mahi/Util.hpp>
+
+using namespace mahi::util;
+using namespace meii;
+
+// create global stop variable CTRL-C handler function
+ctrl_bool stop(false);
+bool handler(CtrlEvent event) {
+    stop = true;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    // register ctrl-c handler
+    register_ctrl_handler(handler);
+
+    Options options("ex_meii_cosim_plant.exe", "Serves the simulated MAHI Exo-II plant to a controller in another process through the co-simulation protocol");
+    options.add_options()
+        ("n,name", "Name of the co-simulation shared memory", value<std::string>()->default_value("meii_cosim"))
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    // the same starting positions as the default MeiiConfigurationVirtual
+    std::array<double, MeiiPlant::n_joints> rest_positions = {{ -45 * DEG2RAD, 0, 0.0952, 0.0952, 0.0952 }};
+    MeiiPlant plant(MeiiPlantParameters(), MeiiParameters(), rest_positions);
+    CosimSimulator simulator(result["name"].as<std::string>());
+
+    std::array<double, MeiiPlant::n_joints> torque, position, velocity;
+    auto publish = [&]() {
+        for (std::size_t i = 0; i < MeiiPlant::n_joints; ++i) {
+            position[i] = plant.get_position(i);
+            velocity[i] = plant.get_velocity(i);
+        }
+        simulator.publish(plant.get_time().as_seconds(), position, velocity);
+    };
+
+    LOG(Info) << "Waiting for a controller on " << result["name"].as<std::string>() << ".";
+    publish();
+    uint64 steps = 0;
+    double dt;
+    while (!stop) {
+        // keep waiting while no controller is connected
+        if (!simulator.wait_command(torque, dt))
+            continue;
+        for (std::size_t i = 0; i < MeiiPlant::n_joints; ++i)
+            plant.set_torque(i, torque[i]);
+        plant.step(microseconds(static_cast<int64>(dt * 1e6)));
+        publish();
+        steps++;
+    }
+    print("steps simulated: {}", steps);
+    print("simulated time:  {} s", plant.get_time().as_seconds());
+
+    return 0;
+}
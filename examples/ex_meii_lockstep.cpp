@@ -0,0 +1,106 @@
+#include <MEII/MEII.hpp>
+#include <Mahi/Util.hpp>
+#include <vector>
+
+using namespace mahi::util;
+using namespace meii;
+
+// create global stop variable CTRL-C handler function
+ctrl_bool stop(false);
+bool handler(CtrlEvent event) {
+    stop = true;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    // register ctrl-c handler
+    register_ctrl_handler(handler);
+
+    Options options("ex_meii_lockstep.exe", "Runs a setpoint protocol on the simulated MAHI Exo-II in lockstep, faster than real time");
+    options.add_options()
+        ("n,cycles", "Number of times to run through the setpoints", value<int>()->default_value("10"))
+        ("r,realtime", "Paces the loop in real time instead of lockstep, for comparison")
+        ("c,cosim", "Co-simulates with an external simulator, such as ex_meii_cosim_plant, instead of the in-process plant")
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    MeiiConfigurationVirtual config_vr = result.count("cosim") > 0 ? MeiiConfigurationVirtual("meii_cosim", milliseconds(1))
+                                                                   : MeiiConfigurationVirtual(VirtualPlant::Headless);
+    MahiExoIIVirtual meii(config_vr);
+
+    // setpoints of the protocol, each approached at anat_joint_speed and then held
+    std::vector<std::vector<double>> setpoints = { { -35 * DEG2RAD,  0 * DEG2RAD,  0 * DEG2RAD, 0 * DEG2RAD, 0.09 },
+                                                   { -60 * DEG2RAD, 30 * DEG2RAD, 10 * DEG2RAD, 0 * DEG2RAD, 0.10 },
+                                                   { -20 * DEG2RAD,-30 * DEG2RAD,  0 * DEG2RAD, 10 * DEG2RAD, 0.09 } };
+    Time setpoint_time = seconds(4); // time to approach and hold each setpoint
+    int cycles = result["cycles"].as<int>();
+
+    LoopClock clock(milliseconds(1), result.count("realtime") > 0 ? LoopClock::RealTime : LoopClock::Lockstep);
+    meii.set_loop_clock(&clock);
+
+    MahiExoII::JointArray ref, command_torques;
+    std::vector<double> max_error(MahiExoII::n_aj, 0.0);
+    std::size_t setpoint = 0;
+    int cycle = 0;
+    Time setpoint_start = Time::Zero;
+    Clock wall_clock;
+
+    meii.enable();
+    Time t = Time::Zero;
+    while (!stop && cycle < cycles) {
+        if (!meii.daq_read_all()) {
+            LOG(Error) << "Lost the simulation at " << t << ", stopping.";
+            break;
+        }
+        meii.update_kinematics();
+
+        if (t == Time::Zero) {
+            for (std::size_t i = 0; i < MahiExoII::n_aj; ++i)
+                ref[i] = meii.get_anatomical_joint_position(i);
+        }
+
+        // move on to the next setpoint once this one has had its time
+        if (t - setpoint_start >= setpoint_time) {
+            for (std::size_t i = 0; i < MahiExoII::n_aj; ++i)
+                max_error[i] = std::max(max_error[i], std::abs(meii.get_anatomical_joint_position(i) - setpoints[setpoint][i]));
+            if (++setpoint == setpoints.size()) {
+                setpoint = 0;
+                cycle++;
+            }
+            setpoint_start = t;
+        }
+
+        // move the reference toward the setpoint no faster than anat_joint_speed
+        double dt = clock.get_period().as_seconds();
+        for (std::size_t i = 0; i < MahiExoII::n_aj; ++i) {
+            double step = meii.anat_joint_speed[i] * dt;
+            ref[i] += std::max(-step, std::min(step, setpoints[setpoint][i] - ref[i]));
+        }
+
+        meii.set_anat_pos_ctrl_torques(ref, command_torques);
+        if (meii.check_limits() != 0) {
+            LOG(Error) << "Joint limit exceeded at " << t << ", stopping.";
+            stop = true;
+        }
+        meii.daq_write_all();
+        t = clock.wait();
+    }
+    meii.disable();
+    meii.set_loop_clock(nullptr);
+
+    Time wall_time = wall_clock.get_elapsed_time();
+    print("simulated time:  {} s", t.as_seconds());
+    print("wall time:       {} s", wall_time.as_seconds());
+    print("speed:           {}x real time", t.as_seconds() / std::max(wall_time.as_seconds(), 1e-6));
+    print("max error at the end of each setpoint [rad] or [m]:");
+    print_var(max_error);
+
+    return 0;
+}
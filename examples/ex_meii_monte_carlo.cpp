@@ -0,0 +1,97 @@
+#include <MEII/MEII.hpp>
+#include <Mahi/Util.hpp>
+#include <thread>
+#include <vector>
+
+using namespace mahi::util;
+using namespace meii;
+
+int main(int argc, char* argv[]) {
+
+    Options options("ex_meii_monte_carlo.exe", "Runs a setpoint protocol on many simulated MAHI Exo-IIs with varied dynamics, sensor noise and parameters, across every core");
+    options.add_options()
+        ("n,sessions", "Number of simulated sessions", value<int>()->default_value("200"))
+        ("t,threads", "Number of worker threads, 0 for one per core", value<int>()->default_value("0"))
+        ("s,seed", "Seed the sessions are drawn from", value<int>()->default_value("0"))
+        ("c,scaling", "Runs the sweep on 1, 2, 4, ... threads up to one per core and prints the speedup of each")
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    // the plant has some coulomb friction to vary, and every session gets an encoder's worth of noise
+    MeiiPlantParameters plant_params;
+    plant_params.friction_ = {{ 0.05, 0.01, 1.0, 1.0, 1.0 }};
+
+    SweepVariation variation;
+    variation.inertia_spread = 0.3;
+    variation.damping_spread = 0.5;
+    variation.friction_spread = 0.5;
+    variation.position_noise = {{ 1e-4, 1e-4, 1e-5, 1e-5, 1e-5 }};
+    variation.velocity_noise = {{ 5e-3, 5e-3, 5e-4, 5e-4, 5e-4 }};
+    // motors that run hotter or cooler than their datasheet
+    variation.vary_parameters = [](std::mt19937_64& rng, MeiiParameters& params) {
+        std::uniform_real_distribution<double> scale(0.8, 1.2);
+        for (std::size_t i = 0; i < params.motor_cont_limits_.size(); ++i)
+            params.motor_cont_limits_[i] *= scale(rng);
+    };
+
+    // setpoints of the protocol, each approached at anat_joint_speed and then held
+    std::vector<std::vector<double>> setpoints = { { -35 * DEG2RAD,  0 * DEG2RAD,  0 * DEG2RAD, 0 * DEG2RAD, 0.09 },
+                                                   { -60 * DEG2RAD, 30 * DEG2RAD, 10 * DEG2RAD, 0 * DEG2RAD, 0.10 },
+                                                   { -20 * DEG2RAD,-30 * DEG2RAD,  0 * DEG2RAD, 10 * DEG2RAD, 0.09 } };
+    Time setpoint_time = seconds(4); // time to approach and hold each setpoint
+
+    Time period = milliseconds(1);
+
+    // every session gets its own reference, moved toward the setpoint no faster than anat_joint_speed
+    MonteCarloSweep::ProtocolFactory make_protocol = [&]() -> MonteCarloSweep::Protocol {
+        MahiExoII::JointArray reference, command_torques;
+        return [&, reference, command_torques](MahiExoII& meii, Time t, MahiExoII::JointArray& ref) mutable {
+            std::size_t setpoint = static_cast<std::size_t>(t.as_microseconds() / setpoint_time.as_microseconds());
+            if (setpoint == setpoints.size())
+                return false;
+            if (t == Time::Zero)
+                meii.get_anatomical_joint_positions(reference);
+            for (std::size_t i = 0; i < MahiExoII::n_aj; ++i) {
+                double step = meii.anat_joint_speed[i] * period.as_seconds();
+                reference[i] += std::max(-step, std::min(step, setpoints[setpoint][i] - reference[i]));
+            }
+            meii.set_anat_pos_ctrl_torques(reference, command_torques);
+            ref = reference;
+            return true;
+        };
+    };
+
+    MonteCarloSweep sweep(result["sessions"].as<int>(), period);
+    sweep.set_plant_parameters(plant_params);
+    sweep.set_variation(variation);
+    sweep.set_seed(result["seed"].as<int>());
+
+    if (result.count("scaling") > 0) {
+        std::size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+        double base = 0.0;
+        for (std::size_t threads = 1; ; threads = std::min(threads * 2, cores)) {
+            sweep.set_threads(threads);
+            sweep.run(make_protocol);
+            double rate = sweep.get_summary().sessions / std::max(sweep.get_summary().wall_time.as_seconds(), 1e-6);
+            if (threads == 1)
+                base = rate;
+            print("{} threads: {} sessions/s, {}x the rate of 1 thread", threads, rate, rate / base);
+            if (threads == cores)
+                break;
+        }
+    }
+    else {
+        sweep.set_threads(result["threads"].as<int>());
+        sweep.run(make_protocol);
+    }
+
+    print("{}", sweep.report());
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <MEII/MEII.hpp>
+#include <Mahi/Com.hpp>
+#include <Mahi/Util.hpp>
+#include <Mahi/Daq.hpp>
+#include <Mahi/Robo.hpp>
+#include <vector>
+
+using namespace mahi::util;
+using namespace mahi::daq;
+using namespace mahi::robo;
+using namespace mahi::com;
+using namespace meii;
+
+// create global stop variable CTRL-C handler function
+ctrl_bool stop(false);
+bool handler(CtrlEvent event) {
+    stop = true;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    // register ctrl-c handler
+    register_ctrl_handler(handler);
+
+    Options options("ex_meii_runtime.exe", "Holds the MAHI Exo-II at its neutral position with the control loop on its own real-time thread");
+    options.add_options()
+        ("v,virtual", "Runs the virtual exo instead of the hardware")
+        ("s,sim", "Simulates the virtual exo in process instead of reading it from MelShare")
+        ("l,lockstep", "Steps the loop in lockstep as fast as possible instead of in real time, with --sim")
+        ("c,cpu", "Core to pin the real-time thread to, -1 to leave it to the OS", value<int>()->default_value("-1"))
+        ("t,trace", "Seconds of the control loop to write to meii_trace.json on exit, for chrome://tracing or ui.perfetto.dev", value<int>()->default_value("0"))
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    std::shared_ptr<MahiExoII> meii = nullptr;
+    std::shared_ptr<QPid> daq = nullptr;
+
+    if (result.count("virtual") > 0) {
+        MeiiConfigurationVirtual config_vr(result.count("sim") > 0 ? VirtualPlant::Headless : VirtualPlant::MelShare);
+        meii = std::make_shared<MahiExoIIVirtual>(config_vr);
+    }
+    else {
+        daq = std::make_shared<QPid>();
+        daq->open();
+
+        MeiiConfigurationHardware<QPid> config_hw(*daq, VelocityEstimator::Software);
+
+        std::vector<TTL> idle_values(8, TTL_HIGH);
+        daq->DO.enable_values.set({0,1,2,3,4,5,6,7}, idle_values);
+        daq->DO.disable_values.set({0,1,2,3,4,5,6,7}, idle_values);
+        daq->DO.expire_values.write({0,1,2,3,4,5,6,7}, idle_values);
+
+        meii = std::make_shared<MahiExoIIHardware<QPid>>(config_hw);
+    }
+
+    // everything below the control callback runs on the worker thread, so MelShare and
+    // console output never delay a tick
+    MelShare ms_pos("ms_pos");
+    MelShare ms_vel("ms_vel");
+    MelShare ms_trq("ms_trq");
+    std::vector<double> pos(MahiExoII::n_aj), vel(MahiExoII::n_aj), trq(MahiExoII::n_aj);
+
+    // every tick records about 20 spans, so hold 32 per tick
+    int trace_seconds = result["trace"].as<int>();
+    if (trace_seconds > 0) {
+        meii->get_profiler().get_trace().allocate(trace_seconds * 1000 * 32);
+        meii->get_profiler().get_trace().set_enabled(true);
+    }
+
+    MeiiRuntime runtime(*meii, milliseconds(1));
+    runtime.set_rt_cpu(result["cpu"].as<int>());
+    runtime.set_watchdog(result.count("virtual") == 0);
+    runtime.set_keyboard(true);
+    if (result.count("lockstep") > 0)
+        runtime.set_clock_mode(LoopClock::Lockstep);
+
+    // hold the neutral position until 'q' is pressed or any limit is exceeded
+    MahiExoII::JointArray ref = {{ -35 * DEG2RAD, 0.0, 0.0, 0.0, 0.1 }};
+    MahiExoII::JointArray command_torques;
+    runtime.set_control([&](MahiExoII& exo, Time t) {
+        int key;
+        while (runtime.poll_key(key)) {
+            if (key == 'q') {
+                runtime.post_message(Info, "'q' pressed, stopping.");
+                return false;
+            }
+        }
+        exo.set_anat_pos_ctrl_torques(ref, command_torques);
+        // position, velocity, torque and I^2t limits of every joint, the safety monitor logs the details
+        if (exo.check_limits() != 0) {
+            runtime.post_message(Error, "Joint limit exceeded, stopping.");
+            return false;
+        }
+        return true;
+    });
+
+    runtime.set_telemetry([&](const MeiiStateFrame& frame) {
+        std::copy(frame.anatomical_positions.begin(), frame.anatomical_positions.end(), pos.begin());
+        std::copy(frame.anatomical_velocities.begin(), frame.anatomical_velocities.end(), vel.begin());
+        std::copy(frame.anatomical_torques.begin(), frame.anatomical_torques.end(), trq.begin());
+        ms_pos.write_data(pos);
+        ms_vel.write_data(vel);
+        ms_trq.write_data(trq);
+    });
+
+    meii->enable();
+    runtime.run(stop);
+    meii->disable();
+    if (daq)
+        daq->close();
+
+    if (trace_seconds > 0) {
+        meii->get_profiler().get_trace().set_enabled(false);
+        meii->get_profiler().get_trace().write_json("meii_trace.json", seconds(trace_seconds));
+    }
+
+    RuntimeStats stats = runtime.get_stats();
+    print("ticks:             {}", stats.ticks);
+    print("overruns:          {}", stats.overruns);
+    print("max tick time:     {} us", stats.max_tick_time.as_microseconds());
+    print("telemetry dropped: {}", stats.telemetry_dropped);
+    print("messages dropped:  {}", stats.messages_dropped);
+
+    return 0;
+}
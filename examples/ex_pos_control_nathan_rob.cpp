@@ -113,15 +113,17 @@ int main(int argc, char *argv[]) {
 	std::vector<std::string> dof_str = { "ElbowFE", "WristPS", "WristFE", "WristRU" };
 
 	bool save_data = false;
-    std::string filepath = "example_meii_robot_data_log.csv";
-
-	// construct robot data log
-	std::vector<double> robot_log_row(6);
-	std::vector<std::vector<double>> robot_log;
-	std::vector<std::string> header = { "Time [s]", "ref 1 [rad/s]", "ref 2 [rad/s]",  "ref 3 [rad/s]", "ref 4 [rad/s]", "ref 5 [rad/s]" };
-	if (save_data){
-		csv_write_row(filepath, header);
+    std::string filepath = "example_meii_robot_data_log.meiirec";
+
+	// construct robot data log, recorded to disk by a background thread as the demo runs
+	// and exported to CSV with ex_session_to_csv
+	RecordSchema log_schema;
+	log_schema.add_field("Time [s]");
+	for (std::size_t i = 0; i < 5; ++i) {
+		log_schema.add_field("ref " + std::to_string(i + 1) + " [rad/s]");
 	}
+	SessionRecorder robot_log(log_schema);
+	robot_log.open(filepath);
 
 	// trajectory following
 	if (result.count("single") > 0) {
@@ -602,12 +604,10 @@ int main(int argc, char *argv[]) {
 				save_data = true;
             }
 
-			// store the time and ref data to log to a csv
-			robot_log_row[0] = timer.get_elapsed_time().as_seconds();
-			for (std::size_t i = 0; i < 5; ++i) {
-				robot_log_row[i + 1] = ref[i];
-			}
-			robot_log.push_back(robot_log_row);
+			// store the time and ref data in the robot data log
+			robot_log.set(0, timer.get_elapsed_time().as_seconds());
+			robot_log.set(1, ref.data(), 5);
+			robot_log.commit();
 
 			
 
@@ -619,18 +619,21 @@ int main(int argc, char *argv[]) {
     	meii->daq_disable();
 	}
 
-	// save the data if the user wants
+	// keep the data if the user wants
+	robot_log.close();
 	if (save_data) {
 		print("Do you want to save the robot data log? (Y/N)");
 		int key_pressed = 0;
 		while (key_pressed != 'y' && key_pressed != 'n'){
 			key_pressed = get_key();
 		}
-		if (key_pressed == 'y'){
-			csv_write_row(filepath, header);
-			csv_append_rows(filepath, robot_log);
+		if (key_pressed == 'n'){
+			std::remove(filepath.c_str());
 		} 
 	}
+	else {
+		std::remove(filepath.c_str());
+	}
 
 	disable_realtime();
 	while (get_key_nb() != 0);
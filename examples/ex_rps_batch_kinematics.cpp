@@ -0,0 +1,94 @@
+#include <MEII/MahiExoII/RpsBatchKinematics.hpp>
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <Mahi/Util.hpp>
+#include <random>
+#include <vector>
+
+using namespace mahi::util;
+using namespace meii;
+
+int main(int argc, char* argv[]) {
+
+    Options options("ex_rps_batch_kinematics.exe", "Measures the throughput of the batch RPS kinematics and checks it against RpsKinematics");
+    options.add_options()
+        ("n,samples", "Number of samples", value<int>()->default_value("1000000"))
+        ("t,threads", "Number of threads, 0 for all hardware threads", value<int>()->default_value("0"))
+        ("c,check", "Number of samples to check against RpsKinematics", value<int>()->default_value("10000"))
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    const std::size_t n = result["samples"].as<int>();
+
+    // random wrist poses: f/e and r/u within +/- 30 deg, forearm length 0.08 to 0.11 m
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> wrist(-30 * DEG2RAD, 30 * DEG2RAD);
+    std::uniform_real_distribution<double> forearm(0.08, 0.11);
+    std::vector<double> q_ser_in[3], q_par[3], q_ser_out[3];
+    for (std::size_t i = 0; i < 3; ++i) {
+        q_ser_in[i].resize(n);
+        q_par[i].resize(n);
+        q_ser_out[i].resize(n);
+    }
+    for (std::size_t k = 0; k < n; ++k) {
+        q_ser_in[0][k] = wrist(gen);
+        q_ser_in[1][k] = wrist(gen);
+        q_ser_in[2][k] = forearm(gen);
+    }
+    const double* ik_in[3] = { q_ser_in[0].data(), q_ser_in[1].data(), q_ser_in[2].data() };
+    double* ik_out[3] = { q_par[0].data(), q_par[1].data(), q_par[2].data() };
+    const double* fk_in[3] = { q_par[0].data(), q_par[1].data(), q_par[2].data() };
+    double* fk_out[3] = { q_ser_out[0].data(), q_ser_out[1].data(), q_ser_out[2].data() };
+
+    // single threaded, then on every requested thread
+    RpsBatchKinematics single(1);
+    RpsBatchKinematics batch(result["threads"].as<int>());
+    RpsBatchResult ik_single = single.inverse(n, ik_in, ik_out);
+    RpsBatchResult fk_single = single.forward(n, fk_in, fk_out);
+    RpsBatchResult ik = batch.inverse(n, ik_in, ik_out);
+    RpsBatchResult fk = batch.forward(n, fk_in, fk_out);
+
+    print("samples: {}, threads: {}", n, batch.get_thread_count());
+    print("inverse, 1 thread:  {:.3e} samples/s", ik_single.samples_per_second());
+    print("forward, 1 thread:  {:.3e} samples/s", fk_single.samples_per_second());
+    print("inverse, {} threads: {:.3e} samples/s, {} fallbacks, {} failures", batch.get_thread_count(), ik.samples_per_second(), ik.fallbacks, ik.failures);
+    print("forward, {} threads: {:.3e} samples/s, {} failures", batch.get_thread_count(), fk.samples_per_second(), fk.failures);
+
+    // round trip error over every sample
+    double max_round_trip = 0;
+    for (std::size_t i = 0; i < 3; ++i)
+        for (std::size_t k = 0; k < n; ++k)
+            max_round_trip = std::max(max_round_trip, std::abs(q_ser_out[i][k] - q_ser_in[i][k]));
+
+    // compare against the single sample solver
+    RpsKinematics rps;
+    RpsKinematics::VectorQs q_in, q_out;
+    RpsKinematics::VectorQp qp;
+    RpsKinematics::MatrixRho rho;
+    RpsKinematics::MatrixJac jac;
+    double max_ik_err = 0, max_fk_err = 0;
+    const std::size_t n_check = std::min<std::size_t>(n, result["check"].as<int>());
+    Clock clock;
+    for (std::size_t k = 0; k < n_check; ++k) {
+        q_in << q_ser_in[0][k], q_ser_in[1][k], q_ser_in[2][k];
+        rps.inverse(q_in, q_out, qp, rho, jac);
+        for (std::size_t i = 0; i < 3; ++i)
+            max_ik_err = std::max(max_ik_err, std::abs(q_out[i] - q_par[i][k]));
+        q_in << q_par[0][k], q_par[1][k], q_par[2][k];
+        rps.forward(q_in, q_out, qp, rho, jac);
+        for (std::size_t i = 0; i < 3; ++i)
+            max_fk_err = std::max(max_fk_err, std::abs(q_out[i] - q_ser_out[i][k]));
+    }
+    Time scalar_time = clock.get_elapsed_time();
+
+    print("RpsKinematics inverse + forward: {:.3e} samples/s", n_check / scalar_time.as_seconds());
+    print("max round trip error:        {:.3e}", max_round_trip);
+    print("max difference from RpsKinematics: {:.3e} (inverse), {:.3e} (forward)", max_ik_err, max_fk_err);
+
+    return 0;
+}
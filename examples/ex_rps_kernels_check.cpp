@@ -0,0 +1,79 @@
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <Mahi/Util.hpp>
+#include <random>
+#include <vector>
+
+using namespace mahi::util;
+using namespace meii;
+
+// Checks the generated phi / phi_d_qp kernels against the hand written reference
+// expressions in RpsKinematics. Exits with 1 if they disagree by more than the tolerance.
+int main(int argc, char* argv[]) {
+
+    Options options("ex_rps_kernels_check.exe", "Compares the generated RPS constraint kernels with the hand written expressions");
+    options.add_options()
+        ("n,samples", "Number of random configurations to compare", value<int>()->default_value("1000000"))
+        ("t,tolerance", "Largest allowed difference", value<double>()->default_value("1e-14"))
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    const std::size_t n_samples = result["samples"].as<int>();
+    const double tolerance = result["tolerance"].as<double>();
+
+    // random configurations well beyond the reachable workspace
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<double> angle(-PI, PI);
+    std::uniform_real_distribution<double> length(0.0, 0.2);
+    std::vector<RpsKinematics::VectorQp> samples(n_samples);
+    for (auto& qp : samples) {
+        for (std::size_t i = 0; i < 12; ++i) {
+            qp[i] = (i < 3 || (i >= 6 && i < 9)) ? angle(gen) : length(gen) - (i >= 9 ? 0.1 : 0.0);
+        }
+    }
+
+    RpsKinematics::VectorQb phi, phi_ref;
+    RpsKinematics::MatrixPhi phi_d_qp, phi_d_qp_ref;
+    double max_phi_err = 0, max_phi_d_qp_err = 0;
+    for (const auto& qp : samples) {
+        RpsKinematics::phi_update(qp, phi);
+        RpsKinematics::phi_update_reference(qp, phi_ref);
+        RpsKinematics::phi_d_qp_update(qp, phi_d_qp);
+        RpsKinematics::phi_d_qp_update_reference(qp, phi_d_qp_ref);
+        max_phi_err = std::max(max_phi_err, (phi - phi_ref).cwiseAbs().maxCoeff());
+        max_phi_d_qp_err = std::max(max_phi_d_qp_err, (phi_d_qp - phi_d_qp_ref).cwiseAbs().maxCoeff());
+    }
+
+    // time each pair, accumulating a result so the calls are not optimized away
+    double sink = 0;
+    Clock clock;
+    for (const auto& qp : samples) {
+        RpsKinematics::phi_update_reference(qp, phi);
+        RpsKinematics::phi_d_qp_update_reference(qp, phi_d_qp);
+        sink += phi[0] + phi_d_qp(0, 6);
+    }
+    Time reference_time = clock.get_elapsed_time();
+    clock.restart();
+    for (const auto& qp : samples) {
+        RpsKinematics::phi_update(qp, phi);
+        RpsKinematics::phi_d_qp_update(qp, phi_d_qp);
+        sink -= phi[0] + phi_d_qp(0, 6);
+    }
+    Time generated_time = clock.get_elapsed_time();
+
+    print("max |phi| difference:      {:.3e}", max_phi_err);
+    print("max |phi_d_qp| difference: {:.3e}", max_phi_d_qp_err);
+    print("hand written: {:.1f} ns/call, generated: {:.1f} ns/call ({:.1e})", 1000.0 * reference_time.as_microseconds() / n_samples, 1000.0 * generated_time.as_microseconds() / n_samples, sink);
+
+    if (max_phi_err > tolerance || max_phi_d_qp_err > tolerance) {
+        print("FAILED: generated kernels differ from the reference by more than {:.1e}", tolerance);
+        return 1;
+    }
+    print("passed");
+    return 0;
+}
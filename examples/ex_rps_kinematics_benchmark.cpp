@@ -0,0 +1,245 @@
+#include <MEII/MahiExoII/MeiiParameters.hpp>
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <Mahi/Util.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace mahi::util;
+using namespace meii;
+
+// count every heap allocation made by the process so we can report allocations per tick
+static std::atomic<std::size_t> g_allocations(0);
+
+#if defined(__GLIBC__)
+// Eigen allocates dynamic-size storage with malloc directly, so interpose malloc itself
+extern "C" void* __libc_malloc(std::size_t size);
+extern "C" void* malloc(std::size_t size) {
+    ++g_allocations;
+    return __libc_malloc(size);
+}
+#else
+// elsewhere we can only see allocations that go through operator new
+void* operator new(std::size_t size) {
+    ++g_allocations;
+    if (void* ptr = std::malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+#endif
+
+// The dynamic-size solver that MahiExoII::update_kinematics() ran before RpsKinematics, kept
+// here so both can be timed side by side. It uses the original hand written constraint
+// expressions, RpsKinematics::phi_update_reference() and phi_d_qp_update_reference().
+class LegacyRpsKinematics {
+public:
+    void forward_velocity(const Eigen::VectorXd& q_par_in, Eigen::VectorXd& q_ser_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_fk, Eigen::MatrixXd& jac_fk, const Eigen::VectorXd& q_par_dot_in, Eigen::VectorXd& q_ser_dot_out, Eigen::VectorXd& qp_dot_out) const {
+        Eigen::MatrixXd rho_s = Eigen::MatrixXd::Zero(n_qp, n_qs);
+        solve(m_select_q_par, q_par_in, qp_out, rho_fk, rho_s, 10, 1e-12);
+        q_ser_out << qp_out(m_select_q_ser[0]), qp_out(m_select_q_ser[1]), qp_out(m_select_q_ser[2]);
+        for (int i = 0; i < n_qs; ++i) {
+            jac_fk.row(i) = rho_s.row(m_select_q_ser[i]);
+        }
+        q_ser_dot_out = jac_fk * q_par_dot_in;
+        Eigen::VectorXd qb_dot = Eigen::VectorXd::Zero(n_qp - n_qs);
+        qb_dot = rho_fk * q_par_dot_in;
+        for (int i = 0; i < n_qs; ++i) {
+            qp_dot_out[m_select_q_ser[i]] = q_ser_dot_out[i];
+        }
+        std::vector<uint8> indices = select_q_invert(m_select_q_ser);
+        for (int i = 0; i < n_qp - n_qs; ++i) {
+            qp_dot_out[indices[i]] = qb_dot[i];
+        }
+    }
+
+private:
+    void solve(std::vector<uint8> select_q, const Eigen::VectorXd& qs, Eigen::VectorXd& qp, Eigen::MatrixXd& rho, Eigen::MatrixXd& rho_s, uint32 max_it, double tol) const {
+        Eigen::MatrixXd A = Eigen::MatrixXd::Zero(n_qs, n_qp);
+        for (int i = 0; i < n_qs; ++i) {
+            A(i, select_q[i]) = 1;
+        }
+        qp << PI / 4, PI / 4, PI / 4, 0.1305, 0.1305, 0.1305, 0, 0, 0, 0.0923, 0, 0;
+        Eigen::VectorXd phi = Eigen::VectorXd::Zero(n_qp - n_qs);
+        Eigen::MatrixXd phi_d_qp = Eigen::MatrixXd::Zero(n_qp - n_qs, n_qp);
+        Eigen::VectorXd psi = Eigen::VectorXd::Zero(n_qp);
+        Eigen::MatrixXd psi_d_qp = Eigen::MatrixXd::Zero(n_qp, n_qp);
+        Eigen::MatrixXd rho_rhs = Eigen::MatrixXd::Zero(n_qp, n_qs);
+        rho_rhs.bottomRows(n_qs) = Eigen::MatrixXd::Identity(n_qs, n_qs);
+        double err = 2 * tol;
+        uint32 it = 0;
+        while (it < max_it && err > tol) {
+            psi_update(A, qs, qp, phi, psi);
+            psi_d_qp_update(A, qp, phi_d_qp, psi_d_qp);
+            qp -= psi_d_qp.fullPivLu().solve(psi);
+            err = 0;
+            for (auto j = 0; j != n_qp; ++j) {
+                err += psi[j]*psi[j];
+            }
+            err = sqrt(err);
+            it++;
+        }
+        rho_s = psi_d_qp.fullPivLu().solve(rho_rhs);
+        std::vector<uint8> indices = select_q_invert(select_q);
+        for (int i = 0; i < n_qp - n_qs; ++i) {
+            rho.row(i) = rho_s.row(indices.at(i));
+        }
+    }
+
+    void psi_update(const Eigen::MatrixXd& A, const Eigen::VectorXd& qs, const Eigen::VectorXd& qp, Eigen::VectorXd& phi, Eigen::VectorXd& psi) const {
+        RpsKinematics::VectorQb phi_fixed;
+        RpsKinematics::phi_update_reference(qp, phi_fixed);
+        phi = phi_fixed;
+        psi.head(n_qp - n_qs) = phi;
+        psi.tail(n_qs) = A*qp - qs;
+    }
+
+    void psi_d_qp_update(const Eigen::MatrixXd& A, const Eigen::VectorXd& qp, Eigen::MatrixXd& phi_d_qp, Eigen::MatrixXd& psi_d_qp) const {
+        RpsKinematics::MatrixPhi phi_d_qp_fixed;
+        RpsKinematics::phi_d_qp_update_reference(qp, phi_d_qp_fixed);
+        phi_d_qp = phi_d_qp_fixed;
+        psi_d_qp.block<n_qp - n_qs, n_qp>(0, 0) = phi_d_qp;
+        psi_d_qp.block<n_qs, n_qp>(n_qp - n_qs, 0) = A;
+    }
+
+    std::vector<uint8> select_q_invert(std::vector<uint8> select_q) const {
+        std::vector<uint8> indices{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+        for (int i = 0; i < n_qs; ++i) {
+            indices.erase(indices.begin() + select_q[i]);
+        }
+        return indices;
+    }
+
+    static const int n_qp = 12;
+    static const int n_qs = 3;
+    const std::vector<uint8> m_select_q_par = { 3, 4, 5 };
+    const std::vector<uint8> m_select_q_ser = { 6, 7, 9 };
+};
+
+int main(int argc, char* argv[]) {
+
+    Options options("ex_rps_kinematics_benchmark.exe", "Times the RPS forward kinematics solve performed every update_kinematics() tick");
+    options.add_options()
+        ("n,ticks", "Number of 1 ms ticks to simulate", value<int>()->default_value("20000"))
+        ("v,validate", "Compares the reduced and general solvers across the prismatic joint limits")
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    if (result.count("validate") > 0) {
+        MeiiParameters params;
+        RpsKinematics::VectorQs q_par_min, q_par_max;
+        for (std::size_t i = 0; i < 3; ++i) {
+            q_par_min[i] = params.pos_limits_min_[i + 2];
+            q_par_max[i] = params.pos_limits_max_[i + 2];
+        }
+        RpsValidationResult validation = RpsKinematics().validate_reduced(q_par_min, q_par_max, 20);
+        print("grid points:             {}", validation.samples);
+        print("general solver failures: {} (unreachable, not compared)", validation.general_failures);
+        print("reduced solver failures: {}", validation.reduced_failures);
+        print("assembly mode mismatches: {}", validation.branch_mismatches);
+        print("max |q_ser| error:       {:.3e} at q_par = [{:.4f}, {:.4f}, {:.4f}]", validation.max_q_ser_error, validation.worst_q_par[0], validation.worst_q_par[1], validation.worst_q_par[2]);
+        print("max |jac_fk| error:      {:.3e} (relative)", validation.max_jac_fk_error);
+        return 0;
+    }
+
+    const std::size_t n_ticks = result["ticks"].as<int>();
+
+    // generate a smooth 1 kHz trajectory of the prismatic links that sweeps the workspace
+    std::vector<RpsKinematics::VectorQs> q_par_traj(n_ticks);
+    std::vector<RpsKinematics::VectorQs> q_par_dot_traj(n_ticks);
+    for (std::size_t k = 0; k < n_ticks; ++k) {
+        double t = 0.001 * k;
+        for (std::size_t i = 0; i < 3; ++i) {
+            double w = 2 * PI * (0.2 + 0.05 * i);
+            q_par_traj[k][i] = 0.1 + 0.008 * sin(w * t + i);
+            q_par_dot_traj[k][i] = 0.008 * w * cos(w * t + i);
+        }
+    }
+
+    // legacy dynamic-size solver
+    LegacyRpsKinematics legacy;
+    Eigen::VectorXd q_par = Eigen::VectorXd::Zero(3), q_par_dot = Eigen::VectorXd::Zero(3);
+    Eigen::VectorXd q_ser = Eigen::VectorXd::Zero(3), q_ser_dot = Eigen::VectorXd::Zero(3);
+    Eigen::VectorXd qp = Eigen::VectorXd::Zero(12), qp_dot = Eigen::VectorXd::Zero(12);
+    Eigen::MatrixXd rho_fk = Eigen::MatrixXd::Zero(9, 3), jac_fk = Eigen::MatrixXd::Zero(3, 3);
+    std::vector<RpsKinematics::VectorQs> legacy_q_ser(n_ticks);
+
+    std::size_t allocations = g_allocations;
+    Clock clock;
+    for (std::size_t k = 0; k < n_ticks; ++k) {
+        q_par = q_par_traj[k];
+        q_par_dot = q_par_dot_traj[k];
+        legacy.forward_velocity(q_par, q_ser, qp, rho_fk, jac_fk, q_par_dot, q_ser_dot, qp_dot);
+        legacy_q_ser[k] = q_ser;
+    }
+    Time legacy_time = clock.get_elapsed_time();
+    double legacy_allocs = (double)(g_allocations - allocations) / n_ticks;
+
+    // fixed-size solver
+    RpsKinematics rps;
+    RpsKinematics::VectorQs q_ser_fixed, q_ser_dot_fixed;
+    RpsKinematics::VectorQp qp_fixed, qp_dot_fixed;
+    RpsKinematics::MatrixRho rho_fk_fixed;
+    RpsKinematics::MatrixJac jac_fk_fixed;
+    double max_err = 0;
+
+    RpsSolverStats cold_stats;
+    allocations = g_allocations;
+    clock.restart();
+    for (std::size_t k = 0; k < n_ticks; ++k) {
+        cold_stats.record(rps.forward_velocity(q_par_traj[k], q_ser_fixed, qp_fixed, rho_fk_fixed, jac_fk_fixed, q_par_dot_traj[k], q_ser_dot_fixed, qp_dot_fixed));
+        max_err = std::max(max_err, (q_ser_fixed - legacy_q_ser[k]).cwiseAbs().maxCoeff());
+    }
+    Time fixed_time = clock.get_elapsed_time();
+    double fixed_allocs = (double)(g_allocations - allocations) / n_ticks;
+
+    // fixed-size solver seeded with the previous tick's solution, as update_kinematics() does
+    RpsSolverStats warm_stats;
+    double max_warm_err = 0;
+    qp_fixed = RpsKinematics::qp_guess();
+    clock.restart();
+    for (std::size_t k = 0; k < n_ticks; ++k) {
+        warm_stats.record(rps.forward_velocity(q_par_traj[k], q_ser_fixed, qp_fixed, rho_fk_fixed, jac_fk_fixed, q_par_dot_traj[k], q_ser_dot_fixed, qp_dot_fixed, true));
+        max_warm_err = std::max(max_warm_err, (q_ser_fixed - legacy_q_ser[k]).cwiseAbs().maxCoeff());
+    }
+    Time warm_time = clock.get_elapsed_time();
+
+    // reduced 3 variable solver, warm started
+    RpsSolverStats reduced_stats;
+    double max_reduced_err = 0;
+    rps.set_forward_method(RpsFkMethod::Reduced);
+    qp_fixed = RpsKinematics::qp_guess();
+    allocations = g_allocations;
+    clock.restart();
+    for (std::size_t k = 0; k < n_ticks; ++k) {
+        reduced_stats.record(rps.forward_velocity(q_par_traj[k], q_ser_fixed, qp_fixed, rho_fk_fixed, jac_fk_fixed, q_par_dot_traj[k], q_ser_dot_fixed, qp_dot_fixed, true));
+        max_reduced_err = std::max(max_reduced_err, (q_ser_fixed - legacy_q_ser[k]).cwiseAbs().maxCoeff());
+    }
+    Time reduced_time = clock.get_elapsed_time();
+    double reduced_allocs = (double)(g_allocations - allocations) / n_ticks;
+
+    print("ticks solved:          {}", n_ticks);
+    print("legacy  (VectorXd):    {:.2f} us/tick, {:.1f} allocations/tick", (double)legacy_time.as_microseconds() / n_ticks, legacy_allocs);
+    print("RpsKinematics (cold):  {:.2f} us/tick, {:.1f} allocations/tick, {:.2f} iterations/tick", (double)fixed_time.as_microseconds() / n_ticks, fixed_allocs, cold_stats.mean_iterations());
+    print("RpsKinematics (warm):  {:.2f} us/tick, {:.2f} iterations/tick, {} cold restarts", (double)warm_time.as_microseconds() / n_ticks, warm_stats.mean_iterations(), warm_stats.cold_restarts);
+    print("reduced (warm):        {:.2f} us/tick, {:.1f} allocations/tick, {:.2f} iterations/tick, {} failures", (double)reduced_time.as_microseconds() / n_ticks, reduced_allocs, reduced_stats.mean_iterations(), reduced_stats.failures);
+    print("speedup (cold, warm, reduced): {:.2f}x, {:.2f}x, {:.2f}x", (double)legacy_time.as_microseconds() / fixed_time.as_microseconds(), (double)legacy_time.as_microseconds() / warm_time.as_microseconds(), (double)legacy_time.as_microseconds() / reduced_time.as_microseconds());
+    print("max |q_ser| deviation: {:.3e} (cold), {:.3e} (warm), {:.3e} (reduced)", max_err, max_warm_err, max_reduced_err);
+    print("warm start iteration histogram:");
+    for (std::size_t i = 0; i < RpsSolverStats::n_bins; ++i) {
+        if (warm_stats.iteration_histogram[i] > 0)
+            print("  {:2} iterations: {} ticks", i, warm_stats.iteration_histogram[i]);
+    }
+
+    return 0;
+}
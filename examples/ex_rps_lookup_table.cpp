@@ -0,0 +1,101 @@
+#include <MEII/MahiExoII/MeiiParameters.hpp>
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <MEII/MahiExoII/RpsLookupTable.hpp>
+#include <Mahi/Util.hpp>
+#include <random>
+
+using namespace mahi::util;
+using namespace meii;
+
+int main(int argc, char* argv[]) {
+
+    Options options("ex_rps_lookup_table.exe", "Generates and checks the RPS forward kinematics lookup table used by MahiExoII::load_kinematics_table()");
+    options.add_options()
+        ("o,output", "Path of the table file", value<std::string>()->default_value("rps_fk_table.bin"))
+        ("n,nodes", "Number of nodes along each link length", value<int>()->default_value("48"))
+        ("c,check", "Only check an existing table file, do not generate it")
+        ("s,samples", "Number of random link lengths to check", value<int>()->default_value("100000"))
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    const std::string filepath = result["output"].as<std::string>();
+
+    // the table spans the prismatic joint limits
+    MeiiParameters params;
+    RpsKinematics::VectorQs q_par_min, q_par_max;
+    for (std::size_t i = 0; i < 3; ++i) {
+        q_par_min[i] = params.pos_limits_min_[i + 2];
+        q_par_max[i] = params.pos_limits_max_[i + 2];
+    }
+
+    RpsKinematics rps;
+    Clock clock;
+
+    if (result.count("check") == 0) {
+        std::size_t n_grid = result["nodes"].as<int>();
+        std::size_t n_solved = RpsLookupTable::generate(filepath, rps, q_par_min, q_par_max, n_grid);
+        if (n_solved == 0)
+            return 1;
+        print("generated {} in {:.1f} s, {} of {} nodes solved", filepath, clock.get_elapsed_time().as_seconds(), n_solved, n_grid * n_grid * n_grid);
+    }
+
+    // look up through the solver, as MahiExoII::load_kinematics_table() does, so jac_fk is rebuilt at the interpolated qp
+    auto table = std::make_shared<RpsLookupTable>();
+    if (!table->open(filepath))
+        return 1;
+    RpsKinematics rps_table;
+    rps_table.set_lookup_table(table);
+    rps_table.set_forward_method(RpsFkMethod::Table);
+
+    // compare the table with the solver at random link lengths
+    std::mt19937 gen(0);
+    const std::size_t n_samples = result["samples"].as<int>();
+    std::size_t n_answered = 0;
+    double max_q_ser_error = 0, max_jac_error = 0;
+    Time table_time = Time::Zero, solver_time = Time::Zero;
+
+    RpsKinematics::VectorQs q_par, q_ser_table;
+    RpsKinematics::VectorQp qp_table, qp_solver;
+    RpsKinematics::MatrixRho rho, rho_table;
+    RpsKinematics::MatrixRhoS rho_s_solver;
+    RpsKinematics::MatrixJac jac_table;
+    for (std::size_t n = 0; n < n_samples; ++n) {
+        for (std::size_t i = 0; i < 3; ++i) {
+            q_par[i] = std::uniform_real_distribution<double>(q_par_min[i], q_par_max[i])(gen);
+        }
+        clock.restart();
+        bool answered = rps_table.forward(q_par, q_ser_table, qp_table, rho_table, jac_table).table_lookup;
+        table_time += clock.get_elapsed_time();
+        if (!answered)
+            continue;
+        n_answered++;
+
+        // warm start from the table so the solver stays on the same assembly mode
+        qp_solver = qp_table;
+        clock.restart();
+        bool solved = rps.solve(rps_select_par, q_par, qp_solver, rho, rho_s_solver, true).converged;
+        solver_time += clock.get_elapsed_time();
+        if (!solved)
+            continue;
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            std::size_t q = rps_select_ser.q[i];
+            max_q_ser_error = std::max(max_q_ser_error, std::abs(qp_table[q] - qp_solver[q]));
+            max_jac_error = std::max(max_jac_error, (jac_table.row(i) - rho_s_solver.row(q)).cwiseAbs().maxCoeff());
+        }
+    }
+
+    print("samples inside solved cells: {} of {}", n_answered, n_samples);
+    print("table lookup:       {:.3f} us/sample", (double)table_time.as_microseconds() / n_samples);
+    print("general solver:     {:.3f} us/sample", n_answered > 0 ? (double)solver_time.as_microseconds() / n_answered : 0.0);
+    print("max |q_ser| error:  {:.3e}", max_q_ser_error);
+    print("max |jac_fk| error: {:.3e}", max_jac_error);
+
+    return 0;
+}
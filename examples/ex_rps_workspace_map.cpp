@@ -0,0 +1,200 @@
+#include <MEII/MahiExoII/MeiiParameters.hpp>
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <Mahi/Util.hpp>
+#include <Eigen/Eigenvalues>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace mahi::util;
+using namespace meii;
+
+/// Header of the binary map, followed by n_grid[0]*n_grid[1]*n_grid[2] WorkspaceNodes with the last link length varying fastest
+struct WorkspaceMapHeader {
+    char magic[8];        // "MEIIWSM" followed by a null terminator
+    uint32 version;       // file format version
+    uint32 n_grid[3];     // number of nodes along each link length
+    double q_par_min[3];  // link lengths at the first node [m]
+    double q_par_max[3];  // link lengths at the last node [m]
+};
+
+/// Result at one grid node
+struct WorkspaceNode {
+    float q_ser[3];       // wrist f/e [rad], r/u deviation [rad] and arm translation [m], NaN if not converged
+    float condition;      // 2-norm condition number of psi_d_qp at the solution, NaN if not converged
+    uint8 converged;      // 1 if the solver reached the tolerance
+    uint8 iterations;     // Newton iterations taken, including any cold restart
+    uint8 cold_restart;   // 1 if the warm start from the neighboring node diverged
+    uint8 reserved;       // padding
+};
+
+/// condition number of the jacobian the general solver factorizes for the forward kinematics. The eigenvalues
+/// of psi_d_qp^T * psi_d_qp are the squared singular values, and are several times cheaper to find than an SVD
+double psi_condition(const RpsKinematics::VectorQp& qp) {
+    RpsKinematics::MatrixPhi phi_d_qp;
+    RpsKinematics::phi_d_qp_update(qp, phi_d_qp);
+    RpsKinematics::MatrixPsi psi_d_qp = RpsKinematics::MatrixPsi::Zero();
+    psi_d_qp.topRows<RpsKinematics::n_qb>() = phi_d_qp;
+    for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+        psi_d_qp(RpsKinematics::n_qb + i, rps_select_par.q[i]) = 1;
+    }
+    RpsKinematics::MatrixPsi gram;
+    gram.noalias() = psi_d_qp.transpose() * psi_d_qp;
+    Eigen::SelfAdjointEigenSolver<RpsKinematics::MatrixPsi> eig(gram, Eigen::EigenvaluesOnly);
+    const auto& ev = eig.eigenvalues(); // ascending
+    return ev[0] > 0 ? std::sqrt(ev[ev.size() - 1] / ev[0]) : std::numeric_limits<double>::infinity();
+}
+
+int main(int argc, char* argv[]) {
+
+    Options options("ex_rps_workspace_map.exe", "Maps convergence and conditioning of the RPS forward kinematics over the prismatic joint limits");
+    options.add_options()
+        ("o,output", "Path of the map file, written as CSV if it ends in .csv and binary otherwise", value<std::string>()->default_value("rps_workspace_map.bin"))
+        ("n,nodes", "Number of nodes along each link length", value<int>()->default_value("64"))
+        ("t,threads", "Number of threads, 0 for all hardware threads", value<int>()->default_value("0"))
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    const std::string filepath = result["output"].as<std::string>();
+    const std::size_t n_grid = std::max(2, result["nodes"].as<int>());
+    std::size_t n_threads = result["threads"].as<int>() > 0 ? result["threads"].as<int>() : std::thread::hardware_concurrency();
+    n_threads = std::max<std::size_t>(1, std::min(n_threads, n_grid));
+
+    // the map spans the prismatic joint limits
+    MeiiParameters params;
+    RpsKinematics::VectorQs q_par_min, q_par_max, step;
+    for (std::size_t i = 0; i < 3; ++i) {
+        q_par_min[i] = params.pos_limits_min_[i + 2];
+        q_par_max[i] = params.pos_limits_max_[i + 2];
+        step[i] = (q_par_max[i] - q_par_min[i]) / (n_grid - 1);
+    }
+
+    RpsKinematics rps(20);
+    std::vector<WorkspaceNode> nodes(n_grid * n_grid * n_grid);
+
+    // threads take whole slices of the first link length, and walk each slice row by row so
+    // every node is warm started from its solved neighbor and stays on the same assembly mode
+    std::atomic<std::size_t> next_slice(0);
+    auto sweep = [&]() {
+        RpsKinematics::VectorQs q_par;
+        RpsKinematics::VectorQp qp, qp_seed, qp_row;
+        RpsKinematics::MatrixRho rho;
+        RpsKinematics::MatrixRhoS rho_s;
+        std::size_t i;
+        while ((i = next_slice++) < n_grid) {
+            qp_row = RpsKinematics::qp_guess();
+            for (std::size_t j = 0; j < n_grid; ++j) {
+                // each row starts from the first solved node of the row before it
+                qp = qp_row;
+                bool row_solved = false;
+                for (std::size_t k = 0; k < n_grid; ++k) {
+                    q_par << q_par_min[0] + i * step[0], q_par_min[1] + j * step[1], q_par_min[2] + k * step[2];
+                    qp_seed = qp;
+                    RpsSolveInfo info = rps.solve(rps_select_par, q_par, qp, rho, rho_s, true);
+
+                    WorkspaceNode& node = nodes[(i * n_grid + j) * n_grid + k];
+                    node.converged = info.converged;
+                    node.iterations = (uint8)std::min<uint32>(info.iterations, 255);
+                    node.cold_restart = info.cold_restart;
+                    node.reserved = 0;
+                    if (info.converged) {
+                        for (std::size_t n = 0; n < 3; ++n) {
+                            node.q_ser[n] = (float)qp[rps_select_ser.q[n]];
+                        }
+                        node.condition = (float)psi_condition(qp);
+                        if (!row_solved) {
+                            qp_row = qp;
+                            row_solved = true;
+                        }
+                    }
+                    else {
+                        for (std::size_t n = 0; n < 3; ++n) {
+                            node.q_ser[n] = std::numeric_limits<float>::quiet_NaN();
+                        }
+                        node.condition = std::numeric_limits<float>::quiet_NaN();
+                        qp = qp_seed; // keep seeding from the last solved node
+                    }
+                }
+            }
+        }
+    };
+
+    Clock clock;
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < n_threads; ++t) {
+        threads.emplace_back(sweep);
+    }
+    sweep();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = clock.get_elapsed_time().as_seconds();
+
+    std::size_t n_converged = 0, n_cold = 0;
+    double max_condition = 0;
+    for (const auto& node : nodes) {
+        n_converged += node.converged;
+        n_cold += node.cold_restart;
+        if (node.converged)
+            max_condition = std::max(max_condition, (double)node.condition);
+    }
+
+    // write the map
+    bool csv = filepath.size() >= 4 && filepath.compare(filepath.size() - 4, 4, ".csv") == 0;
+    std::FILE* file = std::fopen(filepath.c_str(), csv ? "w" : "wb");
+    if (file == nullptr) {
+        LOG(Error) << "Failed to open " << filepath << " for writing.";
+        return 1;
+    }
+    if (csv) {
+        std::fprintf(file, "q_par_0,q_par_1,q_par_2,converged,iterations,cold_restart,condition,wrist_fe,wrist_ru,arm_translation\n");
+        for (std::size_t i = 0; i < n_grid; ++i) {
+            for (std::size_t j = 0; j < n_grid; ++j) {
+                for (std::size_t k = 0; k < n_grid; ++k) {
+                    const WorkspaceNode& node = nodes[(i * n_grid + j) * n_grid + k];
+                    std::fprintf(file, "%.6f,%.6f,%.6f,%d,%d,%d,%.6g,%.9g,%.9g,%.9g\n",
+                                 q_par_min[0] + i * step[0], q_par_min[1] + j * step[1], q_par_min[2] + k * step[2],
+                                 node.converged, node.iterations, node.cold_restart, node.condition,
+                                 node.q_ser[0], node.q_ser[1], node.q_ser[2]);
+                }
+            }
+        }
+    }
+    else {
+        WorkspaceMapHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::strcpy(header.magic, "MEIIWSM");
+        header.version = 1;
+        for (std::size_t i = 0; i < 3; ++i) {
+            header.n_grid[i] = (uint32)n_grid;
+            header.q_par_min[i] = q_par_min[i];
+            header.q_par_max[i] = q_par_max[i];
+        }
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fwrite(nodes.data(), sizeof(WorkspaceNode), nodes.size(), file);
+    }
+    bool written = std::ferror(file) == 0;
+    std::fclose(file);
+    if (!written) {
+        LOG(Error) << "Failed to write " << filepath << ".";
+        return 1;
+    }
+
+    print("swept {} nodes on {} threads in {:.2f} s ({:.3e} nodes/s)", nodes.size(), n_threads, seconds, nodes.size() / seconds);
+    print("converged:     {} ({:.1f} %)", n_converged, 100.0 * n_converged / nodes.size());
+    print("cold restarts: {}", n_cold);
+    print("max condition: {:.3e}", max_condition);
+    print("wrote {}", filepath);
+
+    return 0;
+}
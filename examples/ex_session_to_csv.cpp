@@ -0,0 +1,74 @@
+#include <MEII/Utility/SessionRecorder.hpp>
+#include <Mahi/Util.hpp>
+#include <cstdio>
+#include <vector>
+
+using namespace mahi::util;
+using namespace meii;
+
+int main(int argc, char* argv[]) {
+
+    Options options("ex_session_to_csv.exe", "Exports a session file written by SessionRecorder to CSV");
+    options.add_options()
+        ("i,input", "Path of the session file", value<std::string>())
+        ("o,output", "Path of the CSV file, the input path with .csv appended by default", value<std::string>())
+        ("h,help", "Prints this help message");
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0 || result.count("input") == 0) {
+        print_var(options.help());
+        return 0;
+    }
+
+    const std::string input = result["input"].as<std::string>();
+    const std::string output = result.count("output") > 0 ? result["output"].as<std::string>() : input + ".csv";
+
+    SessionReader reader;
+    if (!reader.open(input))
+        return 1;
+    const RecordSchema& schema = reader.get_schema();
+
+    std::FILE* file = std::fopen(output.c_str(), "w");
+    if (file == nullptr) {
+        LOG(Error) << "Failed to open " << output << " for writing.";
+        return 1;
+    }
+
+    for (std::size_t i = 0; i < schema.get_field_count(); ++i) {
+        std::fprintf(file, i == 0 ? "%s" : ",%s", schema.get_field_name(i).c_str());
+    }
+    std::fprintf(file, "\n");
+
+    std::vector<uint8> records;
+    std::size_t n_records = 0, n_chunks = 0, n;
+    while ((n = reader.read_chunk(records)) > 0) {
+        for (std::size_t r = 0; r < n; ++r) {
+            const uint8* record = &records[r * schema.get_record_size()];
+            for (std::size_t i = 0; i < schema.get_field_count(); ++i) {
+                if (i > 0)
+                    std::fputc(',', file);
+                switch (schema.get_field_type(i)) {
+                    case RecordType::Float64: std::fprintf(file, "%.17g", schema.get_double(record, i)); break;
+                    case RecordType::Float32: std::fprintf(file, "%.9g", schema.get_double(record, i)); break;
+                    default:                  std::fprintf(file, "%lld", (long long)schema.get_int(record, i)); break;
+                }
+            }
+            std::fputc('\n', file);
+        }
+        n_records += n;
+        n_chunks++;
+    }
+    bool written = std::ferror(file) == 0;
+    std::fclose(file);
+    if (!written) {
+        LOG(Error) << "Failed to write " << output << ".";
+        return 1;
+    }
+
+    print("exported {} records from {} chunks to {}", n_records, n_chunks, output);
+    if (reader.is_damaged())
+        LOG(Warning) << input << " ends in a truncated or corrupt chunk, records after it were not exported.";
+
+    return 0;
+}
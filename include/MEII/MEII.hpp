@@ -5,6 +5,30 @@
 #include<MEII/MahiExoII/Joint.hpp>
 #include<MEII/MahiExoII/JointHardware.hpp>
 #include<MEII/MahiExoII/JointVirtual.hpp>
+#include<MEII/MahiExoII/JointState.hpp>
 #include<MEII/MahiExoII/MeiiConfigurationHardware.hpp>
 #include<MEII/MahiExoII/MeiiConfigurationVirtual.hpp>
+#include<MEII/MahiExoII/SimulatedPlant.hpp>
+#include<MEII/MahiExoII/MeiiPlant.hpp>
+#include<MEII/MahiExoII/CosimLink.hpp>
+#include<MEII/MahiExoII/SharedFrameLink.hpp>
+#include<MEII/MahiExoII/MonteCarloSweep.hpp>
+#include<MEII/MahiExoII/RpsKinematics.hpp>
+#include<MEII/MahiExoII/RpsKinematicsCache.hpp>
+#include<MEII/MahiExoII/RpsLookupTable.hpp>
+#include<MEII/MahiExoII/RpsBatchKinematics.hpp>
+#include<MEII/MahiExoII/MeiiStateFrame.hpp>
+#include<MEII/MahiExoII/MeiiRuntime.hpp>
+#include<MEII/MahiExoII/SafetyMonitor.hpp>
+#include<MEII/MahiExoII/LoopProfiler.hpp>
+#include<MEII/Utility/Seqlock.hpp>
+#include<MEII/Utility/SpscQueue.hpp>
+#include<MEII/Utility/SessionRecorder.hpp>
+#include<MEII/Utility/ColumnarLog.hpp>
+#include<MEII/Utility/EventLog.hpp>
+#include<MEII/Utility/CycleClock.hpp>
+#include<MEII/Utility/LatencyHistogram.hpp>
+#include<MEII/Utility/TraceRecorder.hpp>
+#include<MEII/Utility/LoopClock.hpp>
+#include<MEII/Utility/WorkStealingPool.hpp>
 #include<MEII/Control/DisturbanceObserver.hpp>
\ No newline at end of file
@@ -0,0 +1,137 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <MEII/MahiExoII/SimulatedPlant.hpp>
+#include <Mahi/Com/SharedMemory.hpp>
+#include <Mahi/Util/Timing/Time.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <array>
+#include <atomic>
+#include <string>
+
+namespace meii {
+
+    /// Shared memory frame of the co-simulation protocol, one per link. magic and version are
+    /// 4 byte unsigned integers and every other field is 8 bytes wide, all at fixed offsets, so
+    /// simulators in other languages can map it directly:
+    ///
+    ///     offset  field          written by
+    ///          0  magic          simulator, CosimRegion::magic_value once it has reset the frame
+    ///          4  version        simulator, CosimRegion::version_value
+    ///          8  command_count  controller, commands published
+    ///         16  state_count    simulator, states published
+    ///         24  dt             controller, time to simulate for the command [s]
+    ///         32  torque[5]      controller, joint torques [Nm] or [N]
+    ///         72  time           simulator, simulated time of the state [s]
+    ///         80  position[5]    simulator, joint positions [rad] or [m]
+    ///        120  velocity[5]    simulator, joint velocities [rad/s] or [m/s]
+    ///
+    /// The two sides hand each step off explicitly. The simulator publishes the initial state
+    /// (state_count = 1). The controller then repeatedly waits for state_count to be one more
+    /// than command_count, reads the state, writes dt and the torques and increments
+    /// command_count; the simulator waits for command_count to reach state_count, simulates dt
+    /// with the torques, writes the state and increments state_count. The counters are written
+    /// after the fields they publish, with release ordering, and read with acquire ordering.
+    struct CosimRegion {
+        static const mahi::util::uint32 magic_value = 0x5343454D; // "MECS"
+        static const mahi::util::uint32 version_value = 1;
+        static const std::size_t n_joints = 5;
+
+        mahi::util::uint32 magic;
+        mahi::util::uint32 version;
+        std::atomic<mahi::util::uint64> command_count;
+        std::atomic<mahi::util::uint64> state_count;
+        double dt;
+        double torque[n_joints];
+        double time;
+        double position[n_joints];
+        double velocity[n_joints];
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Controller side of the co-simulation protocol, see CosimRegion. update() blocks until the
+    /// simulator has published the state that follows the last command, and apply() publishes
+    /// the torques as the next command, so every tick of the controller corresponds to exactly
+    /// one simulated step no matter how fast either side runs. Pair it with a LoopClock in
+    /// Lockstep mode with the same period.
+    class CosimLink : public SimulatedPlant {
+    public:
+        static const std::size_t n_joints = CosimRegion::n_joints;
+
+        /// Constructor, opens or creates the shared memory name and sends period as the dt of every command
+        CosimLink(const std::string& name, mahi::util::Time period, mahi::util::Time timeout = mahi::util::seconds(1));
+
+        /// waits for the state that follows the last command, returns false if none arrives within the timeout.
+        /// time is not used, the simulator owns the clock and the time of the state is returned by get_time()
+        bool update(mahi::util::Time time) override;
+        /// publishes the torques as the next command
+        bool apply() override;
+
+        double get_position(std::size_t joint) const override { return m_position[joint]; }
+        double get_velocity(std::size_t joint) const override { return m_velocity[joint]; }
+        void set_torque(std::size_t joint, double torque) override { m_torque[joint] = torque; }
+
+        /// returns the simulated time of the last state received
+        mahi::util::Time get_time() const { return mahi::util::microseconds(static_cast<mahi::util::int64>(m_time * 1e6)); }
+        /// returns the number of commands published
+        mahi::util::uint64 get_steps() const { return m_commands; }
+
+    private:
+        mahi::com::SharedMemory m_shm;             // shared memory holding the region
+        CosimRegion* m_region;                     // protocol frame in m_shm
+        double m_dt;                               // simulated time per command [s]
+        mahi::util::Time m_timeout;                // longest wait for the simulator
+        mahi::util::uint64 m_commands;             // commands published
+        std::array<double, n_joints> m_torque;     // torques of the next command
+        std::array<double, n_joints> m_position;   // positions of the last state
+        std::array<double, n_joints> m_velocity;   // velocities of the last state
+        double m_time;                             // simulated time of the last state [s]
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Simulator side of the co-simulation protocol, see CosimRegion. A reference for simulators
+    /// written against the frame layout, and the way to drive any C++ simulation from a
+    /// controller in another process.
+    class CosimSimulator {
+    public:
+        static const std::size_t n_joints = CosimRegion::n_joints;
+
+        /// Constructor, opens or creates the shared memory name and resets the frame
+        CosimSimulator(const std::string& name, mahi::util::Time timeout = mahi::util::seconds(1));
+
+        /// publishes a state, the first one is the initial state
+        void publish(double time, const std::array<double, n_joints>& position, const std::array<double, n_joints>& velocity);
+        /// waits for the command that follows the last state, returns false if none arrives within the timeout
+        bool wait_command(std::array<double, n_joints>& torque, double& dt);
+
+    private:
+        mahi::com::SharedMemory m_shm;             // shared memory holding the region
+        CosimRegion* m_region;                     // protocol frame in m_shm
+        mahi::util::Time m_timeout;                // longest wait for the controller
+        mahi::util::uint64 m_states;               // states published
+    };
+
+} // namespace meii
@@ -47,6 +47,9 @@ public:
     /// Returns the currently set joint torque
     double get_torque_command() {return m_torque;};
 
+    /// Returns the joint torque last requested with set_torque(), before saturation
+    double get_unlimited_torque_command() {return m_com_torque;};
+
     /// Sets the joint torque to #new_torque
     virtual void set_torque(double new_torque) = 0;
 
@@ -54,10 +57,18 @@ public:
     /// or max exceeded, false otherwise
     bool position_limit_exceeded();
 
+    /// Checks an already read position against limits, and returns true if min
+    /// or max exceeded, false otherwise
+    bool position_limit_exceeded(double position);
+
     /// Gets current velocity, checks it against limit, and returns true if
     /// exceeded, false otherwise
     bool velocity_limit_exceeded();
 
+    /// Checks an already read velocity against limit, and returns true if
+    /// exceeded, false otherwise
+    bool velocity_limit_exceeded(double velocity);
+
     ///  Gets last commanded torque, checks it against torque limit, and returns
     ///  true if exceeded, false otherise
     bool torque_limit_exceeded();
@@ -98,6 +109,12 @@ protected:
     bool has_velocity_limit_  = true;  // whether or not the Joint should check velocity limits
 
     bool m_enabled = false;
+
+    std::size_t m_position_min_event; // event_log() event raised when the min position limit is exceeded
+    std::size_t m_position_max_event; // event_log() event raised when the max position limit is exceeded
+    std::size_t m_velocity_event;     // event_log() event raised when the velocity limit is exceeded
+    std::size_t m_torque_event;       // event_log() event raised when the torque limit is exceeded
+    std::size_t m_saturation_event;   // event_log() event raised when a command torque is saturated
 };
 
 } // namespace meii
@@ -0,0 +1,49 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Timing/Time.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <array>
+
+namespace meii {
+
+    /// Snapshot of every robot joint of the MAHI Exo-II, read from the joints once per tick by
+    /// MahiExoII::update_kinematics(). Each quantity is stored contiguously across the joints,
+    /// so code that needs every position (or every velocity) reads a single array.
+    struct JointState {
+        static const std::size_t n_joints = 5; // number of robot joints
+
+        std::array<double, n_joints> position;       // joint positions [rad] or [m]
+        std::array<double, n_joints> velocity;       // joint velocities [rad/s] or [m/s]
+        std::array<double, n_joints> command_torque; // torques last requested with MahiExoII::set_joint_torque(), before saturation [Nm] or [N]
+        std::array<double, n_joints> torque;         // torques last requested with MahiExoII::set_joint_torque(), after saturation [Nm] or [N]
+        mahi::util::Time time;                       // time the joints were read, since the MahiExoII was constructed
+        mahi::util::uint64 tick = 0;                 // number of snapshots taken, including this one
+
+        /// Constructor
+        JointState() {
+            position.fill(0.0);
+            velocity.fill(0.0);
+            command_torque.fill(0.0);
+            torque.fill(0.0);
+        }
+    };
+
+} // namespace meii
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <MEII/MahiExoII/Joint.hpp>
+#include <MEII/MahiExoII/SimulatedPlant.hpp>
 #include <Mahi/Com/MelShare.hpp>
 
 namespace meii {
@@ -37,6 +38,15 @@ public:
                  std::shared_ptr<mahi::com::MelShare> ms_trq,
                  std::shared_ptr<mahi::com::MelShare> ms_pos,
                  const double rest_pos);
+
+    /// Constructor for a joint of a SimulatedPlant, such as an in-process MeiiPlant or a CosimLink
+    JointVirtual(const std::string &name,
+                 std::array<double, 2> position_limits,
+                 double velocity_limit,
+                 double torque_limit,
+                 mahi::robo::Limiter limiter,
+                 std::shared_ptr<SimulatedPlant> plant,
+                 std::size_t plant_joint);
     
     /// Converts PositionSensor position to Joint position
     double get_position();
@@ -61,6 +71,9 @@ private:
 
     std::shared_ptr<mahi::com::MelShare> ms_torque; // melshare to send torque to simulation
     std::shared_ptr<mahi::com::MelShare> ms_posvel; // melshare to receive position and velocity from simulation
+
+    std::shared_ptr<SimulatedPlant> m_plant; // simulation used instead of the melshares if not null
+    std::size_t m_plant_joint;               // joint of m_plant this joint reads and drives
 };
 
 } // namespace meii
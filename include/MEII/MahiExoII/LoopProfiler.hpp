@@ -0,0 +1,125 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <MEII/Utility/CycleClock.hpp>
+#include <MEII/Utility/LatencyHistogram.hpp>
+#include <MEII/Utility/TraceRecorder.hpp>
+#include <Mahi/Util/Timing/Time.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <atomic>
+#include <string>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Latency histograms of each stage of the MAHI Exo-II control loop. Probes are placed
+    /// around the DAQ reads and writes, the kinematics update, the PD controllers and the RPS
+    /// torque mapping, and each costs two CycleClock reads and a histogram update, so they stay
+    /// on in every build. The time between kinematics updates is recorded as the loop period,
+    /// and periods more than half a period late are counted as deadline misses. Every stage is
+    /// recorded by the control thread and can be queried from any other while it runs.
+    ///
+    /// For a look at individual ticks, get_trace() can also record every probe, each period and
+    /// every Span, such as the Joint calls of MahiExoII, as a timeline. Tracing is off by default.
+    class LoopProfiler {
+    public:
+        /// Stages of a tick, in the order they run
+        enum Stage {
+            DaqRead     = 0, // MahiExoII::daq_read_all()
+            Kinematics  = 1, // MahiExoII::update_kinematics()
+            Controllers = 2, // the PD position controllers, including the torques they set
+            RpsTorques  = 3, // MahiExoII::set_rps_ser_torques()
+            DaqWrite    = 4, // MahiExoII::daq_write_all()
+            Period      = 5, // time from one update_kinematics() to the next
+            n_stages    = 6
+        };
+
+        /// Times one stage from construction to destruction
+        class Probe {
+        public:
+            Probe(LoopProfiler& profiler, Stage stage) : m_profiler(profiler), m_stage(stage), m_start(CycleClock::now()) { }
+            ~Probe() {
+                mahi::util::uint64 end = CycleClock::now();
+                m_profiler.record(m_stage, end - m_start);
+                m_profiler.m_trace.record(stage_name(m_stage), m_start, end);
+            }
+        private:
+            LoopProfiler& m_profiler;
+            Stage m_stage;
+            mahi::util::uint64 m_start;
+        };
+
+        /// Traces a call from construction to destruction without adding it to a histogram, costs
+        /// nothing beyond a load while tracing is off
+        class Span {
+        public:
+            Span(LoopProfiler& profiler, const char* name, mahi::util::int32 index = -1) :
+                m_trace(profiler.m_trace), m_name(name), m_index(index), m_start(m_trace.is_enabled() ? CycleClock::now() : 0) { }
+            ~Span() {
+                if (m_start != 0)
+                    m_trace.record(m_name, m_start, CycleClock::now(), m_index);
+            }
+        private:
+            TraceRecorder& m_trace;
+            const char* m_name;
+            mahi::util::int32 m_index;
+            mahi::util::uint64 m_start;
+        };
+
+        /// Constructor, calibrates CycleClock up front so the first tick does not pay for it
+        explicit LoopProfiler(mahi::util::Time period = mahi::util::milliseconds(1));
+
+        /// sets the nominal loop period that deadline misses are counted against
+        void set_period(mahi::util::Time period);
+        /// records a stage that took ticks CycleClock ticks
+        void record(Stage stage, mahi::util::uint64 ticks) { m_histograms[stage].record(CycleClock::to_ns(ticks)); }
+        /// marks the start of a tick, recording the period since the last one, and tracing it
+        void begin_tick();
+        /// forgets the start of the last tick, so a pause in the loop is not recorded as a period
+        void restart() { m_last_tick = 0; }
+        /// clears every histogram and the miss count, only while the loop is not running
+        void reset();
+
+        /// returns the histogram of a stage
+        const LatencyHistogram& get_histogram(Stage stage) const { return m_histograms[stage]; }
+        /// returns the number of periods more than half a period longer than nominal
+        mahi::util::uint64 get_misses() const { return m_misses.load(std::memory_order_relaxed); }
+        /// returns the timeline of probes, periods and Spans, call allocate() on it before enabling it
+        TraceRecorder& get_trace() { return m_trace; }
+        /// returns the timeline of probes, periods and Spans, write_json() is safe to call while the loop runs
+        const TraceRecorder& get_trace() const { return m_trace; }
+        /// returns a table of the count, p50, p99, p99.9 and max of every stage [us], and the miss count
+        std::string report() const;
+
+        /// returns the name of a stage
+        static const char* stage_name(Stage stage);
+
+    private:
+        LatencyHistogram m_histograms[n_stages];   // latencies of each stage
+        std::atomic<mahi::util::uint64> m_misses;  // periods more than half a period late
+        mahi::util::uint64 m_miss_ns;              // periods longer than this are misses [ns]
+        mahi::util::uint64 m_last_tick;            // CycleClock time of the last begin_tick(), 0 after restart()
+        TraceRecorder m_trace;                     // timeline of probes, periods and Spans while tracing is enabled
+    };
+
+} // namespace meii
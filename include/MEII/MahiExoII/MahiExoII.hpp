@@ -18,10 +18,20 @@
 #pragma once
 
 #include <MEII/MahiExoII/MeiiParameters.hpp>
+#include <MEII/MahiExoII/MeiiStateFrame.hpp>
 #include <MEII/MahiExoII/Joint.hpp>
+#include <MEII/MahiExoII/JointState.hpp>
+#include <MEII/MahiExoII/LoopProfiler.hpp>
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <MEII/MahiExoII/RpsKinematicsCache.hpp>
+#include <MEII/MahiExoII/SafetyMonitor.hpp>
+#include <MEII/Utility/LoopClock.hpp>
+#include <MEII/Utility/Seqlock.hpp>
 #include <Mahi/Robo/Control/PdController.hpp>
+#include <Mahi/Util/Timing/Clock.hpp>
 #include <Mahi/Util/Timing/Time.hpp>
 #include <Mahi/Util/Device.hpp>
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <atomic>
@@ -36,6 +46,8 @@ namespace meii {
     ///////////////////////// STANDARD CLASS FUNCTIONS AND PARAMS /////////////////////////
     
     public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        
         /// Constructor
         MahiExoII(MeiiParameters parameters = MeiiParameters());
         /// Destructor
@@ -58,6 +70,10 @@ namespace meii {
         static const std::size_t n_aj = 5; // number of anatomical joints
         static const std::size_t n_rj = 5; // number of robotic joints
 
+        typedef std::array<double, n_rj> JointArray;                 // one value per robot (or anatomical) joint
+        typedef std::array<bool, n_rj> JointMask;                    // selects a subset of the robot (or anatomical) joints
+        typedef std::array<double, RpsKinematics::n_qs> WristArray;  // one value per wrist parallel (or serial) joint
+
     ///////////////////////// SMOOTH REFERENCE TRAJECTORY CLASS AND INSTANCES /////////////////////////
 
     public:
@@ -123,13 +139,28 @@ namespace meii {
         /// sets the anatomical joint torques to input torque
         void set_anatomical_raw_joint_torques(std::vector<double> new_torques);
 
+        // The overloads below take and fill caller-owned fixed-size arrays, so none of them touch the heap and
+        // can be called every tick. Unlike the vector versions, ref always holds a value for every joint and
+        // the entries of inactive joints are ignored.
+
+        /// sets the robot joint torques based on a smooth reference trajectory, and writes them to command_torques
+        void set_robot_smooth_pos_ctrl_torques(SmoothReferenceTrajectory& robot_ref, mahi::util::Time current_time, JointArray& command_torques);
+        /// sets the anatomical joint torques based on a smooth reference trajectory, and writes them to command_torques
+        void set_anat_smooth_pos_ctrl_torques(SmoothReferenceTrajectory& anat_ref, mahi::util::Time current_time, JointArray& command_torques);
+        /// sets the robot joint torques based on a reference, and writes them to command_torques. inactive joints get zero torque
+        void set_robot_pos_ctrl_torques(const JointArray& ref, JointArray& command_torques, const JointMask& active = JointMask{{true, true, true, true, true}});
+        /// sets the anatomical joint torques based on a reference, and writes them to command_torques. inactive joints get zero torque
+        void set_anat_pos_ctrl_torques(const JointArray& ref, JointArray& command_torques, const JointMask& active = JointMask{{true, true, true, true, true}});
+        /// sets the robot joint torques to the input torque, named apart from the vector version so braced lists stay unambiguous
+        void set_robot_raw_joint_torques_array(const JointArray& new_torques);
+        /// sets the anatomical joint torques to the input torque, named apart from the vector version so braced lists stay unambiguous
+        void set_anatomical_raw_joint_torques_array(const JointArray& new_torques);
+
     private:
-        /// solving for static equilibrium joint torques HAS NOT BEEN TESTED
-        void solve_static_rps_torques(std::vector<mahi::util::uint8> select_q, const Eigen::VectorXd& tau_b, const Eigen::VectorXd& qp, Eigen::VectorXd& tau_s) const;
-        /// solving for static equilibrium joint torques HAS NOT BEEN TESTED
-        void solve_static_rps_torques(std::vector<mahi::util::uint8> select_q, const Eigen::VectorXd& tau_b, const Eigen::VectorXd& qp, Eigen::VectorXd& tau_s, Eigen::VectorXd& tau_p) const;
         /// converts anatomical joint torques to robot joint torques for the rps mechanism
-        void set_rps_ser_torques(std::vector<double>& tau_ser);
+        void set_rps_ser_torques(const RpsKinematics::VectorQs& tau_ser);
+        /// sets the torque of one robot joint, traced as a Joint call
+        void set_joint_torque(std::size_t joint, double torque);
 
     /////////////////// GOAL CHECKING FUNCTIONS ///////////////////
 
@@ -154,12 +185,35 @@ namespace meii {
     /////////////////// LIMIT CHECKING ON THE MEII ///////////////////
 
     public:
-        /// loops through joints and checks if any of them have exceeded their velocity or torque limit
+        /// checks the limits in the limits mask for every joint with the safety monitor, and returns the violations as a mask of SafetyMonitor::bit()s
+        mahi::util::uint32 check_limits(mahi::util::uint32 limits = SafetyMonitor::all_limits());
+        /// checks if any joint has exceeded its velocity or torque limit, both are always checked
         bool any_limit_exceeded();
-        /// loops through joints and checks if any of them have exceeded their velocity limit
+        /// checks if any joint has exceeded its velocity limit
         bool any_velocity_limit_exceeded();
-        /// loops through joints and checks if any of them have exceeded their torque limit
+        /// checks if any joint has exceeded its torque limit
         bool any_torque_limit_exceeded();
+        /// returns the safety monitor behind the limit checks, for its I^2t usage and describe()
+        const SafetyMonitor& get_safety_monitor() const { return m_safety_monitor; }
+
+    private:
+        SafetyMonitor m_safety_monitor; // checks every joint limit in one pass over m_joint_state
+
+    /////////////////// CONTROL LOOP TIMING AND PROFILING ///////////////////
+
+    public:
+        /// returns the latency histograms of each stage of the control loop, reported when the MahiExoII is destroyed
+        LoopProfiler& get_profiler() { return m_profiler; }
+        /// returns the latency histograms of each stage of the control loop, safe to query while the loop runs
+        const LoopProfiler& get_profiler() const { return m_profiler; }
+
+        /// makes clock the time base of the joint state, and of the plant of a simulated exo, instead of wall time. clock must outlive the MahiExoII, nullptr goes back to wall time
+        void set_loop_clock(const LoopClock* clock) { m_loop_clock = clock; }
+        /// returns the time since construction on the wall clock, or the elapsed time of the loop clock if one is set
+        mahi::util::Time get_loop_time() const { return m_loop_clock ? m_loop_clock->get_elapsed_time() : m_joint_state_clock.get_elapsed_time(); }
+
+    protected:
+        LoopProfiler m_profiler; // probes around the stages of each tick, including daq_read_all() and daq_write_all() in derived classes
         
     /////////////////// PUBLIC FACING ROBOT STATE ACCESS ///////////////////
 
@@ -173,13 +227,13 @@ namespace meii {
         /// get single anatomical joint velocity
         double get_anatomical_joint_velocity(std::size_t index) const {return m_anatomical_joint_velocities[index];};
         /// get vector of all robot joint positions
-        std::vector<double> get_robot_joint_positions() const { return m_robot_joint_positions;};
+        std::vector<double> get_robot_joint_positions() const { return std::vector<double>(m_joint_state.position.begin(), m_joint_state.position.end());};
         /// get single robot joint position
-        double get_robot_joint_position(std::size_t index) const {return m_robot_joint_positions[index];};
+        double get_robot_joint_position(std::size_t index) const {return m_joint_state.position[index];};
         /// get vector of all robot joint velocities
-        std::vector<double> get_robot_joint_velocities() const {return m_robot_joint_velocities;};
+        std::vector<double> get_robot_joint_velocities() const {return std::vector<double>(m_joint_state.velocity.begin(), m_joint_state.velocity.end());};
         /// get single robot joint velocity
-        double get_robot_joint_velocity(std::size_t index) const {return m_robot_joint_velocities[index];};
+        double get_robot_joint_velocity(std::size_t index) const {return m_joint_state.velocity[index];};
         /// read all commanded joint torques (in joint space) from the desired joint. NOTE THAT THESE ARE COMMANDED TORQUE, SO IT IS NOT YET CLAMPED
         std::vector<double> get_robot_joint_command_torques(std::size_t index) const {return m_robot_joint_torques;};
         /// return the commanded joint torque (in joint space) from the desired joint. NOTE THAT THESE ARE COMMANDED TORQUE, SO IT IS NOT YET CLAMPED
@@ -192,6 +246,28 @@ namespace meii {
         std::vector<double> get_wrist_parallel_positions() const;
         /// read wrist serial positions after using update_kinematics
         std::vector<double> get_wrist_serial_positions() const;
+        /// snapshot of every robot joint, taken by the last call to update_kinematics()
+        const JointState& get_joint_state() const { return m_joint_state; }
+        /// copies the state published by the last update_kinematics() into frame and returns its version. Safe to call from
+        /// any thread, never blocks the control loop, and the frame is never torn
+        mahi::util::uint64 read_state(MeiiStateFrame& frame) const { return m_state_publisher.read(frame); }
+        /// returns the publisher behind read_state(), which reports publish latency and reader retries
+        const Seqlock<MeiiStateFrame>& get_state_publisher() const { return m_state_publisher; }
+
+        // allocation free versions of the getters above, which copy into caller-owned arrays
+
+        /// get all anatomical joint positions
+        void get_anatomical_joint_positions(JointArray& positions) const { std::copy(m_anatomical_joint_positions.begin(), m_anatomical_joint_positions.end(), positions.begin()); }
+        /// get all anatomical joint velocities
+        void get_anatomical_joint_velocities(JointArray& velocities) const { std::copy(m_anatomical_joint_velocities.begin(), m_anatomical_joint_velocities.end(), velocities.begin()); }
+        /// get all robot joint positions
+        void get_robot_joint_positions(JointArray& positions) const { positions = m_joint_state.position; }
+        /// get all robot joint velocities
+        void get_robot_joint_velocities(JointArray& velocities) const { velocities = m_joint_state.velocity; }
+        /// read wrist parallel positions after using update_kinematics
+        void get_wrist_parallel_positions(WristArray& positions) const { std::copy(m_joint_state.position.begin() + 2, m_joint_state.position.end(), positions.begin()); }
+        /// read wrist serial positions after using update_kinematics
+        void get_wrist_serial_positions(WristArray& positions) const { std::copy(m_anatomical_joint_positions.begin() + 2, m_anatomical_joint_positions.end(), positions.begin()); }
     
     public:
         std::vector<double> m_anatomical_joint_velocities; // vector of anatomical joint velocities
@@ -200,8 +276,11 @@ namespace meii {
         // std::vector<double> m_anatomical_joint_velocities; // vector of anatomical joint velocities
         std::vector<double> m_anatomical_joint_torques; // vector of anatomical joint torquescd
 
-        std::vector<double> m_robot_joint_positions; // vector of robot joint positions
-        std::vector<double> m_robot_joint_velocities; // vector of robot joint velociti
+        JointState m_joint_state; // robot joint positions, velocities and torques, read once per tick
+        mahi::util::Clock m_joint_state_clock; // time base of the joint state snapshots without a loop clock
+        const LoopClock* m_loop_clock = nullptr; // time base of the joint state snapshots, if set
+        Seqlock<MeiiStateFrame> m_state_publisher; // state published to other threads every tick
+        MeiiStateFrame m_state_frame;              // frame being built for m_state_publisher
         std::vector<double> m_robot_joint_torques; // vector of robot joint torques
 
     /////////////////// ROBOT AND ANATOMICAL PD CONTROLLERS ///////////////////
@@ -243,59 +322,74 @@ namespace meii {
     ///////////// KINEMATIC UPDATE FUNCTIONS & VARIABLES ///////////////
 
     public:
-        /// update robot forward kinematics from encoder readings
+        /// reads every joint once into the joint state snapshot, and updates robot forward kinematics from it
         void update_kinematics();
+        /// seed the forward kinematics solver with the previous solution (true) or a fixed guess (false)
+        void set_kinematics_warm_start(bool warm_start) { m_kin_warm_start = warm_start; }
+        /// returns iteration statistics of the forward kinematics solver
+        const RpsSolverStats& get_kinematics_stats() const { return m_kin_stats; }
+        /// clears the iteration statistics of the forward kinematics solver
+        void reset_kinematics_stats() { m_kin_stats.reset(); }
+        /// selects the general (12 variable, the default) or reduced (3 variable) forward kinematics solver. The reduced
+        /// solver can converge to a different assembly mode than the general one, check validate_kinematics() before using it
+        void set_kinematics_method(RpsFkMethod method) { m_rps_kinematics.set_forward_method(method); m_kin_cache.clear(); }
+        /// enables reusing cached forward kinematics solutions when the link lengths repeat exactly (enabled by default)
+        void set_kinematics_cache_enabled(bool enabled) { m_kin_cache_enabled = enabled; m_kin_cache.clear(); }
+        /// returns the forward kinematics cache, whose hit and miss counters show how many solves were skipped
+        const RpsKinematicsCache& get_kinematics_cache() const { return m_kin_cache; }
+        /// clears the hit and miss counters of the forward kinematics cache
+        void reset_kinematics_cache_counters() { m_kin_cache.reset_counters(); }
+        /// compares the reduced forward kinematics against the general solver on an n_grid^3 grid spanning the prismatic joint limits
+        RpsValidationResult validate_kinematics(std::size_t n_grid = 10) const;
+        /// compares the loaded forward kinematics lookup table against the general solver at the centers of an n_grid^3 grid spanning the prismatic joint limits
+        RpsValidationResult validate_kinematics_table(std::size_t n_grid = 10) const;
+        /// maps a forward kinematics lookup table (see RpsLookupTable::generate) and uses it in update_kinematics(), after
+        /// logging how far it is from the solver with validate_kinematics_table(check_grid) (0 to skip). Call before the control loop
+        bool load_kinematics_table(const std::string& filepath, std::size_t check_grid = 10);
         
-        static const std::size_t n_qp = 12; // number of rps dependent DoF 
-        static const std::size_t n_qs = 3; // number of rps independent DoF
+        /// solves for the prismatic link positions q_par that place the wrist at q_ser (wrist f/e, r/u deviation, arm translation),
+        /// starting from the last inverse solution. Does not allocate, so it can be called every tick. q_par is only written on success
+        RpsSolveInfo inverse_kinematics(const RpsKinematics::VectorQs& q_ser, RpsKinematics::VectorQs& q_par);
+        /// same as inverse_kinematics, and also maps the serial velocities q_ser_dot to prismatic link velocities q_par_dot
+        RpsSolveInfo inverse_kinematics_velocity(const RpsKinematics::VectorQs& q_ser, const RpsKinematics::VectorQs& q_ser_dot, RpsKinematics::VectorQs& q_par, RpsKinematics::VectorQs& q_par_dot);
+        /// converts n_aj anatomical joint positions to n_rj robot joint positions, returns false if the wrist pose is unreachable.
+        /// robot_pos is resized to n_rj, so passing a correctly sized vector keeps this allocation free
+        bool anatomical_to_robot_positions(const std::vector<double>& anat_pos, std::vector<double>& robot_pos);
+        /// returns the derivative of q_par w.r.t. q_ser at the last inverse solution
+        const RpsKinematics::MatrixJac& get_inverse_kinematics_jacobian() const { return m_jac_ik; }
+        /// returns iteration statistics of the inverse kinematics solver
+        const RpsSolverStats& get_inverse_kinematics_stats() const { return m_ik_stats; }
+        /// clears the iteration statistics of the inverse kinematics solver
+        void reset_inverse_kinematics_stats() { m_ik_stats.reset(); }
+
+        static const std::size_t n_qp = RpsKinematics::n_qp; // number of rps dependent DoF 
+        static const std::size_t n_qs = RpsKinematics::n_qs; // number of rps independent DoF
     private:
-        /// compute the positions of the serial positions (wrist f/e, r/u deviation, forearm length) given the  measurements of the encoders
-        void forward_rps_kinematics(const Eigen::VectorXd& q_par_in, Eigen::VectorXd& q_ser_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_fk, Eigen::MatrixXd& jac_fk) const;
-        /// compute the positions and velocities of the serial positions (wrist f/e, r/u deviation, forearm length) given the  measurements of the encoders
-        void forward_rps_kinematics_velocity(const Eigen::VectorXd& q_par_in, Eigen::VectorXd& q_ser_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_fk, Eigen::MatrixXd& jac_fk, const Eigen::VectorXd& q_par_dot_in, Eigen::VectorXd& q_ser_dot_out, Eigen::VectorXd& qp_dot_out) const;
-        /// compute the positions of the parallel positions (the motors) given desired serial values (wrist f/e, r/u deviation, forearm length)
-        void inverse_rps_kinematics(const Eigen::VectorXd& q_ser_in, Eigen::VectorXd& q_par_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_ik, Eigen::MatrixXd& jac_ik) const;
-        /// compute the positions and velocities of the parallel positions (the motors) given desired serial values (wrist f/e, r/u deviation, forearm length)
-        void inverse_rps_kinematics_velocity(const Eigen::VectorXd& q_ser_in, Eigen::VectorXd& q_par_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_ik, Eigen::MatrixXd& jac_ik, const Eigen::VectorXd& q_ser_dot_in, Eigen::VectorXd& q_par_dot_out, Eigen::VectorXd& qp_dot_out) const;
-        /// generic function to solve for some set of the 12 variables given 3 variables
-        void solve_rps_kinematics(std::vector<mahi::util::uint8> select_q, const Eigen::VectorXd& qs, Eigen::VectorXd& qp, Eigen::MatrixXd& rho, Eigen::MatrixXd& rho_s, mahi::util::uint32 max_it, double tol) const;
-        /// generates the variable *rho* to use in solve_rps_kinematics
-        void generate_rho(std::vector<mahi::util::uint8> select_q, const Eigen::VectorXd& qp, Eigen::MatrixXd& rho) const;
-        /// updates the variable psi
-        void psi_update(const Eigen::MatrixXd& A, const Eigen::VectorXd& qs, const Eigen::VectorXd& qp, Eigen::VectorXd& phi, Eigen::VectorXd& psi) const;
-        /// updates psi_d_qp
-        void psi_d_qp_update(const Eigen::MatrixXd& A, const Eigen::VectorXd& qp, Eigen::MatrixXd& phi_d_qp, Eigen::MatrixXd& psi_d_qp) const;
-        /// updates phi
-        void phi_update(const Eigen::VectorXd& qp, Eigen::VectorXd& phi) const;
-        /// update phi_d_qp
-        void phi_d_qp_update(const Eigen::VectorXd& qp, Eigen::MatrixXd& phi_d_qp) const;
-        /// removes the select_q indices from the vector {0,1,2,3,4,5,6,7,8,9,10,11}
-        std::vector<mahi::util::uint8> select_q_invert(std::vector<mahi::util::uint8> select_q) const;
-
-        // geometric parameters
-        static const double R_; // [m]
-        static const double r_; // [m]
-        static const double a56_; // [m]
-        static const double alpha5_; // [rad]
-        static const double alpha13_; // [rad]
+        RpsKinematics m_rps_kinematics; // fixed-size kinematics engine for the rps mechanism
+        bool m_kin_warm_start = true;   // whether forward kinematics starts from the last solution
+        RpsSolverStats m_kin_stats;     // iteration statistics of the forward kinematics solver
+        RpsKinematicsCache m_kin_cache; // recent forward kinematics solutions, keyed on the link lengths
+        bool m_kin_cache_enabled = true; // whether update_kinematics() consults m_kin_cache
 
         // continuously updated kinematics variables
-        Eigen::VectorXd m_qp = Eigen::VectorXd::Zero(n_qp);
-        Eigen::VectorXd m_q_par = Eigen::VectorXd::Zero(n_qs);
-        Eigen::VectorXd m_q_ser = Eigen::VectorXd::Zero(n_qs);
-        Eigen::VectorXd m_qp_dot = Eigen::VectorXd::Zero(n_qp);
-        Eigen::VectorXd m_q_par_dot = Eigen::VectorXd::Zero(n_qs);
-        Eigen::VectorXd m_q_ser_dot = Eigen::VectorXd::Zero(n_qs);
-        Eigen::VectorXd m_tau_par_rob = Eigen::VectorXd::Zero(n_qs);
-        Eigen::VectorXd m_tau_ser_rob = Eigen::VectorXd::Zero(n_qs);
-        Eigen::MatrixXd m_rho_fk = Eigen::MatrixXd::Zero(n_qp - n_qs, n_qs);
-        Eigen::MatrixXd m_jac_fk = Eigen::MatrixXd::Zero(n_qs, n_qs);
-
-        // kinematics solver setup variables
-        const mahi::util::uint32 m_max_it = 10; // max iterations to perform for kinematics solver
-        const double m_tol = 1e-12; // tolerance for kinematics solver
-        const std::vector<mahi::util::uint8> m_select_q_par = { 3, 4, 5 }; // which q values are used for parallel joints
-        const std::vector<mahi::util::uint8> m_select_q_ser = { 6, 7, 9 }; // which q values are used for anatomical joints
+        RpsKinematics::VectorQp m_qp = RpsKinematics::qp_guess();
+        RpsKinematics::VectorQs m_q_par = RpsKinematics::VectorQs::Zero();
+        RpsKinematics::VectorQs m_q_ser = RpsKinematics::VectorQs::Zero();
+        RpsKinematics::VectorQp m_qp_dot = RpsKinematics::VectorQp::Zero();
+        RpsKinematics::VectorQs m_q_par_dot = RpsKinematics::VectorQs::Zero();
+        RpsKinematics::VectorQs m_q_ser_dot = RpsKinematics::VectorQs::Zero();
+        RpsKinematics::VectorQs m_tau_par_rob = RpsKinematics::VectorQs::Zero();
+        RpsKinematics::VectorQs m_tau_ser_rob = RpsKinematics::VectorQs::Zero();
+        RpsKinematics::MatrixRho m_rho_fk = RpsKinematics::MatrixRho::Zero();
+        RpsKinematics::MatrixJac m_jac_fk = RpsKinematics::MatrixJac::Zero();
+
+        // inverse kinematics state, kept apart from the forward kinematics so each warm starts from its own last solution
+        RpsSolverStats m_ik_stats;     // iteration statistics of the inverse kinematics solver
+        RpsKinematics::VectorQp m_qp_ik = RpsKinematics::qp_guess();
+        RpsKinematics::VectorQp m_qp_dot_ik = RpsKinematics::VectorQp::Zero();
+        RpsKinematics::VectorQs m_q_par_ik = RpsKinematics::VectorQs::Zero();
+        RpsKinematics::MatrixRho m_rho_ik = RpsKinematics::MatrixRho::Zero();
+        RpsKinematics::MatrixJac m_jac_ik = RpsKinematics::MatrixJac::Zero();
 
     //////////////// MISC USEFUL UTILITY FUNCTIONS ////////////////
     
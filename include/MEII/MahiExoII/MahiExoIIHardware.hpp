@@ -86,9 +86,9 @@ namespace meii {
         /// starts the watchdog on the daq
         bool daq_watchdog_kick(){return config_hw.m_daq.watchdog.kick();};
         /// reads all from the daq
-        bool daq_read_all(){return config_hw.m_daq.read_all();};
+        bool daq_read_all(){ LoopProfiler::Probe probe(m_profiler, LoopProfiler::DaqRead); return config_hw.m_daq.read_all(); };
         /// writes all from the daq
-        bool daq_write_all(){return config_hw.m_daq.write_all();};
+        bool daq_write_all(){ LoopProfiler::Probe probe(m_profiler, LoopProfiler::DaqWrite); return config_hw.m_daq.write_all(); };
         /// sets encoders to input position (in counts)
         bool daq_encoder_write(int index, mahi::util::int32 encoder_offset){return config_hw.m_daq.encoder.write(config_hw.m_encoder_channels[index],encoder_offset);};
     };
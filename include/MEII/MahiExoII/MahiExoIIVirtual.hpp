@@ -33,6 +33,12 @@ namespace meii {
 
         MeiiConfigurationVirtual config_vr; // meii configuration, consisting of daq, parameters, etc
 
+        /// returns the simulation the joints are read from, or nullptr if they are read through MelShare
+        std::shared_ptr<SimulatedPlant> get_plant() const { return m_plant; }
+
+    private:
+        std::shared_ptr<SimulatedPlant> m_plant; // simulation the joints are read from, unless config_vr selected VirtualPlant::MelShare
+
     //////////////// OVERRIDING PURE VIRTUAL FUNCTIONS OF MEII ////////////////
     public:
         /// enables the daq
@@ -47,10 +53,10 @@ namespace meii {
         bool daq_watchdog_start(){return true;};
         /// starts the watchdog on the daq
         bool daq_watchdog_kick(){return true;};
-        /// reads all from the daq
-        bool daq_read_all(){return true;};
-        /// writes all from the daq
-        bool daq_write_all(){return true;};
+        /// reads all from the daq, which brings the simulation up to get_loop_time() if there is one
+        bool daq_read_all();
+        /// writes all from the daq, which hands the torques to the simulation if there is one
+        bool daq_write_all();
         /// sets encoders to input position (in counts)
         bool daq_encoder_write(int index, mahi::util::int32 encoder_offset){return true;};
     };
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <MEII/MahiExoII/MeiiParameters.hpp>
+#include <MEII/MahiExoII/MeiiPlant.hpp>
 #include <Mahi/Util/Math/Constants.hpp>
 #include <string>
 #include <vector>
@@ -29,6 +31,14 @@ namespace meii {
 
     class MahiExoIIVirtual;
 
+    /// Where a MahiExoIIVirtual gets its joint positions from
+    enum class VirtualPlant {
+        MelShare,   // an external simulation, such as the Unity sim, through a MelShare per joint and direction
+        Headless,   // a MeiiPlant simulated in process
+        Cosim,      // an external simulation, stepped in lockstep through a CosimLink
+        SharedFrame // an external simulation, through the single shared memory frame "meii_virtual", see SharedFrameLink
+    };
+
     //==============================================================================
     // CLASS DECLARATION
     //==============================================================================
@@ -38,7 +48,8 @@ namespace meii {
 
     public:
 
-        /// Constructor for standard configuration
+        /// Constructor for standard configuration, exchanging the joints with an external simulation through the MelShares
+        /// torque_ms_names and posvel_ms_names
         MeiiConfigurationVirtual(const std::vector<double> rest_positions = {-45*mahi::util::DEG2RAD, 0, 0.0952, 0.0952, 0.0952},
                                  const std::vector<std::string> torque_ms_names = {"ms_torque_1",
                                                                                    "ms_torque_2",
@@ -50,17 +61,46 @@ namespace meii {
                                                                                    "ms_posvel_3",
                                                                                    "ms_posvel_4",
                                                                                    "ms_posvel_5"}):
+            m_plant(VirtualPlant::MelShare),
             m_rest_positions(rest_positions),
             m_torque_ms_names(torque_ms_names),
             m_posvel_ms_names(posvel_ms_names)
             {
             }
 
+        /// Constructor for a configuration that reads the joints from plant, starting at rest_positions until the plant has
+        /// any, for an exo with parameters. MelShare uses the standard names, and SharedFrame the frame "meii_virtual"
+        MeiiConfigurationVirtual(VirtualPlant plant,
+                                 const MeiiPlantParameters& plant_parameters = MeiiPlantParameters(),
+                                 const std::vector<double> rest_positions = {-45*mahi::util::DEG2RAD, 0, 0.0952, 0.0952, 0.0952},
+                                 const MeiiParameters& parameters = MeiiParameters()):
+            MeiiConfigurationVirtual(rest_positions)
+            {
+                m_plant = plant;
+                m_plant_parameters = plant_parameters;
+                m_parameters = parameters;
+            }
+
+        /// Constructor for a configuration that co-simulates the exo with an external simulator through the CosimLink cosim_name, one step per cosim_period
+        MeiiConfigurationVirtual(const std::string& cosim_name, mahi::util::Time cosim_period = mahi::util::milliseconds(1)):
+            MeiiConfigurationVirtual()
+            {
+                m_plant = VirtualPlant::Cosim;
+                m_cosim_name = cosim_name;
+                m_cosim_period = cosim_period;
+            }
+
     private:
 
         friend class MahiExoIIVirtual;
 
-        const std::vector<double> m_rest_positions; // rest positions to use when there is no input from melshare
+        VirtualPlant m_plant;                        // simulation the joints are read from
+        MeiiParameters m_parameters;                 // parameters of the exo
+        MeiiPlantParameters m_plant_parameters;      // parameters of the in-process simulation, if m_plant is Headless
+        std::string m_cosim_name = "meii_cosim";     // shared memory of the co-simulation, if m_plant is Cosim
+        std::string m_frame_name = "meii_virtual";   // shared memory of the joint frame, if m_plant is SharedFrame
+        mahi::util::Time m_cosim_period = mahi::util::milliseconds(1); // simulated time per co-simulation step, if m_plant is Cosim
+        const std::vector<double> m_rest_positions; // rest positions to use when there is no input from the simulation
         const std::vector<std::string> m_torque_ms_names; // names for the torque melshares
         const std::vector<std::string> m_posvel_ms_names; // names for the position and velocity melshares
     };
@@ -0,0 +1,159 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <MEII/MahiExoII/MeiiParameters.hpp>
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <MEII/MahiExoII/SimulatedPlant.hpp>
+#include <Mahi/Util/Timing/Time.hpp>
+#include <array>
+#include <random>
+
+namespace meii {
+
+    /// Stores the constant parameters of the simulated MAHI Exo-II plant.
+    struct MeiiPlantParameters {
+
+        /// Default constructor.
+        MeiiPlantParameters() :
+            //                    JOINT 0             JOINT 1             JOINT 2             JOINT 3             JOINT 4
+            inertia_{                   0.03,         0.005,             0.4,             0.4,             0.4 }, // [kg*m^2] or [kg]
+            damping_{                   0.05,          0.01,             5.0,             5.0,             5.0 }, // [Nm*s/rad] or [N*s/m]
+            friction_{                   0.0,           0.0,             0.0,             0.0,             0.0 }, // [Nm] or [N]
+            position_noise_{             0.0,           0.0,             0.0,             0.0,             0.0 }, // [rad] or [m]
+            velocity_noise_{             0.0,           0.0,             0.0,             0.0,             0.0 }, // [rad/s] or [m/s]
+            //                    WRIST F/E           WRIST R/U           ARM TRANSLATION
+            wrist_inertia_{            0.0005,        0.0005,            0.05 }, // [kg*m^2] or [kg]
+            substep_rate_(10000.0),
+            max_step_(mahi::util::milliseconds(50)),
+            seed_(0)
+        { }
+
+        /// inertia of each joint, for the RPS links this includes a third of the platform [kg*m^2] or [kg]
+        std::array<double, 5> inertia_;
+        /// viscous friction of each joint [Nm*s/rad] or [N*s/m]
+        std::array<double, 5> damping_;
+        /// coulomb friction of each joint [Nm] or [N]
+        std::array<double, 5> friction_;
+        /// standard deviation of the noise on each measured joint position [rad] or [m]
+        std::array<double, 5> position_noise_;
+        /// standard deviation of the noise on each measured joint velocity [rad/s] or [m/s]
+        std::array<double, 5> velocity_noise_;
+        /// inertia of the RPS platform about the serial coordinates, on top of the link inertias, which keeps the wrist from moving freely where the links do not constrain it [kg*m^2] or [kg]
+        std::array<double, 3> wrist_inertia_;
+        /// rate the dynamics are integrated at [Hz]
+        double substep_rate_;
+        /// longest interval integrated by one step(), longer ones are shortened to this so a paused loop does not stall on catching up
+        mahi::util::Time max_step_;
+        /// seed of the sensor noise, plants with the same seed measure the same noise
+        mahi::util::uint64 seed_;
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Simulated MAHI Exo-II for closed-loop testing without the hardware or the Unity sim. Each
+    /// robot joint is a rigid body driven by its joint torque against viscous and coulomb friction,
+    /// and hits a hard stop at the position limits of MeiiParameters, where its velocity into the
+    /// stop is removed. Gravity is not modelled. The dynamics are integrated at a fixed substep
+    /// rate with semi-implicit Euler, which is stable for any damping. The positions and velocities
+    /// read back carry gaussian sensor noise, drawn once per update().
+    ///
+    /// The RPS wrist is integrated in its serial coordinates (wrist f/e, r/u and arm translation),
+    /// so every state it reaches is an assembly of the mechanism, and the link lengths read back
+    /// follow from the inverse kinematics. The inertia, friction and forces of the three links map
+    /// onto the serial coordinates through jac_ik, and add to the inertia of the platform itself.
+    /// The link stops, and the singularities of jac_ik that bound the working assembly mode, act
+    /// as hard stops on the wrist. If a substep finds no assembly the wrist holds still for it,
+    /// which is logged once and counted by get_wrist_holds().
+    class MeiiPlant : public SimulatedPlant {
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        static const std::size_t n_joints = 5; // number of robot joints
+
+        /// Constructor, every joint starts at rest at positions [rad] or [m]
+        MeiiPlant(const MeiiPlantParameters& plant_params, const MeiiParameters& params, const std::array<double, n_joints>& positions);
+
+        /// advances the simulation by the time since the last update(), or not at all if time is behind it, and measures the joints
+        bool update(mahi::util::Time time) override;
+        /// does nothing, torques act from the moment they are set
+        bool apply() override { return true; }
+        /// advances the simulation by dt, integrating whole substeps and carrying the remainder to the next call
+        void step(mahi::util::Time dt);
+        /// puts every joint at rest at positions, clears the torques and restarts the sensor noise [rad] or [m].
+        /// Returns false if the link lengths have no assembly, in which case the wrist starts at the nominal pose
+        bool reset(const std::array<double, n_joints>& positions);
+
+        /// sets the torque applied to a joint until the next call [Nm] or [N]
+        void set_torque(std::size_t joint, double torque) override { m_torque[joint] = torque; }
+        /// returns the position of a joint measured by the last update() [rad] or [m]
+        double get_position(std::size_t joint) const override { return m_measured_position[joint]; }
+        /// returns the velocity of a joint measured by the last update() [rad/s] or [m/s]
+        double get_velocity(std::size_t joint) const override { return m_measured_velocity[joint]; }
+        /// returns the true position of a joint, without sensor noise [rad] or [m]
+        double get_true_position(std::size_t joint) const { return m_position[joint]; }
+        /// returns the true velocity of a joint, without sensor noise [rad/s] or [m/s]
+        double get_true_velocity(std::size_t joint) const { return m_velocity[joint]; }
+        /// returns the torque applied to a joint [Nm] or [N]
+        double get_torque(std::size_t joint) const { return m_torque[joint]; }
+        /// returns the simulated time integrated so far
+        mahi::util::Time get_time() const { return mahi::util::microseconds(static_cast<mahi::util::int64>(m_substeps * m_substep * 1e6)); }
+        /// returns the true wrist f/e, r/u and arm translation [rad] or [m]
+        const RpsKinematics::VectorQs& get_wrist_position() const { return m_q_ser; }
+        /// returns the number of substeps the wrist held still because the RPS mechanism had no assembly along its step
+        mahi::util::uint64 get_wrist_holds() const { return m_wrist_holds; }
+
+    private:
+        /// integrates one substep
+        void substep();
+        /// integrates one substep of the RPS wrist in serial coordinates
+        void substep_wrist();
+        /// returns the derivative of det(jac_ik) w.r.t. the serial coordinates at the current wrist position
+        RpsKinematics::VectorQs wrist_det_gradient() const;
+        /// solves the link lengths and jac_ik at the serial coordinates q_ser, warm from qp, returns true if they are an assembly of the working mode within slack of the stops.
+        /// jac_ik is only written once the solver converges
+        bool solve_wrist(const RpsKinematics::VectorQs& q_ser, RpsKinematics::VectorQp& qp, RpsKinematics::VectorQs& q_par, RpsKinematics::MatrixJac& jac_ik, double slack) const;
+        /// adds sensor noise to the true positions and velocities
+        void measure();
+
+        MeiiPlantParameters m_plant_params;            // inertias, damping and substep rate
+        std::array<double, n_joints> m_pos_min;       // lower hard stops [rad] or [m]
+        std::array<double, n_joints> m_pos_max;       // upper hard stops [rad] or [m]
+        std::array<double, n_joints> m_position;      // joint positions [rad] or [m]
+        std::array<double, n_joints> m_velocity;      // joint velocities [rad/s] or [m/s]
+        std::array<double, n_joints> m_torque;        // applied joint torques [Nm] or [N]
+        std::array<double, n_joints> m_measured_position; // positions with sensor noise [rad] or [m]
+        std::array<double, n_joints> m_measured_velocity; // velocities with sensor noise [rad/s] or [m/s]
+        std::mt19937_64 m_noise_rng;                  // draws the sensor noise
+        std::normal_distribution<double> m_noise;     // standard normal sensor noise
+        double m_substep;                             // length of a substep [s]
+        double m_pending;                             // time passed to step() but not yet integrated [s]
+        mahi::util::uint64 m_substeps;                // substeps integrated
+        mahi::util::Time m_update_time;               // time of the last update()
+        RpsKinematics m_rps;                          // kinematics of the RPS wrist
+        RpsKinematics::VectorQs m_q_ser;              // wrist f/e, r/u and arm translation [rad] or [m]
+        RpsKinematics::VectorQs m_q_ser_dot;          // velocities of the serial coordinates [rad/s] or [m/s]
+        RpsKinematics::VectorQp m_qp;                 // all 12 rps variables at m_q_ser, warm start of the next substep
+        RpsKinematics::MatrixJac m_jac_ik;            // derivative of the link lengths w.r.t. the serial coordinates at m_q_ser
+        mahi::util::uint64 m_wrist_holds;             // substeps the wrist held still for lack of an assembly
+    };
+
+} // namespace meii
@@ -0,0 +1,145 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <MEII/MahiExoII/MahiExoII.hpp>
+#include <MEII/Utility/LoopClock.hpp>
+#include <MEII/Utility/SpscQueue.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include <Mahi/Util/Timing/Time.hpp>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace meii {
+
+    /// Text posted from the real-time thread with MeiiRuntime::post_message()
+    struct RuntimeMessage {
+        mahi::util::Severity severity; // severity the worker logs the message with
+        mahi::util::uint64 tick;       // real-time tick the message was posted on
+        char text[112];                // null terminated, longer messages are truncated
+    };
+
+    /// Counters describing how a MeiiRuntime has kept up so far
+    struct RuntimeStats {
+        mahi::util::uint64 ticks = 0;             // real-time ticks completed
+        mahi::util::uint64 overruns = 0;          // ticks whose work took longer than the period
+        mahi::util::Time max_tick_time;           // longest read-kinematics-control-write cycle
+        mahi::util::uint64 telemetry_dropped = 0; // state frames dropped because the worker fell behind
+        mahi::util::uint64 messages_dropped = 0;  // messages dropped because the worker fell behind
+        mahi::util::uint64 keys_dropped = 0;      // key presses dropped because the control callback did not poll them
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Runs a MahiExoII on two threads. The real-time thread, optionally pinned to a core and
+    /// raised to real-time priority, does nothing but daq read -> update_kinematics -> control
+    /// callback -> daq write at a fixed period. Everything that can stall (MelShare, console
+    /// output, logs, keyboard polling) happens on a worker thread, connected to the real-time
+    /// thread only by bounded SpscQueues that drop and count instead of blocking:
+    ///
+    /// - every tick's MeiiStateFrame goes to the telemetry callback on the worker
+    /// - text from post_message() is logged by the worker
+    /// - key presses read by the worker are handed to the control callback through poll_key()
+    class MeiiRuntime {
+    public:
+        /// Called on the real-time thread after update_kinematics() with the time since start(). Sets the
+        /// command torques, and returns false to stop the runtime. Must not block or allocate
+        typedef std::function<bool(MahiExoII& meii, mahi::util::Time time)> ControlCallback;
+        /// Called on the worker thread with the state frame of every tick, in order
+        typedef std::function<void(const MeiiStateFrame& frame)> TelemetryCallback;
+
+        /// Constructor
+        MeiiRuntime(MahiExoII& meii, mahi::util::Time period = mahi::util::milliseconds(1), std::size_t queue_capacity = 1024);
+        /// Destructor, stops both threads
+        ~MeiiRuntime();
+        MeiiRuntime(const MeiiRuntime&) = delete;
+        MeiiRuntime& operator=(const MeiiRuntime&) = delete;
+
+        /// sets the control callback, only while stopped
+        void set_control(ControlCallback control) { m_control = control; }
+        /// sets the telemetry callback, only while stopped
+        void set_telemetry(TelemetryCallback telemetry) { m_telemetry = telemetry; }
+        /// pins the real-time thread to cpu and raises it to real-time priority (-1 to leave it to the OS), only while stopped
+        void set_rt_cpu(int cpu) { m_rt_cpu = cpu; }
+        /// starts the daq watchdog on start() and kicks it every tick, only while stopped
+        void set_watchdog(bool enabled) { m_watchdog = enabled; }
+        /// polls the keyboard on the worker thread and passes keys to poll_key(), only while stopped
+        void set_keyboard(bool enabled) { m_keyboard = enabled; }
+        /// sets how often the worker thread wakes up to drain the queues, only while stopped
+        void set_worker_period(mahi::util::Time period) { m_worker_period = period; }
+        /// sets whether ticks are paced in real time or stepped in lockstep as fast as possible, see LoopClock, only while stopped
+        void set_clock_mode(LoopClock::Mode mode) { m_clock_mode = mode; }
+
+        /// starts the real-time and worker threads, returns false if already running
+        bool start();
+        /// asks both threads to stop after the current tick, callable from any thread
+        void request_stop() { m_stop_requested = true; }
+        /// waits for both threads to finish, the worker drains the queues before it exits
+        void join();
+        /// runs until the control callback returns false, request_stop() is called or stop_flag becomes true
+        void run(const std::atomic<bool>& stop_flag);
+        /// returns true between start() and the end of join()
+        bool is_running() const { return m_running; }
+
+        /// queues text to be logged by the worker, returns false if it was dropped (control callback only)
+        bool post_message(mahi::util::Severity severity, const char* text);
+        /// takes the oldest key press read by the worker, returns false if there is none (control callback only)
+        bool poll_key(int& key) { return m_keys.pop(key); }
+
+        /// returns counters describing how the runtime has kept up, callable from any thread
+        RuntimeStats get_stats() const;
+
+    private:
+        /// body of the real-time thread
+        void rt_loop();
+        /// body of the worker thread
+        void worker_loop();
+        /// passes queued frames to the telemetry callback and logs queued messages
+        void drain();
+
+        MahiExoII& m_meii;                     // robot being run
+        const mahi::util::Time m_period;       // real-time tick period
+        mahi::util::Time m_worker_period;      // worker wake up period
+        ControlCallback m_control;             // user control law
+        TelemetryCallback m_telemetry;         // user telemetry sink
+        int m_rt_cpu = -1;                     // core the real-time thread is pinned to, -1 for none
+        bool m_watchdog = false;               // whether the daq watchdog is used
+        bool m_keyboard = false;               // whether the worker polls the keyboard
+        LoopClock::Mode m_clock_mode = LoopClock::RealTime; // how the real-time thread paces ticks
+
+        SpscQueue<MeiiStateFrame> m_frames;    // real-time -> worker, state of every tick
+        SpscQueue<RuntimeMessage> m_messages;  // real-time -> worker, text to log
+        SpscQueue<int> m_keys;                 // worker -> real-time, key presses
+
+        std::thread m_rt_thread;               // runs rt_loop()
+        std::thread m_worker_thread;           // runs worker_loop()
+        std::atomic<bool> m_running;           // true between start() and join()
+        std::atomic<bool> m_stop_requested;    // set to end both loops
+        std::atomic<bool> m_rt_done;           // set when the real-time loop has exited
+
+        mahi::util::uint64 m_tick = 0;         // current real-time tick, only touched on the real-time thread
+        std::atomic<mahi::util::uint64> m_ticks;          // ticks completed
+        std::atomic<mahi::util::uint64> m_overruns;       // ticks longer than the period
+        std::atomic<mahi::util::int64> m_max_tick_us;     // longest tick [us]
+    };
+
+} // namespace meii
@@ -0,0 +1,40 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Types.hpp>
+#include <array>
+
+namespace meii {
+
+    /// State of the MAHI Exo-II published by MahiExoII::update_kinematics() every tick, for
+    /// threads other than the control loop (GUIs, bridges, loggers). See MahiExoII::read_state().
+    struct MeiiStateFrame {
+        mahi::util::uint64 tick = 0;                    // JointState::tick of the snapshot this frame was built from
+        double time = 0;                                // JointState::time of that snapshot [s]
+        bool kinematics_converged = false;              // whether the forward kinematics converged on this tick
+        std::array<double, 5> robot_positions;          // robot joint positions [rad] or [m]
+        std::array<double, 5> robot_velocities;         // robot joint velocities [rad/s] or [m/s]
+        std::array<double, 5> robot_torques;            // robot joint torques being applied, after saturation [Nm] or [N]
+        std::array<double, 5> anatomical_positions;     // anatomical joint positions [rad] or [m]
+        std::array<double, 5> anatomical_velocities;    // anatomical joint velocities [rad/s] or [m/s]
+        std::array<double, 5> anatomical_torques;       // anatomical joint torques last commanded [Nm] or [N]
+    };
+
+} // namespace meii
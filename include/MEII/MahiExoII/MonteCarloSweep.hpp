@@ -0,0 +1,174 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+#pragma once
+
+#include <MEII/MahiExoII/MahiExoII.hpp>
+#include <MEII/MahiExoII/MeiiParameters.hpp>
+#include <MEII/MahiExoII/MeiiPlant.hpp>
+#include <MEII/MahiExoII/SafetyMonitor.hpp>
+#include <Mahi/Util/Timing/Time.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <array>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace meii {
+
+    /// How the simulated sessions of a MonteCarloSweep differ from the nominal exo and plant
+    struct SweepVariation {
+        static const std::size_t n_joints = MeiiPlant::n_joints; // number of robot joints
+
+        double inertia_spread = 0.0;                 // each joint's inertia is scaled by a uniform factor in [1 - spread, 1 + spread]
+        double damping_spread = 0.0;                 // each joint's viscous friction is scaled by a uniform factor in [1 - spread, 1 + spread]
+        double friction_spread = 0.0;                // each joint's coulomb friction is scaled by a uniform factor in [1 - spread, 1 + spread]
+        std::array<double, n_joints> position_noise; // standard deviation of the position sensor noise of each joint [rad] or [m]
+        std::array<double, n_joints> velocity_noise; // standard deviation of the velocity sensor noise of each joint [rad/s] or [m/s]
+        /// draws the MeiiParameters of a session from the nominal ones, if set. Parameters that appear in limit
+        /// messages, such as the torque limits, register new events in event_log() for every distinct value
+        std::function<void(std::mt19937_64& rng, MeiiParameters& parameters)> vary_parameters;
+
+        /// Constructor, every session is the nominal exo without sensor noise
+        SweepVariation() {
+            position_noise.fill(0.0);
+            velocity_noise.fill(0.0);
+        }
+    };
+
+    /// Outcome of one simulated session of a MonteCarloSweep
+    struct SweepSession {
+        static const std::size_t n_joints = MahiExoII::n_aj; // number of anatomical joints
+
+        std::size_t index = 0;                          // index of the session in the sweep
+        MeiiPlantParameters plant_parameters;           // plant the session was simulated with
+        MeiiParameters parameters;                      // parameters of the exo
+        std::array<double, n_joints> rms_error;         // RMS anatomical tracking error of each joint [rad] or [m]
+        std::array<double, n_joints> max_error;         // largest anatomical tracking error of each joint [rad] or [m]
+        std::array<mahi::util::uint64, n_joints> saturated_ticks; // ticks each robot joint's command torque was saturated
+        mahi::util::uint64 any_saturated_ticks = 0;     // ticks any robot joint's command torque was saturated
+        mahi::util::uint64 ticks = 0;                   // ticks run
+        mahi::util::uint32 trip = 0;                    // SafetyMonitor limits that stopped the session, 0 if none did
+        mahi::util::Time time;                          // simulated time the session ended at
+        bool ran = false;                               // whether the exo enabled and read its plant on every tick
+
+        /// Constructor
+        SweepSession() {
+            rms_error.fill(0.0);
+            max_error.fill(0.0);
+            saturated_ticks.fill(0);
+        }
+    };
+
+    /// Aggregate of every session of a MonteCarloSweep
+    struct SweepSummary {
+        static const std::size_t n_joints = MahiExoII::n_aj; // number of anatomical joints
+
+        std::size_t sessions = 0;                       // sessions run
+        std::size_t failed = 0;                         // sessions whose exo did not enable or lost its plant
+        std::size_t tripped = 0;                        // sessions stopped by a limit
+        std::array<std::size_t, SafetyMonitor::n_limits> limit_trips; // sessions stopped by each SafetyMonitor::Limit
+        mahi::util::uint64 ticks = 0;                   // ticks run by every session
+        mahi::util::uint64 saturated_ticks = 0;         // ticks any robot joint was saturated, over every session
+        std::array<double, n_joints> mean_rms_error;    // mean over the sessions of each joint's RMS tracking error [rad] or [m]
+        std::array<double, n_joints> p95_rms_error;     // 95th percentile over the sessions of each joint's RMS tracking error [rad] or [m]
+        std::array<double, n_joints> max_error;         // largest tracking error of each joint in any session [rad] or [m]
+        std::size_t worst_session = 0;                  // session with the largest RMS tracking error relative to the mean
+        mahi::util::Time simulated_time;                // simulated time of every session
+        mahi::util::Time wall_time;                     // time the sweep took
+        std::size_t threads = 0;                        // worker threads the sweep ran on
+
+        /// Constructor
+        SweepSummary() {
+            limit_trips.fill(0);
+            mean_rms_error.fill(0.0);
+            p95_rms_error.fill(0.0);
+            max_error.fill(0.0);
+        }
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Runs the same protocol on many independent simulated MAHI Exo-IIs, each a headless
+    /// MahiExoIIVirtual stepped in lockstep, to see how robust a controller is to the exo it runs
+    /// on. Every session draws its plant (inertia, friction, sensor noise) and MeiiParameters from
+    /// a SweepVariation, runs until the protocol finishes or a limit trips, and records its
+    /// tracking error, saturation and trips. The sessions share nothing but event_log(), so they
+    /// run on a WorkStealingPool across every core and throughput scales with the cores. Each
+    /// session's variations and noise are seeded by the sweep's seed and the session's index,
+    /// so a sweep gives the same sessions however many threads run it.
+    class MonteCarloSweep {
+    public:
+        /// Called once per tick of a session after update_kinematics() with the simulated time. Sets the exo's
+        /// torques and writes the anatomical reference it is tracking to ref, and returns false once finished
+        typedef std::function<bool(MahiExoII& meii, mahi::util::Time time, MahiExoII::JointArray& ref)> Protocol;
+        /// Returns a new Protocol for each session, so protocols can keep their own state
+        typedef std::function<Protocol()> ProtocolFactory;
+
+        /// Constructor, for sessions sessions ticking every period
+        MonteCarloSweep(std::size_t sessions, mahi::util::Time period = mahi::util::milliseconds(1));
+
+        /// sets the nominal plant the sessions vary
+        void set_plant_parameters(const MeiiPlantParameters& plant_parameters) { m_plant_parameters = plant_parameters; }
+        /// sets the nominal parameters the sessions vary
+        void set_parameters(const MeiiParameters& parameters) { m_parameters = parameters; }
+        /// sets how the sessions vary
+        void set_variation(const SweepVariation& variation) { m_variation = variation; }
+        /// sets the robot joint positions every session starts at rest at [rad] or [m]
+        void set_rest_positions(const std::vector<double>& rest_positions) { m_rest_positions = rest_positions; }
+        /// sets the seed the sessions are drawn from
+        void set_seed(mahi::util::uint64 seed) { m_seed = seed; }
+        /// sets the number of worker threads, 0 for one per core
+        void set_threads(std::size_t threads) { m_threads = threads; }
+        /// sets the simulated time after which a session is stopped if its protocol has not finished
+        void set_max_time(mahi::util::Time max_time) { m_max_time = max_time; }
+
+        /// runs a protocol from make_protocol on every session and returns false if any session failed to run
+        bool run(const ProtocolFactory& make_protocol);
+        /// runs a single session, as run() does on each worker
+        SweepSession run_session(std::size_t index, const ProtocolFactory& make_protocol) const;
+
+        /// returns the sessions of the last run(), in index order
+        const std::vector<SweepSession>& get_sessions() const { return m_sessions; }
+        /// returns the aggregate of the last run()
+        const SweepSummary& get_summary() const { return m_summary; }
+        /// describes the aggregate of the last run()
+        std::string report() const;
+
+    private:
+        /// draws the plant and parameters of session index
+        void draw(std::size_t index, SweepSession& session) const;
+        /// aggregates m_sessions into m_summary
+        void summarize(mahi::util::Time wall_time, std::size_t threads);
+
+        const std::size_t m_session_count;              // sessions per run()
+        const mahi::util::Time m_period;                // period of each session's loop
+        MeiiPlantParameters m_plant_parameters;         // nominal plant
+        MeiiParameters m_parameters;                    // nominal exo
+        SweepVariation m_variation;                     // how the sessions vary
+        std::vector<double> m_rest_positions;           // robot joint positions the sessions start at [rad] or [m]
+        mahi::util::uint64 m_seed = 0;                  // seed of the sessions
+        std::size_t m_threads = 0;                      // worker threads, 0 for one per core
+        mahi::util::Time m_max_time;                    // longest simulated session
+        std::vector<SweepSession> m_sessions;           // sessions of the last run()
+        SweepSummary m_summary;                         // aggregate of the last run()
+    };
+
+} // namespace meii
@@ -0,0 +1,77 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+#pragma once
+
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <Mahi/Util/Types.hpp>
+
+namespace meii {
+
+    /// Summary of a batch kinematics call
+    struct RpsBatchResult {
+        std::size_t samples = 0;   // number of samples processed
+        std::size_t fallbacks = 0; // inverse samples the closed form could not solve, which were handed to RpsKinematics::solve()
+        std::size_t failures = 0;  // samples that could not be solved at all (outputs are NaN)
+        double seconds = 0;        // wall time of the call [s]
+        /// throughput of the call [samples/s]
+        double samples_per_second() const { return seconds > 0 ? samples / seconds : 0; }
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Forward and inverse kinematics of the wrist RPS mechanism for many samples at
+    /// once, for offline tools (log post-processing, workspace plots, ROM analysis).
+    ///
+    /// Inputs and outputs are structure-of-arrays: three separate arrays of n doubles.
+    /// Samples are processed in blocks of #lanes, and the blocks are split across threads.
+    ///
+    /// The forward kinematics runs the general RpsKinematics solver on each lane, so it
+    /// ends on the same assembly mode as MahiExoII does online. The inverse kinematics
+    /// needs no iteration: the leg plane constraints are linear in (q10, q11, cos(q8),
+    /// sin(q8)), which gives q8 in closed form and q10, q11 from a constant pseudo-inverse.
+    /// Every operation of the inverse is written as a loop over the lanes of a block so the
+    /// compiler can map it onto SIMD registers (build with MEII_NATIVE_ARCH for AVX2/AVX-512).
+    /// Each closed form lane is checked by a round trip through the reduced 3 variable
+    /// Newton iteration of RpsKinematics on every lane at once, since the q8 root it picks
+    /// is not always the assembly mode. Lanes whose round trip misses fall back on the
+    /// general RpsKinematics solver.
+    class RpsBatchKinematics {
+
+    public:
+        static const std::size_t lanes = 8; // samples per block, one AVX-512 register of doubles
+
+        /// Constructor, n_threads = 0 uses every hardware thread. max_it and tol apply to the inverse round trip
+        RpsBatchKinematics(std::size_t n_threads = 0, mahi::util::uint32 max_it = 20, double tol = 1e-12);
+
+        /// computes q_ser (wrist f/e, r/u deviation, forearm length) for n samples of q_par (the three link lengths)
+        RpsBatchResult forward(std::size_t n, const double* const q_par[3], double* const q_ser[3], unsigned char* converged = nullptr) const;
+        /// computes q_par (the three link lengths) for n samples of q_ser (wrist f/e, r/u deviation, forearm length)
+        RpsBatchResult inverse(std::size_t n, const double* const q_ser[3], double* const q_par[3], unsigned char* converged = nullptr) const;
+
+        /// returns the number of threads used
+        std::size_t get_thread_count() const { return m_n_threads; }
+
+    private:
+        std::size_t m_n_threads;     // number of threads to split the samples across
+        mahi::util::uint32 m_max_it; // max iterations of the reduced forward kinematics in the inverse round trip
+        double m_tol;                // tolerance of the reduced forward kinematics in the inverse round trip
+    };
+
+} // namespace meii
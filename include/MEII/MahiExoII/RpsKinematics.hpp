@@ -0,0 +1,217 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+#pragma once
+
+#include <Mahi/Util/Types.hpp>
+#include <Eigen/Dense>
+#include <Eigen/LU>
+#include <array>
+#include <memory>
+
+namespace meii {
+
+    class RpsLookupTable;
+
+    //==============================================================================
+    // SELECTION INDEX SETS
+    //==============================================================================
+
+    /// Describes which 3 of the 12 RPS variables are specified when solving the kinematics
+    struct RpsSelection {
+        std::array<mahi::util::uint8, 3> q; // indices of the specified (independent) variables
+        std::array<mahi::util::uint8, 9> b; // indices of the remaining (dependent) variables, in ascending order
+    };
+
+    /// selection for forward kinematics, the three prismatic link lengths are specified
+    constexpr RpsSelection rps_select_par = { {{ 3, 4, 5 }}, {{ 0, 1, 2, 6, 7, 8, 9, 10, 11 }} };
+    /// selection for inverse kinematics, wrist f/e, r/u and arm translation are specified
+    constexpr RpsSelection rps_select_ser = { {{ 6, 7, 9 }}, {{ 0, 1, 2, 3, 4, 5, 8, 10, 11 }} };
+
+    //==============================================================================
+    // SOLVER DIAGNOSTICS
+    //==============================================================================
+
+    /// Summary of a single kinematics solve
+    struct RpsSolveInfo {
+        mahi::util::uint32 iterations = 0; // Newton iterations performed, including any cold restart
+        double residual = 0;               // norm of the constraint error at the last iteration
+        bool converged = false;            // true if the residual dropped below the tolerance
+        bool warm_started = false;         // true if the solve was seeded with the previous solution
+        bool cold_restart = false;         // true if the warm start diverged and the solve fell back to the cold guess
+        bool table_lookup = false;         // true if the solution was interpolated from a lookup table (residual is not computed)
+    };
+
+    /// Running statistics over many kinematics solves
+    struct RpsSolverStats {
+        static const std::size_t n_bins = 16; // last bin collects every solve with n_bins-1 or more iterations
+
+        /// Constructor
+        RpsSolverStats() { reset(); }
+        /// adds a solve to the statistics
+        void record(const RpsSolveInfo& info);
+        /// clears all statistics
+        void reset();
+        /// mean number of Newton iterations per solve
+        double mean_iterations() const;
+
+        std::array<mahi::util::uint64, n_bins> iteration_histogram; // number of solves that took [i] iterations
+        mahi::util::uint64 solves;        // total number of solves
+        mahi::util::uint64 warm_starts;   // solves seeded with the previous solution
+        mahi::util::uint64 cold_restarts; // warm starts that diverged and were restarted from the cold guess
+        mahi::util::uint64 failures;      // solves that never reached the tolerance
+        mahi::util::uint64 table_lookups; // solves answered by a lookup table
+        RpsSolveInfo last;                // most recent solve
+    };
+
+    /// Result of comparing the reduced forward kinematics, or a lookup table, with the general solver over a grid of link lengths
+    struct RpsValidationResult {
+        mahi::util::uint32 samples = 0;          // grid points evaluated
+        mahi::util::uint32 general_failures = 0; // points where the general solver did not converge (not compared)
+        mahi::util::uint32 reduced_failures = 0; // points where the general solver converged but the reduced one did not (reduced only)
+        mahi::util::uint32 table_misses = 0;     // points where the table had no data (table only)
+        mahi::util::uint32 branch_mismatches = 0; // points where both converged, but to different assembly modes (q_ser differs by more than 1e-6), never counted for a table
+        double max_q_ser_error = 0;              // largest difference in q_ser where both found the same assembly mode
+        double max_jac_fk_error = 0;             // largest difference in jac_fk where both found the same assembly mode, relative to the largest entry of jac_fk
+        Eigen::Vector3d worst_q_par = Eigen::Vector3d::Zero(); // link lengths giving the largest q_ser difference
+    };
+
+    /// Algorithm used to solve the forward kinematics
+    enum class RpsFkMethod {
+        General, // Newton iteration over all 12 variables and 9 constraints
+        Reduced, // Newton iteration over the 3 leg angles, using the symmetry of the platform
+        Table    // interpolation of qp from a precomputed RpsLookupTable, with rho from one factorization at that qp, using General wherever the table has no data
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Fixed-size kinematics engine for the wrist RPS mechanism of the MAHI Exo-II.
+    /// All temporaries live on the stack, so solving does not touch the heap. When
+    /// warm_start is true, qp on input is taken as the initial guess (typically the
+    /// solution from the previous tick); otherwise the fixed cold guess is used.
+    ///
+    /// The reduced forward kinematics uses the fact that the three platform joints
+    /// sit r_ from the platform center, 120 degrees apart, so any two are r_*sqrt(3)
+    /// apart. Solving those three distance constraints for the three leg angles fixes
+    /// the platform joints, and the platform pose follows in closed form.
+    ///
+    /// The general solver never factorizes the full 12x12 jacobian of psi. Its bottom
+    /// three rows only select the specified variables, so each Newton step sets those
+    /// directly and solves the 9x9 block of phi w.r.t. the remaining variables. The
+    /// factorization from the last step is reused for rho = -phi_d_qb^-1 * phi_d_qs.
+    class RpsKinematics {
+
+    public:
+        static const std::size_t n_qp = 12; // number of rps dependent DoF
+        static const std::size_t n_qs = 3;  // number of rps independent DoF
+        static const std::size_t n_qb = 9;  // number of kinematic constraints
+
+        typedef Eigen::Matrix<double, n_qp, 1>    VectorQp;   // all 12 rps variables
+        typedef Eigen::Matrix<double, n_qs, 1>    VectorQs;   // 3 specified variables
+        typedef Eigen::Matrix<double, n_qb, 1>    VectorQb;   // 9 constraints / remaining variables
+        typedef Eigen::Matrix<double, n_qb, n_qp> MatrixPhi;  // derivative of the constraints w.r.t. qp
+        typedef Eigen::Matrix<double, n_qp, n_qp> MatrixPsi;  // derivative of the constraints and selection w.r.t. qp
+        typedef Eigen::Matrix<double, n_qb, n_qb> MatrixPhiB; // derivative of the constraints w.r.t. the remaining variables
+        typedef Eigen::Matrix<double, n_qb, n_qs> MatrixRho;  // derivative of the remaining variables w.r.t. the specified ones
+        typedef Eigen::Matrix<double, n_qp, n_qs> MatrixRhoS; // derivative of all variables w.r.t. the specified ones
+        typedef Eigen::Matrix<double, n_qs, n_qs> MatrixJac;  // forward or inverse kinematics jacobian
+
+        /// Constructor
+        RpsKinematics(mahi::util::uint32 max_it = 10, double tol = 1e-12);
+
+        /// sets the algorithm used by forward() and forward_velocity()
+        void set_forward_method(RpsFkMethod method) { m_fk_method = method; }
+        /// returns the algorithm used by forward() and forward_velocity()
+        RpsFkMethod get_forward_method() const { return m_fk_method; }
+        /// sets the lookup table used by RpsFkMethod::Table
+        void set_lookup_table(std::shared_ptr<const RpsLookupTable> table) { m_table = table; }
+        /// returns the lookup table used by RpsFkMethod::Table
+        const std::shared_ptr<const RpsLookupTable>& get_lookup_table() const { return m_table; }
+
+        /// compute the positions of the serial positions (wrist f/e, r/u deviation, forearm length) given the  measurements of the encoders
+        RpsSolveInfo forward(const VectorQs& q_par_in, VectorQs& q_ser_out, VectorQp& qp_out, MatrixRho& rho_fk, MatrixJac& jac_fk, bool warm_start = false) const;
+        /// compute the positions and velocities of the serial positions (wrist f/e, r/u deviation, forearm length) given the  measurements of the encoders
+        RpsSolveInfo forward_velocity(const VectorQs& q_par_in, VectorQs& q_ser_out, VectorQp& qp_out, MatrixRho& rho_fk, MatrixJac& jac_fk, const VectorQs& q_par_dot_in, VectorQs& q_ser_dot_out, VectorQp& qp_dot_out, bool warm_start = false) const;
+        /// compute the positions of the parallel positions (the motors) given desired serial values (wrist f/e, r/u deviation, forearm length)
+        RpsSolveInfo inverse(const VectorQs& q_ser_in, VectorQs& q_par_out, VectorQp& qp_out, MatrixRho& rho_ik, MatrixJac& jac_ik, bool warm_start = false) const;
+        /// compute the positions and velocities of the parallel positions (the motors) given desired serial values (wrist f/e, r/u deviation, forearm length)
+        RpsSolveInfo inverse_velocity(const VectorQs& q_ser_in, VectorQs& q_par_out, VectorQp& qp_out, MatrixRho& rho_ik, MatrixJac& jac_ik, const VectorQs& q_ser_dot_in, VectorQs& q_par_dot_out, VectorQp& qp_dot_out, bool warm_start = false) const;
+
+        /// generic function to solve for some set of the 12 variables given 3 variables
+        RpsSolveInfo solve(const RpsSelection& select, const VectorQs& qs, VectorQp& qp, MatrixRho& rho, MatrixRhoS& rho_s, bool warm_start = false) const;
+        /// solves the forward kinematics with the reduced 3 variable method, falling back on solve() if it fails
+        RpsSolveInfo solve_reduced(const VectorQs& q_par, VectorQp& qp, MatrixRho& rho, MatrixRhoS& rho_s, bool warm_start = false) const;
+        /// compares the reduced and general forward kinematics on an n_grid^3 grid spanning the given link lengths
+        RpsValidationResult validate_reduced(const VectorQs& q_par_min, const VectorQs& q_par_max, std::size_t n_grid) const;
+        /// compares the lookup table with the general forward kinematics at the centers of an n_grid^3 grid spanning the given link lengths
+        RpsValidationResult validate_table(const VectorQs& q_par_min, const VectorQs& q_par_max, std::size_t n_grid) const;
+        /// maps the velocities of the specified variables qs_dot to the other side (q_dot) and to all 12 variables (qp_dot), given rho and jac from a solve with select
+        static void map_velocity(const RpsSelection& select, const MatrixRho& rho, const MatrixJac& jac, const VectorQs& qs_dot, VectorQs& q_dot, VectorQp& qp_dot);
+        /// generates the variable *rho* at the configuration qp
+        void generate_rho(const RpsSelection& select, const VectorQp& qp, MatrixRho& rho) const;
+        /// solving for static equilibrium joint torques HAS NOT BEEN TESTED
+        void solve_static_torques(const RpsSelection& select, const VectorQb& tau_b, const VectorQp& qp, VectorQs& tau_s) const;
+        /// solving for static equilibrium joint torques HAS NOT BEEN TESTED
+        void solve_static_torques(const RpsSelection& select, const VectorQb& tau_b, const VectorQp& qp, VectorQs& tau_s, VectorQp& tau_p) const;
+
+        /// evaluates the 9 kinematic constraints phi at qp
+        static void phi_update(const VectorQp& qp, VectorQb& phi);
+        /// evaluates the derivative of phi w.r.t. qp
+        static void phi_d_qp_update(const VectorQp& qp, MatrixPhi& phi_d_qp);
+        /// hand written form of phi_update(), kept only as the test oracle for the generated kernel
+        static void phi_update_reference(const VectorQp& qp, VectorQb& phi);
+        /// hand written form of phi_d_qp_update(), kept only as the test oracle for the generated kernel
+        static void phi_d_qp_update_reference(const VectorQp& qp, MatrixPhi& phi_d_qp);
+
+        /// initial guess used to seed the solver
+        static const VectorQp& qp_guess();
+        /// initial leg angles used to seed the reduced solver, exact when the three link lengths are equal
+        static void theta_guess(const VectorQs& q_par, VectorQs& theta);
+
+        // geometric parameters
+        static const double R_; // [m]
+        static const double r_; // [m]
+        static const double a56_; // [m]
+        static const double alpha5_; // [rad]
+        static const double alpha13_; // [rad]
+        static const double theta_min_; // smallest leg angle the reduced solver will step to [rad]
+
+    private:
+        /// solves the forward kinematics with the selected method
+        RpsSolveInfo solve_forward(const VectorQs& q_par, VectorQp& qp, MatrixRho& rho, MatrixRhoS& rho_s, bool warm_start) const;
+        /// runs Newton iterations from the current value of qp, returns true if the tolerance was reached
+        bool newton(const RpsSelection& select, const VectorQs& qs, VectorQp& qp, Eigen::PartialPivLU<MatrixPhiB>& lu, MatrixRho& phi_d_qs, RpsSolveInfo& info, bool stop_on_divergence) const;
+        /// runs Newton iterations on the three leg angles theta, and on success writes the full solution to qp
+        bool reduced_newton(const VectorQs& q_par, VectorQs& theta, VectorQp& qp, RpsSolveInfo& info, bool stop_on_divergence) const;
+        /// evaluates the constraints phi stacked on top of the selection error
+        static void psi_update(const RpsSelection& select, const VectorQs& qs, const VectorQp& qp, VectorQp& psi);
+        /// evaluates the derivative of phi w.r.t. the remaining variables (in the order of select.b) and the specified ones
+        static void phi_d_qp_split(const RpsSelection& select, const VectorQp& qp, MatrixPhiB& phi_d_qb, MatrixRho& phi_d_qs);
+        /// computes rho and rho_s from the factorized phi_d_qb and phi_d_qs at the same configuration
+        static void rho_solve(const RpsSelection& select, const Eigen::PartialPivLU<MatrixPhiB>& lu, const MatrixRho& phi_d_qs, MatrixRho& rho, MatrixRhoS& rho_s);
+        /// factorizes phi_d_qb at qp and computes rho and rho_s
+        static void rho_update(const RpsSelection& select, const VectorQp& qp, MatrixRho& rho, MatrixRhoS& rho_s);
+
+        mahi::util::uint32 m_max_it; // max iterations to perform for kinematics solver
+        double m_tol;                // tolerance for kinematics solver
+        RpsFkMethod m_fk_method;     // algorithm used for the forward kinematics
+        std::shared_ptr<const RpsLookupTable> m_table; // lookup table used by RpsFkMethod::Table
+    };
+
+} // namespace meii
@@ -0,0 +1,84 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <array>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Small direct-mapped cache of forward kinematics solutions, keyed on the exact bit
+    /// pattern of the link lengths. Link lengths come from integer encoder counts, so a
+    /// stationary wrist reproduces the same key every tick and the solution can be
+    /// returned without solving. A new solution replaces whatever occupied its slot.
+    class RpsKinematicsCache {
+
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        static const std::size_t n_entries = 16; // number of slots, must be a power of two
+
+        /// Constructor
+        RpsKinematicsCache();
+
+        /// copies the cached solution for q_par to the outputs and returns true, or returns false on a miss
+        bool lookup(const RpsKinematics::VectorQs& q_par, RpsKinematics::VectorQs& q_ser, RpsKinematics::VectorQp& qp, RpsKinematics::MatrixRho& rho_fk, RpsKinematics::MatrixJac& jac_fk);
+        /// stores a solution for q_par
+        void insert(const RpsKinematics::VectorQs& q_par, const RpsKinematics::VectorQs& q_ser, const RpsKinematics::VectorQp& qp, const RpsKinematics::MatrixRho& rho_fk, const RpsKinematics::MatrixJac& jac_fk);
+        /// empties every slot, e.g. after the kinematics method changes
+        void clear();
+
+        /// number of lookups answered from the cache
+        mahi::util::uint64 get_hits() const { return m_hits; }
+        /// number of lookups that had to be solved
+        mahi::util::uint64 get_misses() const { return m_misses; }
+        /// fraction of lookups answered from the cache
+        double get_hit_rate() const { return m_hits + m_misses > 0 ? (double)m_hits / (m_hits + m_misses) : 0.0; }
+        /// clears the hit and miss counters
+        void reset_counters() { m_hits = 0; m_misses = 0; }
+
+    private:
+        typedef std::array<mahi::util::uint64, RpsKinematics::n_qs> Key;
+
+        /// One cached solution
+        struct Entry {
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+            Key key;                          // bit patterns of the link lengths
+            bool valid;                       // false until the slot is first written
+            RpsKinematics::VectorQs q_ser;
+            RpsKinematics::VectorQp qp;
+            RpsKinematics::MatrixRho rho_fk;
+            RpsKinematics::MatrixJac jac_fk;
+        };
+
+        /// returns the bit patterns of q_par
+        static Key make_key(const RpsKinematics::VectorQs& q_par);
+        /// returns the slot key maps to
+        static std::size_t slot(const Key& key);
+
+        std::array<Entry, n_entries> m_entries; // cached solutions
+        mahi::util::uint64 m_hits;              // lookups answered from the cache
+        mahi::util::uint64 m_misses;            // lookups that missed
+    };
+
+} // namespace meii
@@ -0,0 +1,102 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+#pragma once
+
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <string>
+
+namespace meii {
+
+    //==============================================================================
+    // FILE LAYOUT
+    //==============================================================================
+
+    /// Header at the start of a lookup table file. It is followed directly by
+    /// n_grid[0]*n_grid[1]*n_grid[2] nodes of n_values doubles each, with the last
+    /// link length varying fastest. Each node holds qp followed by rho_s (column-major),
+    /// or NaN everywhere if the generator could not solve the node.
+    struct RpsLookupTableHeader {
+        char magic[8];                       // "MEIIRPS" followed by a null terminator
+        mahi::util::uint32 version;          // file format version
+        mahi::util::uint32 n_values;         // doubles stored per node
+        mahi::util::uint32 n_grid[3];        // number of nodes along each link length
+        mahi::util::uint32 reserved;         // padding, keeps the doubles below 8 byte aligned
+        double q_par_min[3];                 // link lengths at the first node [m]
+        double q_par_max[3];                 // link lengths at the last node [m]
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Read-only, memory-mapped grid of forward kinematics solutions over the prismatic
+    /// joint space, generated offline with generate(). lookup() interpolates qp from the
+    /// values and gradients stored at the 8 corners of a cell, so its cost is the same on
+    /// every tick. Queries outside the grid, or
+    /// in a cell next to a node the generator could not solve, return false so the
+    /// caller can fall back on the solver.
+    class RpsLookupTable {
+
+    public:
+        static const mahi::util::uint32 version = 1;                                                         // current file format version
+        static const std::size_t n_values = RpsKinematics::n_qp + RpsKinematics::n_qp * RpsKinematics::n_qs; // qp and rho_s at each node
+
+        /// Constructor
+        RpsLookupTable();
+        /// Destructor
+        ~RpsLookupTable();
+        RpsLookupTable(const RpsLookupTable&) = delete;
+        RpsLookupTable& operator=(const RpsLookupTable&) = delete;
+
+        /// maps a table file into memory, returns false if it cannot be opened or is not a valid table
+        bool open(const std::string& filepath);
+        /// unmaps the table file
+        void close();
+        /// returns true if a table is mapped
+        bool is_open() const { return m_header != nullptr; }
+        /// returns the header of the mapped table, or nullptr if none is mapped
+        const RpsLookupTableHeader* get_header() const { return m_header; }
+
+        /// interpolates qp at q_par, returns false if the table cannot answer the query
+        bool lookup(const RpsKinematics::VectorQs& q_par, RpsKinematics::VectorQp& qp) const;
+
+        /// Solves the forward kinematics on an n_grid^3 grid spanning the given link lengths and
+        /// writes the result to filepath. The grid is filled outward from the node nearest the
+        /// nominal pose, warm starting each node from a solved neighbor so every node lies on the
+        /// same assembly mode. Nodes where any entry of rho_s exceeds max_rho are close to a singularity
+        /// and are left unsolved. Returns the number of nodes solved, or 0 if the file could not be written.
+        static std::size_t generate(const std::string& filepath, const RpsKinematics& rps, const RpsKinematics::VectorQs& q_par_min, const RpsKinematics::VectorQs& q_par_max, std::size_t n_grid, double max_rho = 50);
+
+    private:
+        /// returns the index of node (i, j, k)
+        std::size_t node_index(std::size_t i, std::size_t j, std::size_t k) const {
+            return (i * m_header->n_grid[1] + j) * m_header->n_grid[2] + k;
+        }
+
+        const RpsLookupTableHeader* m_header; // header of the mapped file
+        const double* m_nodes;                // first node of the mapped file
+        double m_inv_step[3];                 // inverse of the grid spacing along each link length [1/m]
+        void* m_address;                      // start of the mapping
+        std::size_t m_size;                   // size of the mapping [bytes]
+#ifdef _WIN32
+        void* m_file;                         // file handle
+        void* m_mapping;                      // file mapping handle
+#endif
+    };
+
+} // namespace meii
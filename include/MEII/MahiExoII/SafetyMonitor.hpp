@@ -0,0 +1,100 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <MEII/MahiExoII/JointState.hpp>
+#include <MEII/MahiExoII/MeiiParameters.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <array>
+#include <string>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Checks the position, velocity, torque and motor I^2t limits of every joint of the MAHI
+    /// Exo-II in one pass over a JointState. The joints are padded to n_lanes so each limit is a
+    /// fixed-length loop of compares with no branches, which the compiler turns into a few SIMD
+    /// instructions, and every tick costs the same whether or not anything is violated. The
+    /// result is a bitmask with one bit per joint and limit, see bit(). Diagnostics are only
+    /// produced when a bit is set, through event_log().
+    ///
+    /// The I^2t check mirrors the motor limiters: each motor's current is estimated from the
+    /// applied torque, and the integral of current^2 above the continuous limit may not exceed
+    /// (peak^2 - continuous^2) * i2t time.
+    class SafetyMonitor {
+    public:
+        static const std::size_t n_joints = JointState::n_joints; // number of joints checked
+        static const std::size_t n_lanes = 8;                      // joints padded to whole SIMD registers
+
+        /// Limits checked for every joint
+        enum Limit {
+            PositionMin = 0, // position below the min position limit
+            PositionMax = 1, // position above the max position limit
+            Velocity    = 2, // magnitude of velocity above the velocity limit
+            Torque      = 3, // magnitude of the requested torque above the torque limit
+            I2t         = 4, // motor I^2t budget used up
+            n_limits    = 5
+        };
+
+        /// returns the bit set in a violation mask when joint violates limit
+        static mahi::util::uint32 bit(Limit limit, std::size_t joint) { return 1u << (limit * n_joints + joint); }
+        /// returns the bits of every joint for limit
+        static mahi::util::uint32 limit_mask(Limit limit) { return ((1u << n_joints) - 1) << (limit * n_joints); }
+        /// returns the bits of every joint for every limit
+        static mahi::util::uint32 all_limits() { return (1u << (n_limits * n_joints)) - 1; }
+
+        /// Constructor
+        explicit SafetyMonitor(const MeiiParameters& params = MeiiParameters());
+
+        /// checks every limit of every joint against state and advances the I^2t integrals to state.time,
+        /// returns the violations of the limits in the limits mask as a mask of bit()s
+        mahi::util::uint32 check(const JointState& state, mahi::util::uint32 limits = all_limits());
+        /// returns the mask returned by the last check()
+        mahi::util::uint32 get_violations() const { return m_violations; }
+        /// returns the fraction of a motor's I^2t budget used, 1 or more is a violation
+        double get_i2t_usage(std::size_t joint) const { return m_i2t[joint] / m_i2t_budget[joint]; }
+        /// clears the I^2t integrals and the last violations
+        void reset();
+
+        /// describes every violation in violations, with the offending values from state
+        std::string describe(mahi::util::uint32 violations, const JointState& state) const;
+
+    private:
+        /// raises an event_log() event for every violation, only called when there is one
+        void report(mahi::util::uint32 violations, const JointState& state);
+
+        // limits of each joint, padding lanes can never be violated
+        std::array<double, n_lanes> m_pos_min;         // min position [rad] or [m]
+        std::array<double, n_lanes> m_pos_max;         // max position [rad] or [m]
+        std::array<double, n_lanes> m_vel_max;         // max velocity magnitude [rad/s] or [m/s]
+        std::array<double, n_lanes> m_trq_max;         // max requested torque magnitude [Nm] or [N]
+        std::array<double, n_lanes> m_amps_per_torque; // motor current per joint torque [A/Nm] or [A/N]
+        std::array<double, n_lanes> m_cont_sq;         // squared continuous current limit [A^2]
+        std::array<double, n_lanes> m_i2t_budget;      // (peak^2 - continuous^2) * i2t time [A^2 s]
+        std::array<double, n_lanes> m_i2t;             // integral of current^2 above the continuous limit [A^2 s]
+
+        mahi::util::int64 m_last_time_us = -1;         // JointState::time of the last check() [us], -1 before the first
+        mahi::util::uint32 m_violations = 0;           // mask returned by the last check()
+        std::array<std::size_t, n_limits * n_joints> m_events; // event_log() event of each bit
+    };
+
+} // namespace meii
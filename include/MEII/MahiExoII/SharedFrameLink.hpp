@@ -0,0 +1,132 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <MEII/MahiExoII/SimulatedPlant.hpp>
+#include <MEII/Utility/Seqlock.hpp>
+#include <Mahi/Com/SharedMemory.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <array>
+#include <atomic>
+#include <string>
+
+namespace meii {
+
+    /// Joint state written by the simulator into a SharedFrameRegion
+    struct SharedFrameState {
+        double time;        // simulated time [s]
+        double position[5]; // joint positions [rad] or [m]
+        double velocity[5]; // joint velocities [rad/s] or [m/s]
+    };
+
+    /// Joint torques written by the controller into a SharedFrameRegion
+    struct SharedFrameCommand {
+        double torque[5];   // joint torques [Nm] or [N]
+    };
+
+    /// Shared memory frame holding every virtual joint, one per exo. Each direction is a
+    /// SeqlockBlock with a single writer, at fixed offsets so simulators in other languages can
+    /// map it directly:
+    ///
+    ///     offset  field              written by
+    ///          0  magic              either side, SharedFrameRegion::magic_value
+    ///          4  version            either side, SharedFrameRegion::version_value
+    ///          8  state sequence     simulator, odd while the state is being written
+    ///         16  state              simulator, SharedFrameState (time, position[5], velocity[5])
+    ///        104  command sequence   controller, odd while the command is being written
+    ///        112  command            controller, SharedFrameCommand (torque[5])
+    ///
+    /// A writer sets its sequence to (sequence | 1) before writing and adds one after, as
+    /// SeqlockBlock::write() does, so a side restarted after dying mid-write keeps the parity.
+    /// Neither side waits for the other: the simulator publishes states at its own rate and
+    /// the controller reads the latest one and publishes its torques once per tick.
+    struct SharedFrameRegion {
+        static const mahi::util::uint32 magic_value = 0x4656454D; // "MEVF"
+        static const mahi::util::uint32 version_value = 1;
+
+        mahi::util::uint32 magic;
+        mahi::util::uint32 version;
+        SeqlockBlock<11> state;
+        SeqlockBlock<5> command;
+    };
+
+    // the sequences and words are shared with another process, which only works if they are plain words rather than locks
+#if __cplusplus >= 201703L
+    static_assert(std::atomic<mahi::util::uint64>::is_always_lock_free, "SharedFrameRegion requires lock-free 64 bit atomics");
+#else
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "SharedFrameRegion requires lock-free 64 bit atomics");
+#endif
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Controller side of a SharedFrameRegion, through which a MahiExoIIVirtual exchanges every
+    /// joint with an external simulator. update() copies the latest state out of the frame once
+    /// per tick and apply() writes every torque in once per tick, without locks or allocations.
+    /// Until the simulator has published a state the joints sit at their rest positions.
+    class SharedFrameLink : public SimulatedPlant {
+    public:
+        static const std::size_t n_joints = 5;
+
+        /// Constructor, opens or creates the shared memory name
+        SharedFrameLink(const std::string& name, const std::array<double, n_joints>& rest_positions);
+
+        /// copies the latest state out of the frame, returns false and keeps the last state if the simulator was writing throughout
+        bool update(mahi::util::Time time) override;
+        /// writes the torques into the frame
+        bool apply() override;
+
+        double get_position(std::size_t joint) const override { return m_state.position[joint]; }
+        double get_velocity(std::size_t joint) const override { return m_state.velocity[joint]; }
+        void set_torque(std::size_t joint, double torque) override { m_command.torque[joint] = torque; }
+
+        /// returns the number of states the simulator has published as of the last update(), 0 if none
+        mahi::util::uint64 get_state_version() const { return m_state_version; }
+
+    private:
+        mahi::com::SharedMemory m_shm;      // shared memory holding the region
+        SharedFrameRegion* m_region;        // frame in m_shm
+        SharedFrameState m_state;           // state read by the last update()
+        SharedFrameCommand m_command;       // torques written by the next apply()
+        mahi::util::uint64 m_state_version; // version of m_state
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Simulator side of a SharedFrameRegion, a reference for simulators written against the
+    /// frame layout and the way to serve one from C++.
+    class SharedFrameSimulator {
+    public:
+        /// Constructor, opens or creates the shared memory name
+        explicit SharedFrameSimulator(const std::string& name);
+
+        /// publishes a state
+        void publish(const SharedFrameState& state) { m_region->state.write(state); }
+        /// copies the latest torques to command, returns false if the controller was writing throughout
+        bool read_command(SharedFrameCommand& command) const;
+
+    private:
+        mahi::com::SharedMemory m_shm;      // shared memory holding the region
+        SharedFrameRegion* m_region;        // frame in m_shm
+    };
+
+} // namespace meii
@@ -0,0 +1,52 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Timing/Time.hpp>
+#include <cstddef>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Simulation the joints of a MahiExoIIVirtual read from and drive instead of MelShare.
+    /// MahiExoIIVirtual calls update() from daq_read_all() and apply() from daq_write_all(), so
+    /// a tick sees the state the simulation had when it was read and hands its torques off when
+    /// they are written.
+    class SimulatedPlant {
+    public:
+        /// Destructor
+        virtual ~SimulatedPlant() { }
+
+        /// brings the joint states up to time, the loop time of the exo, returns false if the simulation could not be reached
+        virtual bool update(mahi::util::Time time) = 0;
+        /// hands the torques set since the last update() to the simulation, returns false if the simulation could not be reached
+        virtual bool apply() = 0;
+
+        /// returns the position of a joint [rad] or [m]
+        virtual double get_position(std::size_t joint) const = 0;
+        /// returns the velocity of a joint [rad/s] or [m/s]
+        virtual double get_velocity(std::size_t joint) const = 0;
+        /// sets the torque applied to a joint [Nm] or [N]
+        virtual void set_torque(std::size_t joint, double torque) = 0;
+    };
+
+} // namespace meii
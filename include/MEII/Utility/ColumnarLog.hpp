@@ -0,0 +1,170 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <MEII/Utility/SessionRecorder.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace meii {
+
+    /// Location and time span of one chunk of a columnar log
+    struct ColumnarChunkInfo {
+        double t_first;               // time of the first record in the chunk [s]
+        double t_last;                // time of the last record in the chunk [s]
+        mahi::util::uint64 offset;    // file offset of the chunk header [bytes]
+        mahi::util::uint64 first;     // index of the first record in the log
+        mahi::util::uint32 n_records; // records in the chunk
+        mahi::util::uint32 reserved;  // zero
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Writes records described by a RecordSchema to a columnar log. Records are buffered into
+    /// chunks, and each chunk stores every field as its own column so a reader can decode one
+    /// signal without touching the others. Each column of each chunk is encoded with whichever
+    /// of these is smallest:
+    ///
+    /// - raw bytes
+    /// - integer fields: zigzag deltas from the previous record as varints
+    /// - floating point fields: the XOR of each value's bits with the previous value's as varints,
+    ///   so the unchanged sign, exponent and high mantissa bytes of slowly varying signals vanish
+    /// - Float64 fields given a quantum with set_quantum(), e.g. encoder positions: the delta of
+    ///   round(value / quantum) as a varint, plus the XOR of the value's bits with round(value /
+    ///   quantum) * quantum, which is zero whenever the value is an exact multiple
+    ///
+    /// All encodings are lossless. close() appends an index of the time span and offset of every
+    /// chunk, which ColumnarLogReader uses to seek to a timestamp. If the writer never reaches
+    /// close(), the reader rebuilds the index from the chunk headers.
+    class ColumnarLogWriter {
+    public:
+        /// Constructor, time_field is the field holding each record's time [s], which must not decrease
+        ColumnarLogWriter(const RecordSchema& schema, std::size_t time_field = 0, std::size_t chunk_records = 4096);
+        /// Destructor, closes the file
+        ~ColumnarLogWriter();
+        ColumnarLogWriter(const ColumnarLogWriter&) = delete;
+        ColumnarLogWriter& operator=(const ColumnarLogWriter&) = delete;
+
+        /// sets the quantum of a Float64 field whose values are mostly multiples of it, call before open()
+        void set_quantum(std::size_t field, double quantum);
+
+        /// creates filepath and writes the schema header
+        bool open(const std::string& filepath);
+        /// appends a record packed to the schema, writing a chunk whenever one fills
+        bool append(const mahi::util::uint8* record);
+        /// writes the last partial chunk and the index, and closes the file
+        bool close();
+        /// returns true between open() and close()
+        bool is_open() const { return m_file != nullptr; }
+
+        /// returns the number of records appended
+        mahi::util::uint64 get_records() const { return m_records; }
+        /// returns the number of chunks written
+        std::size_t get_chunks() const { return m_index.size(); }
+        /// returns the number of bytes written to the file
+        mahi::util::uint64 get_bytes() const { return m_offset; }
+
+    private:
+        /// encodes and writes the buffered records as one chunk
+        bool write_chunk();
+        /// writes size bytes at the end of the file
+        bool write(const void* data, std::size_t size);
+
+        const RecordSchema m_schema;                 // fields of every record
+        const std::size_t m_time_field;              // field holding the time [s]
+        const std::size_t m_chunk_records;           // records per chunk
+        std::vector<double> m_quanta;                // quantum of each field, 0 for none
+        std::vector<mahi::util::uint8> m_buffer;     // records of the chunk being filled
+        std::size_t m_buffered = 0;                  // records in m_buffer
+        std::vector<mahi::util::uint8> m_table;      // column headers of the chunk being written
+        std::vector<mahi::util::uint8> m_columns;    // encoded columns of the chunk being written
+        std::vector<mahi::util::uint8> m_candidate;  // scratch encoding of one column
+        std::vector<mahi::util::uint8> m_best;       // smallest encoding of one column so far
+        std::vector<ColumnarChunkInfo> m_index;      // chunks written so far
+        std::FILE* m_file = nullptr;                 // log file
+        mahi::util::uint64 m_offset = 0;             // bytes written so far
+        mahi::util::uint64 m_records = 0;            // records appended so far
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Memory maps a columnar log written by ColumnarLogWriter and decodes single columns of
+    /// single chunks, so a minute of one signal in an hours long session costs a binary search
+    /// of the index and the decoding of a handful of chunks
+    class ColumnarLogReader {
+    public:
+        /// Constructor
+        ColumnarLogReader();
+        /// Destructor, unmaps the file
+        ~ColumnarLogReader();
+        ColumnarLogReader(const ColumnarLogReader&) = delete;
+        ColumnarLogReader& operator=(const ColumnarLogReader&) = delete;
+
+        /// maps filepath, reads its schema and its index, or rebuilds the index if the log was not closed
+        bool open(const std::string& filepath);
+        /// unmaps the file
+        void close();
+        /// returns true if a log is open
+        bool is_open() const { return m_address != nullptr; }
+
+        /// returns the schema of the log
+        const RecordSchema& get_schema() const { return m_schema; }
+        /// returns the field holding the time [s]
+        std::size_t get_time_field() const { return m_time_field; }
+        /// returns the number of chunks
+        std::size_t get_chunk_count() const { return m_index.size(); }
+        /// returns the number of records
+        mahi::util::uint64 get_record_count() const;
+        /// returns the time span and location of a chunk
+        const ColumnarChunkInfo& get_chunk(std::size_t chunk) const { return m_index[chunk]; }
+        /// returns true if the index was rebuilt because the log was not closed
+        bool is_recovered() const { return m_recovered; }
+
+        /// returns the first chunk whose last record is at or after time, or get_chunk_count() if there is none
+        std::size_t find_chunk(double time) const;
+        /// decodes one field of one chunk into values, returns false if the column is corrupt
+        bool read_column(std::size_t chunk, std::size_t field, std::vector<double>& values) const;
+        /// decodes the records of one field with times in [t_begin, t_end] into times and values
+        bool read_range(std::size_t field, double t_begin, double t_end, std::vector<double>& times, std::vector<double>& values) const;
+
+    private:
+        /// scans the chunk headers after data_offset to rebuild a missing index
+        void rebuild_index(std::size_t data_offset);
+        /// returns true if m_index describes the chunks stored back to back from data_offset to index_offset
+        bool check_index(std::size_t data_offset, std::size_t index_offset) const;
+
+        RecordSchema m_schema;                   // schema from the file header
+        std::size_t m_time_field;                // field holding the time [s]
+        std::vector<ColumnarChunkInfo> m_index;  // every chunk in the log
+        bool m_recovered;                        // whether m_index was rebuilt
+        const mahi::util::uint8* m_data;         // start of the mapping
+        void* m_address;                         // start of the mapping
+        std::size_t m_size;                      // size of the mapping [bytes]
+#ifdef _WIN32
+        void* m_file;                            // file handle
+        void* m_mapping;                         // file mapping handle
+#endif
+    };
+
+} // namespace meii
@@ -0,0 +1,76 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Types.hpp>
+#include <chrono>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #define MEII_HAS_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <x86intrin.h>
+    #define MEII_HAS_RDTSC 1
+#endif
+
+namespace meii {
+
+    /// Cheapest available timestamp for timing probes. On x86 this is the time stamp counter,
+    /// which takes a few nanoseconds to read instead of the tens a system clock call costs, and
+    /// which runs at a constant rate on every CPU the MAHI Exo-II is driven from. Elsewhere it
+    /// falls back on std::chrono::steady_clock. Convert differences of now() with to_ns().
+    class CycleClock {
+    public:
+        /// returns the current timestamp [ticks]
+        static mahi::util::uint64 now() {
+        #ifdef MEII_HAS_RDTSC
+            return __rdtsc();
+        #else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        #endif
+        }
+
+        /// returns the length of one tick [ns], measured against steady_clock on the first call, which takes about 10 ms.
+        /// Call it once before a real-time loop starts converting ticks, as LoopProfiler does on construction
+        static double ns_per_tick() {
+            static const double ns = calibrate();
+            return ns;
+        }
+
+        /// converts a number of ticks to nanoseconds
+        static mahi::util::uint64 to_ns(mahi::util::uint64 ticks) {
+            return static_cast<mahi::util::uint64>(ticks * ns_per_tick() + 0.5);
+        }
+
+    private:
+        static double calibrate() {
+        #ifdef MEII_HAS_RDTSC
+            auto start = std::chrono::steady_clock::now();
+            mahi::util::uint64 start_ticks = now();
+            while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(10)) { }
+            auto end = std::chrono::steady_clock::now();
+            mahi::util::uint64 end_ticks = now();
+            return std::chrono::duration<double, std::nano>(end - start).count() / (end_ticks - start_ticks);
+        #else
+            return 1.0;
+        #endif
+        }
+    };
+
+} // namespace meii
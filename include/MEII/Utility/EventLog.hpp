@@ -0,0 +1,100 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Logging/Log.hpp>
+#include <Mahi/Util/Timing/Time.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Aggregates warnings raised on the control loop's hot path, such as a joint saturating every
+    /// tick, and logs them from a background thread. Each kind of event is registered once, up
+    /// front, with its severity and message, and gets a slot of atomic counters. record() only
+    /// bumps the slot's count and updates its last and peak values, so it never formats, allocates,
+    /// locks or touches a file, and raising an event a thousand times costs a thousand increments.
+    /// Every window the reporter thread logs each event raised during it once, e.g.
+    ///
+    ///     Joint meii_joint_1 command torque saturated to 10: 843 times in the last 1.0 s, peak 12.4
+    class EventLog {
+    public:
+        /// maximum number of events that can be registered
+        static const std::size_t max_events = 1024;
+
+        /// Constructor, starts a thread that logs the events raised during each window
+        explicit EventLog(mahi::util::Time window = mahi::util::seconds(1));
+        /// Destructor, stops the reporter thread without logging the current window, see flush()
+        ~EventLog();
+        EventLog(const EventLog&) = delete;
+        EventLog& operator=(const EventLog&) = delete;
+
+        /// registers an event logged with severity and message, and returns its id for record(). Registering an
+        /// identical event again returns the same id, so every exo in a process raises the same events
+        std::size_t register_event(mahi::util::Severity severity, const std::string& message, const std::string& unit = "");
+        /// raises an event with a value, safe to call from any thread at any rate
+        void record(std::size_t event, double value);
+
+        /// logs the events raised since the last report now, and returns how many were logged
+        std::size_t flush();
+
+        /// returns the number of times an event has been raised in total
+        mahi::util::uint64 get_total(std::size_t event) const { return m_slots[event].total.load(std::memory_order_relaxed); }
+        /// returns the number of registered events
+        std::size_t get_event_count() const { return m_count.load(std::memory_order_acquire); }
+
+    private:
+        /// body of the reporter thread
+        void report_loop();
+
+        struct Slot {
+            std::atomic<mahi::util::uint64> count;    // times raised since the last report
+            std::atomic<mahi::util::uint64> total;    // times raised in total
+            std::atomic<mahi::util::uint64> last;     // bits of the last value
+            std::atomic<mahi::util::uint64> peak;     // bits of the value with the largest magnitude since the last report
+            mahi::util::Severity severity;            // severity it is logged with
+            std::string message;                      // text logged before the counts
+            std::string unit;                         // unit of the values
+        };
+
+        const mahi::util::Time m_window;          // how often the reporter logs
+        std::vector<Slot> m_slots;                // max_events slots, allocated up front so record() never races a reallocation
+        std::atomic<std::size_t> m_count;         // registered events
+        std::mutex m_register_mutex;              // serializes register_event()
+        std::mutex m_report_mutex;                // serializes flush()
+        mahi::util::int64 m_last_report_us;       // time of the last report [us], guarded by m_report_mutex
+        std::mutex m_stop_mutex;                  // guards m_stop
+        std::condition_variable m_stop_cv;        // wakes the reporter to stop
+        bool m_stop;                              // set to stop the reporter
+        std::thread m_reporter;                   // runs report_loop()
+    };
+
+    /// returns the event log shared by the whole process
+    EventLog& event_log();
+
+} // namespace meii
@@ -0,0 +1,119 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Types.hpp>
+#include <atomic>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Histogram of latencies with a fixed set of buckets, so recording is a few integer
+    /// operations and never allocates. Latencies below 16 ns get a bucket each, and every power
+    /// of two above that is split into 8 buckets, so any percentile is reported to within 12.5 %
+    /// from nanoseconds up to minutes. Counters are relaxed atomics: one thread records, and any
+    /// thread may query while it does.
+    class LatencyHistogram {
+    public:
+        static const std::size_t n_linear = 16;     // buckets of 1 ns below n_linear ns
+        static const std::size_t n_sub = 8;         // buckets per power of two above that
+        static const std::size_t n_buckets = n_linear + (40 - 4) * n_sub; // covers up to 2^40 ns, about 18 minutes
+
+        /// Constructor
+        LatencyHistogram() { reset(); }
+
+        /// records one latency [ns], from one thread only
+        void record(mahi::util::uint64 ns) {
+            std::size_t b = bucket(ns);
+            m_counts[b].store(m_counts[b].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            m_sum.store(m_sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+            if (ns > m_max.load(std::memory_order_relaxed))
+                m_max.store(ns, std::memory_order_relaxed);
+        }
+
+        /// clears every bucket, only while nothing is being recorded
+        void reset() {
+            for (std::size_t i = 0; i < n_buckets; ++i)
+                m_counts[i].store(0, std::memory_order_relaxed);
+            m_count.store(0, std::memory_order_relaxed);
+            m_sum.store(0, std::memory_order_relaxed);
+            m_max.store(0, std::memory_order_relaxed);
+        }
+
+        /// returns the number of latencies recorded
+        mahi::util::uint64 get_count() const { return m_count.load(std::memory_order_relaxed); }
+        /// returns the largest latency recorded [ns]
+        mahi::util::uint64 get_max() const { return m_max.load(std::memory_order_relaxed); }
+        /// returns the mean latency [ns]
+        double get_mean() const {
+            mahi::util::uint64 count = get_count();
+            return count > 0 ? (double)m_sum.load(std::memory_order_relaxed) / count : 0.0;
+        }
+        /// returns the latency [ns] that fraction (0 to 1) of the recorded latencies are at or below, as the upper edge of its bucket
+        mahi::util::uint64 get_percentile(double fraction) const {
+            mahi::util::uint64 count = get_count();
+            if (count == 0)
+                return 0;
+            mahi::util::uint64 rank = (mahi::util::uint64)(fraction * count + 0.5);
+            if (rank < 1)
+                rank = 1;
+            mahi::util::uint64 seen = 0;
+            for (std::size_t b = 0; b < n_buckets; ++b) {
+                seen += m_counts[b].load(std::memory_order_relaxed);
+                if (seen >= rank) {
+                    mahi::util::uint64 upper = upper_edge(b);
+                    mahi::util::uint64 max = get_max();
+                    return upper < max ? upper : max;
+                }
+            }
+            return get_max();
+        }
+
+    private:
+        /// returns the bucket of a latency [ns]
+        static std::size_t bucket(mahi::util::uint64 ns) {
+            if (ns < n_linear)
+                return (std::size_t)ns;
+            std::size_t power = 63;
+            while ((ns >> power) == 0)
+                --power;
+            std::size_t b = n_linear + (power - 4) * n_sub + (std::size_t)((ns >> (power - 3)) & (n_sub - 1));
+            return b < n_buckets ? b : n_buckets - 1;
+        }
+
+        /// returns the largest latency [ns] that falls in bucket b
+        static mahi::util::uint64 upper_edge(std::size_t b) {
+            if (b < n_linear)
+                return b;
+            std::size_t power = (b - n_linear) / n_sub + 4;
+            mahi::util::uint64 sub = (b - n_linear) % n_sub;
+            return ((n_sub + sub + 1) << (power - 3)) - 1;
+        }
+
+        std::atomic<mahi::util::uint64> m_counts[n_buckets]; // latencies recorded in each bucket
+        std::atomic<mahi::util::uint64> m_count;             // latencies recorded
+        std::atomic<mahi::util::uint64> m_sum;               // sum of the latencies recorded [ns]
+        std::atomic<mahi::util::uint64> m_max;               // largest latency recorded [ns]
+    };
+
+} // namespace meii
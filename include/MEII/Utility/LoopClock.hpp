@@ -0,0 +1,68 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Timing/Time.hpp>
+#include <Mahi/Util/Timing/Timer.hpp>
+#include <Mahi/Util/Types.hpp>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Paces a control loop and keeps its time, as a drop-in for a mahi::util::Timer. In
+    /// RealTime mode it is a Hybrid Timer. In Lockstep mode wait() returns immediately and time
+    /// advances by exactly one period per wait(), so a loop driving a simulated exo runs as fast
+    /// as the CPU allows and gives the same result on every run. Pass the clock to
+    /// MahiExoII::set_loop_clock() so the joint state and any simulated plant follow the same time.
+    class LoopClock {
+    public:
+        /// How time advances
+        enum Mode {
+            RealTime, // wall time, wait() sleeps out the rest of the period
+            Lockstep  // simulated time, wait() advances one period without sleeping
+        };
+
+        /// Constructor
+        LoopClock(mahi::util::Time period, Mode mode = RealTime);
+
+        /// waits out the rest of the period in RealTime mode, or advances one period in Lockstep mode, and returns the elapsed time
+        mahi::util::Time wait();
+        /// returns the time since construction or restart(), wall time in RealTime mode and simulated time in Lockstep mode
+        mahi::util::Time get_elapsed_time() const;
+        /// returns the number of wait() calls since construction or restart()
+        mahi::util::int64 get_elapsed_ticks() const { return m_ticks; }
+        /// restarts the elapsed time from zero and returns the time elapsed before
+        mahi::util::Time restart();
+
+        /// returns the period
+        mahi::util::Time get_period() const { return m_period; }
+        /// returns the mode
+        Mode get_mode() const { return m_mode; }
+
+    private:
+        mahi::util::Time m_period;         // loop period
+        Mode m_mode;                       // how time advances
+        mutable mahi::util::Timer m_timer; // paces the loop in RealTime mode, mutable as not every Timer getter is const
+        mahi::util::int64 m_ticks;         // wait() calls since construction or restart()
+    };
+
+} // namespace meii
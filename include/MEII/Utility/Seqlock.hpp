@@ -0,0 +1,150 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Types.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <type_traits>
+
+namespace meii {
+
+    /// Sequence counter and payload of a seqlock, N words long. It has no constructor and a
+    /// fixed layout (the counter, then the words), so it can be placed in zero-initialized
+    /// shared memory and implemented by other processes: the writer makes the counter odd (the
+    /// counter | 1, so a writer that died mid-write is recovered from), stores the words and
+    /// makes it even again, and a reader retries while the counter is odd or changed during its copy. Every access is atomic, so concurrent copies are not a data race.
+    template <std::size_t N>
+    struct SeqlockBlock {
+        std::atomic<mahi::util::uint64> sequence; // twice the version, odd while a write is in progress
+        std::atomic<mahi::util::uint64> words[N]; // the value, copied a word at a time
+
+        /// writes value, may only be called by one writer at a time
+        template <typename T>
+        void write(const T& value) {
+            static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= N * sizeof(mahi::util::uint64), "SeqlockBlock requires a trivially copyable type that fits");
+            mahi::util::uint64 copy[N] = {};
+            std::memcpy(copy, &value, sizeof(T));
+            // a writer that died mid-write left the counter odd, so start from the next odd value rather than
+            // adding one, which would leave the counter even while writing and odd once done
+            mahi::util::uint64 seq = sequence.load(std::memory_order_relaxed) | 1;
+            sequence.store(seq, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (std::size_t i = 0; i < N; ++i)
+                words[i].store(copy[i], std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_release);
+        }
+
+        /// copies the latest value to value and its version to version, retrying at most max_retries times,
+        /// returns false and leaves value unchanged if every attempt overlapped a write
+        template <typename T>
+        bool try_read(T& value, mahi::util::uint64& version, mahi::util::uint64 max_retries, mahi::util::uint64* retries = nullptr) const {
+            static_assert(std::is_trivially_copyable<T>::value && sizeof(T) <= N * sizeof(mahi::util::uint64), "SeqlockBlock requires a trivially copyable type that fits");
+            mahi::util::uint64 copy[N];
+            for (mahi::util::uint64 attempt = 0; attempt <= max_retries; ++attempt) {
+                mahi::util::uint64 before = sequence.load(std::memory_order_acquire);
+                if ((before & 1) == 0) {
+                    for (std::size_t i = 0; i < N; ++i)
+                        copy[i] = words[i].load(std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (sequence.load(std::memory_order_relaxed) == before) {
+                        std::memcpy(&value, copy, sizeof(T));
+                        version = before / 2;
+                        if (retries)
+                            *retries += attempt;
+                        return true;
+                    }
+                }
+            }
+            if (retries)
+                *retries += max_retries + 1;
+            return false;
+        }
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Publishes a value of trivially copyable type T from one writer thread to any number of
+    /// reader threads through a SeqlockBlock. The writer never blocks or waits: it bumps a
+    /// sequence counter to an odd value, copies the value in, and bumps it back to even. A reader
+    /// copies the value out and retries if the counter was odd or changed meanwhile, so it never
+    /// sees a torn value.
+    template <typename T>
+    class Seqlock {
+        static_assert(std::is_trivially_copyable<T>::value, "Seqlock requires a trivially copyable type");
+
+    public:
+        /// Constructor, publishes a value-initialized T so readers always have something to read
+        Seqlock() :
+            m_last_publish_ns(0),
+            m_max_publish_ns(0),
+            m_reads(0),
+            m_retries(0)
+        {
+            m_block.sequence.store(0, std::memory_order_relaxed);
+            publish(T());
+        }
+
+        /// publishes value, may only be called from one thread at a time
+        void publish(const T& value) {
+            auto start = std::chrono::steady_clock::now();
+            m_block.write(value);
+            mahi::util::uint64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            m_last_publish_ns.store(ns, std::memory_order_relaxed);
+            if (ns > m_max_publish_ns.load(std::memory_order_relaxed))
+                m_max_publish_ns.store(ns, std::memory_order_relaxed);
+        }
+
+        /// copies the latest published value to value and returns its version, which increases by one with every publish()
+        mahi::util::uint64 read(T& value) const {
+            mahi::util::uint64 version = 0;
+            mahi::util::uint64 retries = 0;
+            // the writer is in this process and never stops halfway, so keep trying until a read succeeds
+            while (!m_block.try_read(value, version, 1024, &retries)) { }
+            m_reads.fetch_add(1, std::memory_order_relaxed);
+            if (retries > 0)
+                m_retries.fetch_add(retries, std::memory_order_relaxed);
+            return version;
+        }
+
+        /// returns the version of the latest published value without reading it
+        mahi::util::uint64 get_version() const { return m_block.sequence.load(std::memory_order_acquire) / 2; }
+        /// returns how long the last publish() took [ns]
+        mahi::util::uint64 get_last_publish_ns() const { return m_last_publish_ns.load(std::memory_order_relaxed); }
+        /// returns the longest any publish() has taken [ns]
+        mahi::util::uint64 get_max_publish_ns() const { return m_max_publish_ns.load(std::memory_order_relaxed); }
+        /// returns the number of completed reads
+        mahi::util::uint64 get_reads() const { return m_reads.load(std::memory_order_relaxed); }
+        /// returns the number of times a reader had to start over because publish() was running
+        mahi::util::uint64 get_retries() const { return m_retries.load(std::memory_order_relaxed); }
+
+    private:
+        static const std::size_t n_words = (sizeof(T) + sizeof(mahi::util::uint64) - 1) / sizeof(mahi::util::uint64);
+
+        SeqlockBlock<n_words> m_block;                              // sequence counter and the value
+        std::atomic<mahi::util::uint64> m_last_publish_ns;          // duration of the last publish [ns]
+        std::atomic<mahi::util::uint64> m_max_publish_ns;           // longest publish [ns]
+        mutable std::atomic<mahi::util::uint64> m_reads;            // completed reads
+        mutable std::atomic<mahi::util::uint64> m_retries;          // reads restarted because of a concurrent publish
+    };
+
+} // namespace meii
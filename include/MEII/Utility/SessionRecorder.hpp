@@ -0,0 +1,211 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Timing/Time.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace meii {
+
+    /// Storage type of one field of a recorded record
+    enum class RecordType : mahi::util::uint8 {
+        Float64 = 0,
+        Float32 = 1,
+        Int64   = 2,
+        Int32   = 3,
+        UInt8   = 4
+    };
+
+    /// returns the size of a field of type [bytes]
+    std::size_t record_type_size(RecordType type);
+
+    /// Names and types of the fields of a fixed-size binary record, packed in the order they were added
+    class RecordSchema {
+    public:
+        /// adds a field to the end of the record and returns its index
+        std::size_t add_field(const std::string& name, RecordType type = RecordType::Float64);
+
+        /// returns the number of fields
+        std::size_t get_field_count() const { return m_fields.size(); }
+        /// returns the name of a field
+        const std::string& get_field_name(std::size_t field) const { return m_fields[field].name; }
+        /// returns the type of a field
+        RecordType get_field_type(std::size_t field) const { return m_fields[field].type; }
+        /// returns the offset of a field from the start of the record [bytes]
+        std::size_t get_field_offset(std::size_t field) const { return m_fields[field].offset; }
+        /// returns the size of one record [bytes]
+        std::size_t get_record_size() const { return m_record_size; }
+
+        /// writes value to a field of record, converting it to the field's type
+        template <typename T>
+        void set(mahi::util::uint8* record, std::size_t field, T value) const {
+            mahi::util::uint8* dst = record + m_fields[field].offset;
+            switch (m_fields[field].type) {
+                case RecordType::Float64: store(dst, static_cast<double>(value)); break;
+                case RecordType::Float32: store(dst, static_cast<float>(value)); break;
+                case RecordType::Int64:   store(dst, static_cast<mahi::util::int64>(value)); break;
+                case RecordType::Int32:   store(dst, static_cast<mahi::util::int32>(value)); break;
+                case RecordType::UInt8:   store(dst, static_cast<mahi::util::uint8>(value)); break;
+            }
+        }
+        /// reads a field of record as a double
+        double get_double(const mahi::util::uint8* record, std::size_t field) const;
+        /// reads a field of record as an integer, rounding toward zero for floating point fields
+        mahi::util::int64 get_int(const mahi::util::uint8* record, std::size_t field) const;
+
+    private:
+        template <typename T>
+        static void store(mahi::util::uint8* dst, T value) { std::memcpy(dst, &value, sizeof(T)); }
+
+        struct Field {
+            std::string name;   // field name, at most 255 characters in a file
+            RecordType type;    // storage type
+            std::size_t offset; // offset from the start of the record [bytes]
+        };
+        std::vector<Field> m_fields;    // fields in record order
+        std::size_t m_record_size = 0;  // size of one record [bytes]
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Records fixed-size binary records from a real-time thread to an append-only session file.
+    /// Records are copied into a ring preallocated in the constructor, so record() never allocates
+    /// or blocks; when the ring is full the record is dropped and counted. A background thread
+    /// writes the ring to disk in chunks, each with its own record count and CRC-32, so if the
+    /// process dies only the chunk being written is lost and SessionReader stops cleanly before it.
+    ///
+    /// File layout: "MEIIREC\0", uint32 version, uint32 record size, uint32 field count, then per
+    /// field a uint8 RecordType, a uint8 name length and the name, followed by any number of
+    /// chunks of "CHNK", uint32 record count, uint64 index of the first record, uint32 CRC-32 of
+    /// the records, uint32 reserved, and the records themselves.
+    class SessionRecorder {
+    public:
+        /// Constructor, preallocates capacity records and writes chunks of up to chunk_records, or
+        /// whatever is waiting once the oldest unwritten record is older than max_chunk_age
+        SessionRecorder(const RecordSchema& schema,
+                        std::size_t capacity = 65536,
+                        std::size_t chunk_records = 1024,
+                        mahi::util::Time max_chunk_age = mahi::util::seconds(1));
+        /// Destructor, writes everything recorded and closes the file
+        ~SessionRecorder();
+        SessionRecorder(const SessionRecorder&) = delete;
+        SessionRecorder& operator=(const SessionRecorder&) = delete;
+
+        /// creates filepath, writes the schema header and starts the writer thread
+        bool open(const std::string& filepath);
+        /// writes everything recorded so far, stops the writer thread and closes the file, call from the recording thread or once it has stopped
+        void close();
+        /// returns true between open() and close()
+        bool is_open() const { return m_file != nullptr; }
+        /// returns the schema records are written with
+        const RecordSchema& get_schema() const { return m_schema; }
+
+        /// sets a field of the record being built (recording thread only)
+        template <typename T>
+        void set(std::size_t field, T value) { m_schema.set(m_staging.data(), field, value); }
+        /// sets n consecutive fields of the record being built starting at first_field (recording thread only)
+        template <typename T>
+        void set(std::size_t first_field, const T* values, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                m_schema.set(m_staging.data(), first_field + i, values[i]);
+        }
+        /// records the record built with set(), which keeps its values for the next one (recording thread only)
+        bool commit() { return record(m_staging.data()); }
+        /// records a record already packed to the schema, returns false if it was dropped (recording thread only)
+        bool record(const void* record);
+
+        /// returns the number of records accepted by record() or commit()
+        mahi::util::uint64 get_recorded() const { return m_head.load(std::memory_order_relaxed); }
+        /// returns the number of records dropped because the ring was full or the file was not open
+        mahi::util::uint64 get_dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+        /// returns the number of records written to the file
+        mahi::util::uint64 get_written() const { return m_tail.load(std::memory_order_relaxed); }
+        /// returns the number of chunks written to the file
+        mahi::util::uint64 get_chunks() const { return m_chunks.load(std::memory_order_relaxed); }
+        /// returns true if a write to the file has failed, after which nothing more is written
+        bool write_failed() const { return m_write_failed; }
+
+    private:
+        /// body of the writer thread
+        void write_loop();
+        /// writes the next n records of the ring as one chunk
+        bool write_chunk(std::size_t n);
+
+        const RecordSchema m_schema;               // fields of every record
+        const std::size_t m_record_size;           // size of one record [bytes]
+        const std::size_t m_capacity;              // records the ring holds
+        const std::size_t m_chunk_records;         // records per full chunk
+        const mahi::util::Time m_max_chunk_age;    // longest a record waits for a chunk to fill
+        std::vector<mahi::util::uint8> m_ring;     // ring of m_capacity records
+        std::vector<mahi::util::uint8> m_staging;  // record being built with set()
+
+        std::FILE* m_file = nullptr;               // session file
+        std::thread m_writer;                      // runs write_loop()
+        std::atomic<bool> m_closing;               // set to make the writer drain the ring and exit
+        std::atomic<bool> m_write_failed;          // set when a write to the file fails
+        std::atomic<mahi::util::uint64> m_head;    // records recorded, only advanced by the recording thread
+        std::atomic<mahi::util::uint64> m_tail;    // records written, only advanced by the writer thread
+        std::atomic<mahi::util::uint64> m_dropped; // records dropped
+        std::atomic<mahi::util::uint64> m_chunks;  // chunks written
+    };
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Reads a file written by SessionRecorder one chunk at a time
+    class SessionReader {
+    public:
+        /// Constructor
+        SessionReader() { }
+        /// Destructor
+        ~SessionReader() { close(); }
+        SessionReader(const SessionReader&) = delete;
+        SessionReader& operator=(const SessionReader&) = delete;
+
+        /// opens filepath and reads its schema header
+        bool open(const std::string& filepath);
+        /// closes the file
+        void close();
+        /// returns the schema of the open file
+        const RecordSchema& get_schema() const { return m_schema; }
+
+        /// reads the next chunk into records and returns the number of records in it, or 0 at the end
+        /// of the file or at a truncated or corrupt chunk
+        std::size_t read_chunk(std::vector<mahi::util::uint8>& records);
+        /// returns true if reading stopped at a truncated or corrupt chunk rather than the end of the file
+        bool is_damaged() const { return m_damaged; }
+
+    private:
+        RecordSchema m_schema;              // schema from the file header
+        std::FILE* m_file = nullptr;        // session file
+        mahi::util::uint64 m_next = 0;      // index of the next record expected
+        mahi::util::uint64 m_remaining = 0; // bytes of the file not yet read
+        bool m_damaged = false;             // whether a damaged chunk was found
+    };
+
+} // namespace meii
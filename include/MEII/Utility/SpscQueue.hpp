@@ -0,0 +1,95 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Types.hpp>
+#include <atomic>
+#include <vector>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Bounded lock-free queue between exactly one producer thread and one consumer thread.
+    /// Storage is allocated once in the constructor, so push() and pop() never allocate or
+    /// block. When the consumer falls behind and the queue is full, push() drops the new value
+    /// and counts it instead of waiting, which keeps a real-time producer on schedule.
+    template <typename T>
+    class SpscQueue {
+    public:
+        /// Constructor, capacity is rounded up to a power of two
+        explicit SpscQueue(std::size_t capacity) :
+            m_head(0),
+            m_tail(0),
+            m_pushed(0),
+            m_dropped(0)
+        {
+            std::size_t size = 2;
+            while (size < capacity)
+                size *= 2;
+            m_buffer.resize(size);
+            m_mask = size - 1;
+        }
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        /// adds value to the queue, or drops it and returns false if the queue is full (producer thread only)
+        bool push(const T& value) {
+            std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head - m_tail.load(std::memory_order_acquire) > m_mask) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            m_buffer[head & m_mask] = value;
+            m_head.store(head + 1, std::memory_order_release);
+            m_pushed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /// removes the oldest value into value, or returns false if the queue is empty (consumer thread only)
+        bool pop(T& value) {
+            std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail == m_head.load(std::memory_order_acquire))
+                return false;
+            value = m_buffer[tail & m_mask];
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// number of values waiting, exact only when called from the producer or consumer while the other is idle
+        std::size_t size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+        /// maximum number of values the queue holds
+        std::size_t capacity() const { return m_mask + 1; }
+        /// number of values pushed successfully
+        mahi::util::uint64 get_pushed() const { return m_pushed.load(std::memory_order_relaxed); }
+        /// number of values dropped because the queue was full
+        mahi::util::uint64 get_dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    private:
+        std::vector<T> m_buffer;                  // ring storage, size is a power of two
+        std::size_t m_mask;                       // size of m_buffer minus one
+        std::atomic<std::size_t> m_head;          // next slot to write, only advanced by the producer
+        std::atomic<std::size_t> m_tail;          // next slot to read, only advanced by the consumer
+        std::atomic<mahi::util::uint64> m_pushed; // values pushed
+        std::atomic<mahi::util::uint64> m_dropped; // values dropped on a full queue
+    };
+
+} // namespace meii
@@ -0,0 +1,93 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Timing/Time.hpp>
+#include <Mahi/Util/Types.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Records begin/end spans from one thread into a ring of preallocated slots, and writes the
+    /// most recent ones as Chrome trace-event JSON, which chrome://tracing and ui.perfetto.dev
+    /// open directly. Tracing is off until set_enabled(true); while off, record() is a single
+    /// relaxed load. Span times are CycleClock timestamps and span names must outlive the
+    /// recorder, so string literals are the intended names. write_json() may be called from any
+    /// thread while spans are being recorded, and skips any span overwritten while it was copied.
+    class TraceRecorder {
+    public:
+        /// Constructor, no slots are allocated until allocate()
+        TraceRecorder();
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        /// allocates room for the last capacity spans, rounded up to a power of two, only while nothing is being recorded
+        bool allocate(std::size_t capacity);
+        /// turns recording on or off, recording stays off until allocate() has been called
+        void set_enabled(bool enabled);
+        /// returns true if spans are being recorded
+        bool is_enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+        /// records a span from begin to end [CycleClock ticks], index is written as an argument of the span if it is not negative (recording thread only)
+        void record(const char* name, mahi::util::uint64 begin, mahi::util::uint64 end, mahi::util::int32 index = -1) {
+            if (!m_enabled.load(std::memory_order_relaxed))
+                return;
+            mahi::util::uint64 n = m_committed.load(std::memory_order_relaxed);
+            // claim the slot before overwriting it, so a concurrent write_json() knows to skip it
+            m_claimed.store(n + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            Slot& slot = m_slots[n & m_mask];
+            slot.name.store(name, std::memory_order_relaxed);
+            slot.begin.store(begin, std::memory_order_relaxed);
+            slot.end.store(end, std::memory_order_relaxed);
+            slot.index.store(index, std::memory_order_relaxed);
+            m_committed.store(n + 1, std::memory_order_release);
+        }
+
+        /// returns the number of spans the ring holds
+        std::size_t get_capacity() const { return m_slots ? m_mask + 1 : 0; }
+        /// returns the number of spans recorded since allocate(), including those since overwritten
+        mahi::util::uint64 get_recorded() const { return m_committed.load(std::memory_order_acquire); }
+
+        /// writes the spans that ended within window of the newest one, or every span held if window is zero, as Chrome trace-event JSON
+        bool write_json(const std::string& filepath, mahi::util::Time window = mahi::util::Time::Zero, const std::string& thread_name = "control loop") const;
+
+    private:
+        /// One recorded span, atomic so write_json() can copy it while it is overwritten
+        struct Slot {
+            std::atomic<const char*> name;
+            std::atomic<mahi::util::uint64> begin;
+            std::atomic<mahi::util::uint64> end;
+            std::atomic<mahi::util::int32> index;
+        };
+
+        std::unique_ptr<Slot[]> m_slots;               // ring of spans, size is a power of two
+        std::size_t m_mask;                            // size of m_slots minus one
+        std::atomic<bool> m_enabled;                   // spans are recorded while true
+        std::atomic<mahi::util::uint64> m_claimed;     // spans whose slot may have been written
+        std::atomic<mahi::util::uint64> m_committed;   // spans completely written
+    };
+
+} // namespace meii
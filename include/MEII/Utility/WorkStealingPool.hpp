@@ -0,0 +1,83 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+#pragma once
+
+#include <Mahi/Util/Types.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace meii {
+
+    //==============================================================================
+    // CLASS DECLARATION
+    //==============================================================================
+
+    /// Runs tasks on a fixed set of worker threads, one per core by default. Every worker has its
+    /// own deque: tasks submitted from outside are dealt round robin across the deques, and tasks
+    /// submitted from a worker go onto its own. A worker takes the newest task from its own deque
+    /// and, once that is empty, steals the oldest task from another's, so workers stay busy even
+    /// when tasks take very different times and never contend over a single shared queue.
+    class WorkStealingPool {
+    public:
+        /// Constructor, starts threads workers, or one per core if threads is 0
+        explicit WorkStealingPool(std::size_t threads = 0);
+        /// Destructor, waits for every submitted task and stops the workers
+        ~WorkStealingPool();
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        /// queues task to run on a worker, safe to call from any thread including the workers
+        void submit(std::function<void()> task);
+        /// blocks until every submitted task has finished, must not be called from a worker
+        void wait();
+
+        /// returns the number of worker threads
+        std::size_t get_thread_count() const { return m_threads.size(); }
+        /// returns the number of tasks a worker has taken from another's deque
+        mahi::util::uint64 get_steals() const { return m_steals.load(std::memory_order_relaxed); }
+
+    private:
+        /// body of worker
+        void work(std::size_t worker);
+        /// takes the newest task from worker's deque, or the oldest of another's, and returns false if there are none
+        bool take(std::size_t worker, std::function<void()>& task);
+
+        struct Deque {
+            std::mutex mutex;                         // guards tasks
+            std::deque<std::function<void()>> tasks;  // queued tasks, the owner works from the back and thieves from the front
+        };
+
+        std::vector<std::unique_ptr<Deque>> m_deques;  // one per worker
+        std::vector<std::thread> m_threads;           // the workers
+        std::atomic<std::size_t> m_next;              // deque of the next task submitted from outside
+        std::atomic<std::size_t> m_queued;            // tasks waiting in the deques
+        std::atomic<std::size_t> m_unfinished;        // tasks submitted and not yet finished
+        std::atomic<mahi::util::uint64> m_steals;     // tasks taken from another worker's deque
+        std::mutex m_mutex;                           // guards m_stop and the waits on the condition variables
+        std::condition_variable m_work_cv;            // wakes idle workers when a task is queued or the pool stops
+        std::condition_variable m_done_cv;            // wakes wait() when the last task finishes
+        bool m_stop;                                  // set to stop the workers
+    };
+
+} // namespace meii
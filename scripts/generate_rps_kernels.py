@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+Generates src/MEII/MahiExoII/RpsKernels.cpp, the constraint kernels used by
+RpsKinematics::phi_update() and RpsKinematics::phi_d_qp_update().
+
+The constraints are written once below, the jacobian is differentiated
+symbolically, every sin/cos of a variable is replaced by a single sincos call,
+the geometric constants are folded into literals, and common subexpressions are
+eliminated. The hand written expressions in RpsKinematics.cpp are kept as the
+reference that ex_rps_kernels_check compares against.
+
+Requires sympy. Run from the repository root after changing the geometry:
+
+    python scripts/generate_rps_kernels.py
+"""
+
+import math
+import os
+import sympy as sp
+
+# geometric parameters, must match the definitions in RpsKinematics.cpp
+R_ = 0.1044956
+r_ = 0.05288174521
+a56_ = 0.0268986 - 0.0272820
+alpha5_ = 0.094516665054824
+alpha13_ = 5 * math.pi / 180
+
+OUTPUT = os.path.join(os.path.dirname(__file__), "..", "src", "MEII", "MahiExoII", "RpsKernels.cpp")
+
+qp = [sp.Symbol("qp[%d]" % i) for i in range(12)]
+
+# sin and cos of every angle that appears, each computed once with sincos
+angles = [0, 1, 2, 6, 7, 8]
+s = {i: sp.Symbol("s%d" % i) for i in angles}
+c = {i: sp.Symbol("c%d" % i) for i in angles}
+
+
+def constant(value):
+    return sp.Float(repr(value), 17)
+
+
+def phi_leg(i, beta):
+    """the three position constraints of leg i, which is rotated by beta about the x axis"""
+    theta, length = qp[i], qp[3 + i]
+    cb, sb = math.cos(alpha5_ + beta), math.sin(alpha5_ + beta)
+    rc, rs = r_ * math.cos(alpha13_ + beta), r_ * math.sin(alpha13_ + beta)
+    s6, c6, s7, c7, s8, c8 = sp.sin(qp[6]), sp.cos(qp[6]), sp.sin(qp[7]), sp.cos(qp[7]), sp.sin(qp[8]), sp.cos(qp[8])
+    return [
+        length * sp.sin(theta) - qp[9] - constant(rc) * (s6 * s8 - c6 * c8 * s7) - constant(rs) * (c8 * s6 + c6 * s7 * s8),
+        constant(R_ * cb - a56_ * sb) - qp[10] - length * constant(cb) * sp.cos(theta) - constant(rc) * c7 * c8 + constant(rs) * c7 * s8,
+        constant(a56_ * cb + R_ * sb) - qp[11] - length * constant(sb) * sp.cos(theta) - constant(rc) * (c6 * s8 + c8 * s6 * s7) - constant(rs) * (c6 * c8 - s6 * s7 * s8),
+    ]
+
+
+def to_sincos(expr):
+    subs = {}
+    for i in angles:
+        subs[sp.sin(qp[i])] = s[i]
+        subs[sp.cos(qp[i])] = c[i]
+    return expr.subs(subs)
+
+
+def emit(lines, exprs, target):
+    replacements, reduced = sp.cse([to_sincos(e) for e in exprs], symbols=sp.numbered_symbols("x"))
+    for sym, value in replacements:
+        lines.append("        const double %s = %s;" % (sym, sp.ccode(value)))
+    for index, value in zip(target, reduced):
+        lines.append("        %s = %s;" % (index, sp.ccode(value)))
+
+
+def main():
+    phi = phi_leg(0, 0) + phi_leg(1, -2 * math.pi / 3) + phi_leg(2, 2 * math.pi / 3)
+    phi_d_qp = [[sp.diff(phi[row], qp[col]) for col in range(12)] for row in range(9)]
+
+    lines = []
+    lines.append("// This file is generated by scripts/generate_rps_kernels.py. Do not edit it by hand.")
+    lines.append("")
+    lines.append("#include \"RpsKernels.hpp\"")
+    lines.append("#include <cmath>")
+    lines.append("")
+    lines.append("namespace meii {")
+    lines.append("")
+    lines.append("    void rps_phi_kernel(const double* qp, double* phi) {")
+    for i in angles:
+        lines.append("        double s%d, c%d; rps_sincos(qp[%d], s%d, c%d);" % (i, i, i, i, i))
+    emit(lines, phi, ["phi[%d]" % row for row in range(9)])
+    lines.append("    }")
+    lines.append("")
+    lines.append("    void rps_phi_d_qp_kernel(const double* qp, double* phi_d_qp) {")
+    for i in angles:
+        lines.append("        double s%d, c%d; rps_sincos(qp[%d], s%d, c%d);" % (i, i, i, i, i))
+    # column-major, to match Eigen's default storage
+    exprs, targets = [], []
+    for col in range(12):
+        for row in range(9):
+            exprs.append(phi_d_qp[row][col])
+            targets.append("phi_d_qp[%d]" % (col * 9 + row))
+    emit(lines, exprs, targets)
+    lines.append("    }")
+    lines.append("")
+    lines.append("} // namespace meii")
+    lines.append("")
+
+    with open(OUTPUT, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
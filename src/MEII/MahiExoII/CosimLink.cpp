@@ -0,0 +1,106 @@
+#include <MEII/MahiExoII/CosimLink.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include <chrono>
+#include <thread>
+
+using namespace mahi::util;
+using namespace mahi::com;
+
+namespace meii {
+
+    namespace {
+        static_assert(sizeof(CosimRegion) == 160, "CosimRegion must match the documented layout");
+
+        /// waits until counter reaches value, spinning briefly before yielding, returns false after timeout
+        bool wait_for(const std::atomic<uint64>& counter, uint64 value, Time timeout) {
+            if (counter.load(std::memory_order_acquire) >= value)
+                return true;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout.as_microseconds());
+            for (uint64 spins = 0; ; ++spins) {
+                if (counter.load(std::memory_order_acquire) >= value)
+                    return true;
+                if (spins > 1000) {
+                    std::this_thread::yield();
+                    if ((spins & 255) == 0 && std::chrono::steady_clock::now() > deadline)
+                        return false;
+                }
+            }
+        }
+    }
+
+    CosimLink::CosimLink(const std::string& name, Time period, Time timeout) :
+        m_shm(name, OpenOrCreate, sizeof(CosimRegion)),
+        m_region(static_cast<CosimRegion*>(m_shm.get_address())),
+        m_dt(period.as_seconds()),
+        m_timeout(timeout),
+        m_commands(m_region->command_count.load(std::memory_order_acquire)),
+        m_time(0.0)
+    {
+        m_torque.fill(0.0);
+        m_position.fill(0.0);
+        m_velocity.fill(0.0);
+    }
+
+    bool CosimLink::update(Time time) {
+        // a restarted simulator resets the counters, so continue from its count
+        uint64 commands = m_region->command_count.load(std::memory_order_acquire);
+        if (commands < m_commands)
+            m_commands = commands;
+        if (!wait_for(m_region->state_count, m_commands + 1, m_timeout)) {
+            LOG(Error) << "Co-simulation state " << m_commands << " did not arrive within " << m_timeout << ".";
+            return false;
+        }
+        if (m_region->magic != CosimRegion::magic_value || m_region->version != CosimRegion::version_value) {
+            LOG(Error) << "Co-simulation frame has an unknown magic or version.";
+            return false;
+        }
+        m_time = m_region->time;
+        for (std::size_t i = 0; i < n_joints; ++i) {
+            m_position[i] = m_region->position[i];
+            m_velocity[i] = m_region->velocity[i];
+        }
+        return true;
+    }
+
+    bool CosimLink::apply() {
+        // a command is only due once the state it answers has been read
+        if (m_region->state_count.load(std::memory_order_acquire) != m_commands + 1)
+            return false;
+        m_region->dt = m_dt;
+        for (std::size_t i = 0; i < n_joints; ++i)
+            m_region->torque[i] = m_torque[i];
+        m_region->command_count.store(++m_commands, std::memory_order_release);
+        return true;
+    }
+
+    CosimSimulator::CosimSimulator(const std::string& name, Time timeout) :
+        m_shm(name, OpenOrCreate, sizeof(CosimRegion)),
+        m_region(static_cast<CosimRegion*>(m_shm.get_address())),
+        m_timeout(timeout),
+        m_states(0)
+    {
+        m_region->command_count.store(0, std::memory_order_relaxed);
+        m_region->state_count.store(0, std::memory_order_relaxed);
+        m_region->magic = CosimRegion::magic_value;
+        m_region->version = CosimRegion::version_value;
+    }
+
+    void CosimSimulator::publish(double time, const std::array<double, n_joints>& position, const std::array<double, n_joints>& velocity) {
+        m_region->time = time;
+        for (std::size_t i = 0; i < n_joints; ++i) {
+            m_region->position[i] = position[i];
+            m_region->velocity[i] = velocity[i];
+        }
+        m_region->state_count.store(++m_states, std::memory_order_release);
+    }
+
+    bool CosimSimulator::wait_command(std::array<double, n_joints>& torque, double& dt) {
+        if (!wait_for(m_region->command_count, m_states, m_timeout))
+            return false;
+        dt = m_region->dt;
+        for (std::size_t i = 0; i < n_joints; ++i)
+            torque[i] = m_region->torque[i];
+        return true;
+    }
+
+} // namespace meii
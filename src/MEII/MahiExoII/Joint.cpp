@@ -1,7 +1,9 @@
 #include <MEII/MahiExoII/Joint.hpp>
+#include <MEII/Utility/EventLog.hpp>
 #include <Mahi/Util/Math/Functions.hpp>
 #include <Mahi/Util/Logging/Log.hpp>
 #include <iostream>
+#include <sstream>
 
 using namespace mahi::util;
 
@@ -22,27 +24,47 @@ Joint::Joint(const std::string &name,
     m_position_limits(position_limits),
     m_velocity_limit(velocity_limit)
     {
+        // limit warnings can be raised every tick, so they go through the event log rather than LOG
+        auto message = [&](const std::string& what, double limit) {
+            std::ostringstream text;
+            text << "Joint " << name << " " << what << " " << limit;
+            return text.str();
+        };
+        EventLog& events = event_log();
+        m_position_min_event = events.register_event(Warning, message("position exceeded the min position limit", m_position_limits[0]));
+        m_position_max_event = events.register_event(Warning, message("position exceeded the max position limit", m_position_limits[1]));
+        m_velocity_event     = events.register_event(Warning, message("velocity exceeded the velocity limit", m_velocity_limit));
+        m_torque_event       = events.register_event(Warning, message("command torque exceeded the torque limit", m_torque_limit));
+        m_saturation_event   = events.register_event(Warning, message("command torque saturated to", m_torque_limit));
     }
 
 bool Joint::position_limit_exceeded() {
-    get_position();
+    return position_limit_exceeded(get_position());
+}
+
+bool Joint::position_limit_exceeded(double position) {
+    m_position = position;
     bool exceeded = false;
     if (has_position_limits_ && m_position < m_position_limits[0]) {
-        LOG(Warning) << "Joint " << get_name() << " position exceeded the min position limit " << m_position_limits[0] << " with a value of " << m_position;
+        event_log().record(m_position_min_event, m_position);
         exceeded = true;
     }
     if (has_position_limits_ && m_position > m_position_limits[1]) {
-        LOG(Warning) << "Joint " << get_name() << " position exceeded the max position limit " << m_position_limits[1] << " with a value of " << m_position;
+        event_log().record(m_position_max_event, m_position);
         exceeded = true;
     }
     return exceeded;
 }
 
 bool Joint::velocity_limit_exceeded() {
-    get_velocity();
+    return velocity_limit_exceeded(get_velocity());
+}
+
+bool Joint::velocity_limit_exceeded(double velocity) {
+    m_velocity = velocity;
     bool exceeded = false;
     if (has_velocity_limit_ && abs(m_velocity) > m_velocity_limit) {
-        LOG(Warning) << "Joint " << get_name() << " velocity exceeded the velocity limit " << m_velocity_limit << " with a value of " << m_velocity;
+        event_log().record(m_velocity_event, m_velocity);
         exceeded = true;
     }
     return exceeded;
@@ -51,7 +73,7 @@ bool Joint::velocity_limit_exceeded() {
 bool Joint::torque_limit_exceeded() {
     bool exceeded = false;
     if (has_torque_limit_ && abs(m_com_torque) > m_torque_limit) {
-        LOG(Warning) << "Joint " << get_name() << " command torque exceeded the torque limit " << m_torque_limit << " with a value of " << m_com_torque;
+        event_log().record(m_torque_event, m_com_torque);
         exceeded = true;
     }
     return exceeded;
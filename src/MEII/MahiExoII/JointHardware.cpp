@@ -1,4 +1,5 @@
 #include <MEII/MahiExoII/JointHardware.hpp>
+#include <MEII/Utility/EventLog.hpp>
 #include <Mahi/Util/Math/Functions.hpp>
 #include <Mahi/Util/Logging/Log.hpp>
 #include <Mahi/Com/MelShare.hpp>
@@ -99,7 +100,7 @@ void JointHardware::set_torque(double new_torque) {
     if (m_enabled){
         m_com_torque = new_torque;
         if (torque_limit_exceeded()) {
-            LOG(Warning) << "Joint " << get_name() << " command torque saturated to " << m_torque_limit;
+            event_log().record(m_saturation_event, m_com_torque);
             m_torque = clamp(m_com_torque, m_torque_limit);
         }
         else{
@@ -1,4 +1,5 @@
 #include <MEII/MahiExoII/JointVirtual.hpp>
+#include <MEII/Utility/EventLog.hpp>
 #include <Mahi/Util/Math/Functions.hpp>
 #include <Mahi/Util/Logging/Log.hpp>
 #include <Mahi/Com/MelShare.hpp>
@@ -19,7 +20,23 @@ JointVirtual::JointVirtual(const std::string &name,
     Joint(name,position_limits,velocity_limit,torque_limit,limiter),
     ms_torque(ms_trq),
     ms_posvel(ms_pos),
-    m_rest_pos(rest_pos)
+    m_rest_pos(rest_pos),
+    m_plant_joint(0)
+    {
+
+    }
+
+JointVirtual::JointVirtual(const std::string &name,
+                           std::array<double, 2> position_limits,
+                           double velocity_limit,
+                           double torque_limit,
+                           mahi::robo::Limiter limiter,
+                           std::shared_ptr<SimulatedPlant> plant,
+                           std::size_t plant_joint):
+    Joint(name,position_limits,velocity_limit,torque_limit,limiter),
+    m_rest_pos(plant->get_position(plant_joint)),
+    m_plant(plant),
+    m_plant_joint(plant_joint)
     {
 
     }
@@ -38,11 +55,15 @@ bool JointVirtual::disable() {
 }
 
 double JointVirtual::get_position() {
+    if (m_plant)
+        return m_plant->get_position(m_plant_joint);
     std::vector<double> pos_vel_data = ms_posvel->read_data();
     return !pos_vel_data.empty() ? pos_vel_data[0] : m_rest_pos;
 }
 
 double JointVirtual::get_velocity() {
+    if (m_plant)
+        return m_plant->get_velocity(m_plant_joint);
     std::vector<double> pos_vel_data = ms_posvel->read_data();
     return !pos_vel_data.empty() ? pos_vel_data[1] : 0.0;
 }
@@ -51,13 +72,16 @@ void JointVirtual::set_torque(double new_torque) {
     if (m_enabled){
         m_com_torque = new_torque;
         if (torque_limit_exceeded()) {
-            LOG(Warning) << "Joint " << get_name() << " command torque saturated to " << m_torque_limit;
+            event_log().record(m_saturation_event, m_com_torque);
             m_torque = clamp(m_com_torque, m_torque_limit);
         }
         else{
             m_torque = m_com_torque;
         }
-        ms_torque->write_data({m_torque});
+        if (m_plant)
+            m_plant->set_torque(m_plant_joint, m_torque);
+        else
+            ms_torque->write_data({m_torque});
     }
 }
 } // namespace meii
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include <MEII/MahiExoII/LoopProfiler.hpp>
+#include <iomanip>
+#include <sstream>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    LoopProfiler::LoopProfiler(Time period) :
+        m_misses(0),
+        m_last_tick(0)
+    {
+        set_period(period);
+        // the clock calibrates on first use, which spins for about 10 ms, so do it here rather than on the first tick
+        CycleClock::ns_per_tick();
+    }
+
+    void LoopProfiler::set_period(Time period) {
+        m_miss_ns = static_cast<uint64>(period.as_microseconds()) * 1500;
+    }
+
+    void LoopProfiler::begin_tick() {
+        uint64 now = CycleClock::now();
+        if (m_last_tick != 0) {
+            uint64 ns = CycleClock::to_ns(now - m_last_tick);
+            m_histograms[Period].record(ns);
+            m_trace.record(stage_name(Period), m_last_tick, now);
+            if (ns > m_miss_ns)
+                m_misses.store(m_misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        m_last_tick = now;
+    }
+
+    void LoopProfiler::reset() {
+        for (int i = 0; i < n_stages; ++i)
+            m_histograms[i].reset();
+        m_misses.store(0, std::memory_order_relaxed);
+        m_last_tick = 0;
+    }
+
+    const char* LoopProfiler::stage_name(Stage stage) {
+        static const char* names[n_stages] = { "daq read", "kinematics", "controllers", "rps torques", "daq write", "period" };
+        return names[stage];
+    }
+
+    std::string LoopProfiler::report() const {
+        std::ostringstream out;
+        out << std::left << std::setw(13) << "stage" << std::right
+            << std::setw(10) << "count" << std::setw(10) << "p50"
+            << std::setw(10) << "p99" << std::setw(10) << "p99.9"
+            << std::setw(10) << "max" << "  [us]\n";
+        out << std::fixed << std::setprecision(1);
+        for (int i = 0; i < n_stages; ++i) {
+            const LatencyHistogram& histogram = m_histograms[i];
+            if (histogram.get_count() == 0)
+                continue;
+            out << std::left << std::setw(13) << stage_name(static_cast<Stage>(i)) << std::right
+                << std::setw(10) << histogram.get_count()
+                << std::setw(10) << histogram.get_percentile(0.5) * 1e-3
+                << std::setw(10) << histogram.get_percentile(0.99) * 1e-3
+                << std::setw(10) << histogram.get_percentile(0.999) * 1e-3
+                << std::setw(10) << histogram.get_max() * 1e-3 << "\n";
+        }
+        out << "deadline misses: " << get_misses();
+        return out.str();
+    }
+
+} // namespace meii
@@ -1,5 +1,7 @@
 #include <MEII/MahiExoII/MahiExoII.hpp>
 #include <MEII/MahiExoII/Joint.hpp>
+#include <MEII/MahiExoII/RpsLookupTable.hpp>
+#include <MEII/Utility/EventLog.hpp>
 #include <Mahi/Daq/Quanser/Q8Usb.hpp>
 #include <Mahi/Util/Math/Functions.hpp>
 #include <Mahi/Util/Timing/Timer.hpp>
@@ -14,26 +16,18 @@ using namespace mahi::robo;
 
 namespace meii {  
 
-    // geometric parameters
-    const double MahiExoII::R_ = 0.1044956;
-    const double MahiExoII::r_ = 0.05288174521;
-    const double MahiExoII::a56_ = 0.0268986 - 0.0272820;
-    const double MahiExoII::alpha5_ = 0.094516665054824;
-    const double MahiExoII::alpha13_ = 5 * DEG2RAD;
-
     ///////////////////////// STANDARD CLASS FUNCTIONS AND PARAMS /////////////////////////
 
     MahiExoII::MahiExoII(MeiiParameters parameters) :
         Device("mahi_exo_ii"),
-        params_(parameters)
+        params_(parameters),
+        m_safety_monitor(parameters)
     {
 
         for (int i = 0; i < n_aj; i++) {
             m_anatomical_joint_positions.push_back(0.0);
             m_anatomical_joint_velocities.push_back(0.0);
             m_anatomical_joint_torques.push_back(0.0);
-            m_robot_joint_positions.push_back(0.0);
-            m_robot_joint_velocities.push_back(0.0);
             m_robot_joint_torques.push_back(0.0);
         }
         std::vector<double> rps_par_joint_speed_(robot_joint_speed.begin()+2,robot_joint_speed.end());
@@ -44,9 +38,13 @@ namespace meii {
         if (is_enabled()) {
             disable();
         }
+        if (m_profiler.get_histogram(LoopProfiler::Kinematics).get_count() > 0)
+            LOG(Info) << "MahiExoII control loop latencies:\n" << m_profiler.report();
     }
 
     bool MahiExoII::on_enable() {
+        // the time spent disabled is not a loop period
+        m_profiler.restart();
         for(auto it = meii_joints.begin(); it != meii_joints.end(); ++it){
             if (!(*it)->enable()){
                 LOG(Error) << "Failed to enable joints. Disabling MEII.";
@@ -65,6 +63,8 @@ namespace meii {
                 successful = false;
             } 
         }
+        // log any limit events raised since the last report rather than waiting for the next one
+        event_log().flush();
         return successful;
     }
 
@@ -153,6 +153,7 @@ namespace meii {
     ///////////////////////// TORQUE SETTING FUNCTIONS /////////////////////////
 
     std::vector<double> MahiExoII::set_robot_smooth_pos_ctrl_torques(SmoothReferenceTrajectory& robot_ref, Time current_time) {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Controllers);
 
         std::vector<double> command_torques(n_aj, 0.0);
         
@@ -175,6 +176,7 @@ namespace meii {
     }
 
     std::vector<double> MahiExoII::set_anat_smooth_pos_ctrl_torques(SmoothReferenceTrajectory& anat_ref, Time current_time) {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Controllers);
 
         std::vector<double> command_torques(n_aj, 0.0);
 
@@ -197,6 +199,7 @@ namespace meii {
     }
 
     std::vector<double> MahiExoII::set_robot_pos_ctrl_torques(std::vector<double> ref, std::vector<bool> active){
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Controllers);
         
         std::vector<double> robot_command_torques(n_aj, 0.0);
 
@@ -211,7 +214,7 @@ namespace meii {
         
         for (std::size_t i = 0; i < n_aj; ++i) {
             if (active[i]){
-                robot_command_torques[i] = robot_joint_pd_controllers_[i].calculate(ref[i], m_robot_joint_positions[i], 0, m_robot_joint_velocities[i]);
+                robot_command_torques[i] = robot_joint_pd_controllers_[i].calculate(ref[i], m_joint_state.position[i], 0, m_joint_state.velocity[i]);
             }
         }
         set_robot_raw_joint_torques(robot_command_torques);
@@ -220,6 +223,7 @@ namespace meii {
     }
 
     std::vector<double> MahiExoII::set_anat_pos_ctrl_torques(std::vector<double> ref, std::vector<bool> active){
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Controllers);
         
         std::vector<double> anat_command_torques(n_aj, 0.0);
 
@@ -247,8 +251,8 @@ namespace meii {
         // update reference
         m_robot_joint_torques = new_torques;
 
-        for (auto it = meii_joints.begin(); it != meii_joints.end(); ++it) {
-            (*it)->set_torque(new_torques[it - meii_joints.begin()]);
+        for (std::size_t i = 0; i < meii_joints.size(); ++i) {
+            set_joint_torque(i, new_torques[i]);
         }
     }
 
@@ -260,39 +264,100 @@ namespace meii {
         m_robot_joint_torques[1] = new_torques[1];
         
         // set torques for first two anatomical joints, which have actuators
-        meii_joints[0]->set_torque(new_torques[0]);
-        meii_joints[1]->set_torque(new_torques[1]);
+        set_joint_torque(0, new_torques[0]);
+        set_joint_torque(1, new_torques[1]);
 
         // write the parallel torques using set_rps_ser_torques which converts serial to parallel
-        std::vector<double> tau_ser = std::vector<double>(new_torques.begin() + 2, new_torques.end());
-        set_rps_ser_torques(tau_ser);
+        set_rps_ser_torques(RpsKinematics::VectorQs(new_torques[2], new_torques[3], new_torques[4]));
     }
 
-    void MahiExoII::solve_static_rps_torques(std::vector<uint8> select_q, const Eigen::VectorXd& tau_b, const Eigen::VectorXd& qp, Eigen::VectorXd& tau_s) const {
-        Eigen::MatrixXd rho = Eigen::MatrixXd::Zero(n_qp - n_qs, n_qs);
-        generate_rho(select_q, qp, rho);
-        tau_s = -rho.transpose() * tau_b;
+    void MahiExoII::set_robot_smooth_pos_ctrl_torques(SmoothReferenceTrajectory& robot_ref, Time current_time, JointArray& command_torques) {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Controllers);
+
+        size_t num_active = 0;
+
+        for (size_t i = 0; i < n_rj; i++){
+            command_torques[i] = 0.0;
+            // if the dof is active, calculate the torque to use, else it remains 0
+            if (robot_ref.m_active_dofs[i]){
+                double smooth_ref = robot_ref.calculate_smooth_ref(num_active, current_time);
+                command_torques[i] = robot_joint_pd_controllers_[i].calculate(smooth_ref, m_joint_state.position[i], 0, m_joint_state.velocity[i]);
+                num_active++;
+            }
+        }
+        set_robot_raw_joint_torques_array(command_torques);
     }
 
-    void MahiExoII::solve_static_rps_torques(std::vector<uint8> select_q, const Eigen::VectorXd& tau_b, const Eigen::VectorXd& qp, Eigen::VectorXd& tau_s, Eigen::VectorXd& tau_p) const {
-        solve_static_rps_torques(select_q, tau_b, qp, tau_s);
-        for (int i = 0; i < n_qs; ++i) {
-            tau_p[select_q[i]] = tau_s[i];
+    void MahiExoII::set_anat_smooth_pos_ctrl_torques(SmoothReferenceTrajectory& anat_ref, Time current_time, JointArray& command_torques) {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Controllers);
+
+        size_t num_active = 0;
+
+        for (size_t i = 0; i < n_aj; i++){
+            command_torques[i] = 0.0;
+            // if the dof is active, calculate the torque to use, else it remains 0
+            if (anat_ref.m_active_dofs[i]){
+                double smooth_ref = anat_ref.calculate_smooth_ref(num_active, current_time);
+                command_torques[i] = anatomical_joint_pd_controllers_[i].calculate(smooth_ref, m_anatomical_joint_positions[i], 0, m_anatomical_joint_velocities[i]);
+                num_active++;
+            }
+        }
+        set_anatomical_raw_joint_torques_array(command_torques);
+    }
+
+    void MahiExoII::set_robot_pos_ctrl_torques(const JointArray& ref, JointArray& command_torques, const JointMask& active) {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Controllers);
+        for (std::size_t i = 0; i < n_rj; ++i) {
+            command_torques[i] = active[i] ? robot_joint_pd_controllers_[i].calculate(ref[i], m_joint_state.position[i], 0, m_joint_state.velocity[i]) : 0.0;
         }
-        std::vector<uint8> indices = select_q_invert(select_q);
-        for (int i = 0; i < n_qp - n_qs; ++i) {
-            tau_p[indices.at(i)] = tau_b[i];
+        set_robot_raw_joint_torques_array(command_torques);
+    }
+
+    void MahiExoII::set_anat_pos_ctrl_torques(const JointArray& ref, JointArray& command_torques, const JointMask& active) {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Controllers);
+        for (std::size_t i = 0; i < n_aj; ++i) {
+            command_torques[i] = active[i] ? anatomical_joint_pd_controllers_[i].calculate(ref[i], m_anatomical_joint_positions[i], 0, m_anatomical_joint_velocities[i]) : 0.0;
         }
+        set_anatomical_raw_joint_torques_array(command_torques);
+    }
+
+    void MahiExoII::set_robot_raw_joint_torques_array(const JointArray& new_torques) {
+        for (std::size_t i = 0; i < n_rj; ++i) {
+            m_robot_joint_torques[i] = new_torques[i];
+            set_joint_torque(i, new_torques[i]);
+        }
+    }
+
+    void MahiExoII::set_anatomical_raw_joint_torques_array(const JointArray& new_torques) {
+        std::copy(new_torques.begin(), new_torques.end(), m_anatomical_joint_torques.begin());
+        m_robot_joint_torques[0] = new_torques[0];
+        m_robot_joint_torques[1] = new_torques[1];
+
+        // set torques for first two anatomical joints, which have actuators
+        set_joint_torque(0, new_torques[0]);
+        set_joint_torque(1, new_torques[1]);
+
+        // write the parallel torques using set_rps_ser_torques which converts serial to parallel
+        set_rps_ser_torques(RpsKinematics::VectorQs(new_torques[2], new_torques[3], new_torques[4]));
     }
 
-    void MahiExoII::set_rps_ser_torques(std::vector<double>& tau_ser) {
-        Eigen::VectorXd tau_ser_eig = copy_stdvec_to_eigvec(tau_ser);
-        m_tau_par_rob = m_jac_fk.transpose() * tau_ser_eig;
+    void MahiExoII::set_rps_ser_torques(const RpsKinematics::VectorQs& tau_ser) {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::RpsTorques);
+        m_tau_par_rob.noalias() = m_jac_fk.transpose() * tau_ser;
         for (int i = 0; i < n_qs; ++i) {
-            meii_joints[i + 2]->set_torque(m_tau_par_rob[i]);
+            set_joint_torque(i + 2, m_tau_par_rob[i]);
             m_robot_joint_torques[i+2] = m_tau_par_rob[i];
         }
-        m_tau_ser_rob = -tau_ser_eig;
+        m_tau_ser_rob = -tau_ser;
+    }
+
+    void MahiExoII::set_joint_torque(std::size_t joint, double torque) {
+        LoopProfiler::Span span(m_profiler, "Joint::set_torque", static_cast<int32>(joint));
+        Joint* j = meii_joints[joint].get();
+        j->set_torque(torque);
+        // kept in the snapshot as they are set, so check_limits() sees this tick's torques without visiting the joints
+        m_joint_state.command_torque[joint] = torque;
+        m_joint_state.torque[joint] = j->get_torque_command();
     }
 
     /////////////////// GOAL CHECKING FUNCTIONS ///////////////////
@@ -332,33 +397,28 @@ namespace meii {
 
     /////////////////// LIMIT CHECKING ON THE MEII ///////////////////
 
+    uint32 MahiExoII::check_limits(uint32 limits){
+        // set_joint_torque() keeps the snapshot's torques up to date with this tick's commands
+        return m_safety_monitor.check(m_joint_state, limits);
+    }
+
     bool MahiExoII::any_limit_exceeded(){
-        return (any_velocity_limit_exceeded() || any_torque_limit_exceeded());
+        return check_limits(SafetyMonitor::limit_mask(SafetyMonitor::Velocity) | SafetyMonitor::limit_mask(SafetyMonitor::Torque)) != 0;
     }
 
     bool MahiExoII::any_velocity_limit_exceeded(){
-        bool exceeded = false;
-        for (auto it = meii_joints.begin(); it != meii_joints.end(); ++it) {
-            if ((*it)->velocity_limit_exceeded())
-                exceeded = true;
-        }
-        return exceeded;
+        return check_limits(SafetyMonitor::limit_mask(SafetyMonitor::Velocity)) != 0;
     }
 
     bool MahiExoII::any_torque_limit_exceeded(){
-        bool exceeded = false;
-        for (auto it = meii_joints.begin(); it != meii_joints.end(); ++it) {
-            if ((*it)->torque_limit_exceeded())
-                exceeded = true;
-        }
-        return exceeded;
+        return check_limits(SafetyMonitor::limit_mask(SafetyMonitor::Torque)) != 0;
     }
 
     /////////////////// PUBLIC FACING ROBOT STATE ACCESS ///////////////////
     // see MahiExoII.hpp for the remaining single line functions 
 
     std::vector<double> MahiExoII::get_wrist_parallel_positions() const {
-        return std::vector<double>(m_robot_joint_positions.begin()+2,m_robot_joint_positions.end());
+        return std::vector<double>(m_joint_state.position.begin()+2,m_joint_state.position.end());
     }
 
     std::vector<double> MahiExoII::get_wrist_serial_positions() const {
@@ -368,27 +428,50 @@ namespace meii {
     ///////////// KINEMATIC UPDATE FUNCTIONS ///////////////
 
     void MahiExoII::update_kinematics() {
-        // update m_q_par (q parallel) with the three prismatic link positions
-        m_q_par << meii_joints[2]->get_position(), meii_joints[3]->get_position(), meii_joints[4]->get_position();
-        m_q_par_dot << meii_joints[2]->get_velocity(), meii_joints[3]->get_velocity(), meii_joints[4]->get_velocity();
+        m_profiler.begin_tick();
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::Kinematics);
 
         // update joint velocities if necessary (only if using hardware version and filtering is done in software) 
         // otherwise this does nothing
         for (size_t i = 0; i < n_rj; i++){
+            LoopProfiler::Span span(m_profiler, "Joint::filter_velocity", static_cast<int32>(i));
             meii_joints[i]->filter_velocity();
         }
 
+        // read every joint exactly once. everything else this tick reads the snapshot instead of the joints
+        m_joint_state.time = get_loop_time();
+        m_joint_state.tick++;
         for (size_t i = 0; i < n_rj; i++){
-            m_robot_joint_positions[i] = meii_joints[i]->get_position();
-            m_robot_joint_velocities[i] = meii_joints[i]->get_velocity();
+            LoopProfiler::Span span(m_profiler, "Joint read", static_cast<int32>(i));
+            Joint* joint = meii_joints[i].get();
+            m_joint_state.position[i] = joint->get_position();
+            m_joint_state.velocity[i] = joint->get_velocity();
+            m_joint_state.command_torque[i] = joint->get_unlimited_torque_command();
+            m_joint_state.torque[i] = joint->get_torque_command();
+        }
+
+        // update m_q_par (q parallel) with the three prismatic link positions
+        m_q_par << m_joint_state.position[2], m_joint_state.position[3], m_joint_state.position[4];
+        m_q_par_dot << m_joint_state.velocity[2], m_joint_state.velocity[3], m_joint_state.velocity[4];
+
+        // while the wrist is held still the encoder counts, and so m_q_par, repeat exactly and a cached solution can be reused.
+        // otherwise run forward kinematics solver to update q_ser (q serial) and m_qp (q prime), which contains all 12 RPS positions
+        // m_qp still holds the previous solution, which is nearly exact at 1 kHz, so it is used as the initial guess
+        RpsSolveInfo kin_info;
+        if (m_kin_cache_enabled && m_kin_cache.lookup(m_q_par, m_q_ser, m_qp, m_rho_fk, m_jac_fk)) {
+            RpsKinematics::map_velocity(rps_select_par, m_rho_fk, m_jac_fk, m_q_par_dot, m_q_ser_dot, m_qp_dot);
+            kin_info.converged = true; // only converged solutions are cached
+        }
+        else {
+            kin_info = m_rps_kinematics.forward_velocity(m_q_par, m_q_ser, m_qp, m_rho_fk, m_jac_fk, m_q_par_dot, m_q_ser_dot, m_qp_dot, m_kin_warm_start);
+            m_kin_stats.record(kin_info);
+            if (m_kin_cache_enabled && kin_info.converged)
+                m_kin_cache.insert(m_q_par, m_q_ser, m_qp, m_rho_fk, m_jac_fk);
         }
 
-        // run forward kinematics solver to update q_ser (q serial) and m_qp (q prime), which contains all 12 RPS positions
-        forward_rps_kinematics_velocity(m_q_par, m_q_ser, m_qp, m_rho_fk, m_jac_fk, m_q_par_dot, m_q_ser_dot, m_qp_dot);
-        
         // get positions from first two anatomical joints, which have encoders
-        m_anatomical_joint_positions[0] = m_robot_joint_positions[0]; // elbow flexion/extension
-        m_anatomical_joint_positions[1] = m_robot_joint_positions[1]; // forearm pronation/supination
+        m_anatomical_joint_positions[0] = m_joint_state.position[0]; // elbow flexion/extension
+        m_anatomical_joint_positions[1] = m_joint_state.position[1]; // forearm pronation/supination
 
         // get positions from forward kinematics solver for three wrist anatomical joints 
         m_anatomical_joint_positions[2] = m_q_ser[0]; // wrist flexion/extension
@@ -396,185 +479,100 @@ namespace meii {
         m_anatomical_joint_positions[4] = m_q_ser[2]; // arm translation
 
         // get velocities from first two anatomical joints, which have encoders
-        m_anatomical_joint_velocities[0] = m_robot_joint_velocities[0]; // elbow flexion/extension
-        m_anatomical_joint_velocities[1] = m_robot_joint_velocities[1]; // forearm pronation/supination
+        m_anatomical_joint_velocities[0] = m_joint_state.velocity[0]; // elbow flexion/extension
+        m_anatomical_joint_velocities[1] = m_joint_state.velocity[1]; // forearm pronation/supination
 
         // get velocities from forward kinematics solver for three wrist anatomical joints 
         m_anatomical_joint_velocities[2] = m_q_ser_dot[0]; // wrist flexion/extension
         m_anatomical_joint_velocities[3] = m_q_ser_dot[1]; // wrist radial/ulnar deviation
         m_anatomical_joint_velocities[4] = m_q_ser_dot[2]; // arm translation
-    }
 
-    void MahiExoII::forward_rps_kinematics(const Eigen::VectorXd& q_par_in, Eigen::VectorXd& q_ser_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_fk, Eigen::MatrixXd& jac_fk) const {
-        Eigen::MatrixXd rho_s = Eigen::MatrixXd::Zero(n_qp, n_qs);
-        solve_rps_kinematics(m_select_q_par, q_par_in, qp_out, rho_fk, rho_s, m_max_it, m_tol);
-        q_ser_out << qp_out(m_select_q_ser[0]), qp_out(m_select_q_ser[1]), qp_out(m_select_q_ser[2]);
-        for (int i = 0; i < n_qs; ++i) {
-            jac_fk.row(i) = rho_s.row(m_select_q_ser[i]);
+        // publish the state for other threads
+        m_state_frame.tick = m_joint_state.tick;
+        m_state_frame.time = m_joint_state.time.as_seconds();
+        m_state_frame.kinematics_converged = kin_info.converged;
+        m_state_frame.robot_positions = m_joint_state.position;
+        m_state_frame.robot_velocities = m_joint_state.velocity;
+        m_state_frame.robot_torques = m_joint_state.torque;
+        for (std::size_t i = 0; i < n_aj; ++i) {
+            m_state_frame.anatomical_positions[i] = m_anatomical_joint_positions[i];
+            m_state_frame.anatomical_velocities[i] = m_anatomical_joint_velocities[i];
+            m_state_frame.anatomical_torques[i] = m_anatomical_joint_torques[i];
         }
+        m_state_publisher.publish(m_state_frame);
     }
 
-    void MahiExoII::forward_rps_kinematics_velocity(const Eigen::VectorXd& q_par_in, Eigen::VectorXd& q_ser_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_fk, Eigen::MatrixXd& jac_fk, const Eigen::VectorXd& q_par_dot_in, Eigen::VectorXd& q_ser_dot_out, Eigen::VectorXd& qp_dot_out) const {
-        forward_rps_kinematics(q_par_in, q_ser_out, qp_out, rho_fk, jac_fk);
-        // here on is velocity
-        q_ser_dot_out = jac_fk * q_par_dot_in;
-        Eigen::VectorXd qb_dot = Eigen::VectorXd::Zero(n_qp - n_qs);
-        qb_dot = rho_fk * q_par_dot_in;
-        for (int i = 0; i < n_qs; ++i) {
-            qp_dot_out[m_select_q_ser[i]] = q_ser_dot_out[i];
-        }
-        std::vector<uint8> indices = select_q_invert(m_select_q_ser);
-        for (int i = 0; i < n_qp - n_qs; ++i) {
-            qp_dot_out[indices[i]] = qb_dot[i];
+    RpsValidationResult MahiExoII::validate_kinematics(std::size_t n_grid) const {
+        RpsKinematics::VectorQs q_par_min, q_par_max;
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            q_par_min[i] = params_.pos_limits_min_[i + 2];
+            q_par_max[i] = params_.pos_limits_max_[i + 2];
         }
+        return m_rps_kinematics.validate_reduced(q_par_min, q_par_max, n_grid);
     }
 
-    void MahiExoII::inverse_rps_kinematics(const Eigen::VectorXd& q_ser_in, Eigen::VectorXd& q_par_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_ik, Eigen::MatrixXd& jac_ik) const {
-        Eigen::MatrixXd rho_s = Eigen::MatrixXd::Zero(n_qp, n_qs);
-        solve_rps_kinematics(m_select_q_ser, q_ser_in, qp_out, rho_ik, rho_s, m_max_it, m_tol);
-        q_par_out << qp_out(m_select_q_par[0]), qp_out(m_select_q_par[1]), qp_out(m_select_q_par[2]);
-        for (int i = 0; i < n_qs; ++i) {
-            jac_ik.row(i) = rho_s.row(m_select_q_par[i]);
+    RpsValidationResult MahiExoII::validate_kinematics_table(std::size_t n_grid) const {
+        RpsKinematics::VectorQs q_par_min, q_par_max;
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            q_par_min[i] = params_.pos_limits_min_[i + 2];
+            q_par_max[i] = params_.pos_limits_max_[i + 2];
         }
+        return m_rps_kinematics.validate_table(q_par_min, q_par_max, n_grid);
     }
 
-    void MahiExoII::inverse_rps_kinematics_velocity(const Eigen::VectorXd& q_ser_in, Eigen::VectorXd& q_par_out, Eigen::VectorXd& qp_out, Eigen::MatrixXd& rho_ik, Eigen::MatrixXd& jac_ik, const Eigen::VectorXd& q_ser_dot_in, Eigen::VectorXd& q_par_dot_out, Eigen::VectorXd& qp_dot_out) const {
-        inverse_rps_kinematics(q_ser_in, q_par_out, qp_out, rho_ik, jac_ik);
-        q_par_dot_out = jac_ik * q_ser_dot_in;
-        Eigen::VectorXd qb_dot = Eigen::VectorXd::Zero(n_qp - n_qs);
-        qb_dot = rho_ik * q_ser_dot_in;
-        for (int i = 0; i < n_qs; ++i) {
-            qp_dot_out[m_select_q_par.at(i)] = q_par_dot_out[i];
-        }
-        std::vector<uint8> indices = select_q_invert(m_select_q_par);
-        for (int i = 0; i < n_qp - n_qs; ++i) {
-            qp_dot_out[indices.at(i)] = qb_dot[i];
+    bool MahiExoII::load_kinematics_table(const std::string& filepath, std::size_t check_grid) {
+        auto table = std::make_shared<RpsLookupTable>();
+        if (!table->open(filepath))
+            return false;
+        m_rps_kinematics.set_lookup_table(table);
+        m_rps_kinematics.set_forward_method(RpsFkMethod::Table);
+        m_kin_cache.clear();
+        // checked here, before the loop, since each check point is a full solve
+        if (check_grid > 0) {
+            RpsValidationResult check = validate_kinematics_table(check_grid);
+            LOG(Info) << "Kinematics table " << filepath << " answered " << check.samples - check.table_misses << " of " << check.samples
+                      << " checks, max q_ser error " << check.max_q_ser_error << ", max relative jac_fk error " << check.max_jac_fk_error << ".";
         }
+        return true;
     }
 
-    void MahiExoII::solve_rps_kinematics(std::vector<uint8> select_q, const Eigen::VectorXd& qs, Eigen::VectorXd& qp, Eigen::MatrixXd& rho, Eigen::MatrixXd& rho_s, uint32 max_it, double tol) const {
-
-        // build selection matrix
-        Eigen::MatrixXd A = Eigen::MatrixXd::Zero(n_qs, n_qp);
-        for (int i = 0; i < n_qs; ++i) {
-            A(i, select_q[i]) = 1;
-        }
-
-        // initialize variable containing solution
-        qp << PI / 4, PI / 4, PI / 4, 0.1305, 0.1305, 0.1305, 0, 0, 0, 0.0923, 0, 0;
-
-        // initialize temporary variables containing kinematic constraints etc.
-        Eigen::VectorXd phi = Eigen::VectorXd::Zero(n_qp - n_qs);
-        Eigen::MatrixXd phi_d_qp = Eigen::MatrixXd::Zero(n_qp - n_qs, n_qp);
-        Eigen::VectorXd psi = Eigen::VectorXd::Zero(n_qp);
-        Eigen::MatrixXd psi_d_qp = Eigen::MatrixXd::Zero(n_qp, n_qp);
-        Eigen::MatrixXd rho_rhs = Eigen::MatrixXd::Zero(n_qp, n_qs);
-        rho_rhs.bottomRows(n_qs) = Eigen::MatrixXd::Identity(n_qs, n_qs);
-
-        // initialize variables for keeping track of error
-        double err = 2 * tol;
-        bool first_non_zero = true;
-
-        // run no more than max_it iterations of updating the solution for m_qp
-        // exit loop once the error is below the input tolerance
-        uint32 it = 0;
-        while (it < max_it && err > tol) {
-            psi_update(A, qs, qp, phi, psi); // calculate 9 constraints and tracking error on specified qs_
-            psi_d_qp_update(A, qp, phi_d_qp, psi_d_qp); // derivative of psi w.r.t. qp, giving a 12x12 matrix      
-            qp -= psi_d_qp.fullPivLu().solve(psi);
-
-            // update the error. this ends up being sqrt of sum of squares
-            err = 0;
-            for (auto j = 0; j != n_qp; ++j) {
-                err += psi[j]*psi[j];
-            }
-            err = sqrt(err);
-
-            // while iterator
-            it++;
-        }
-
-        rho_s = psi_d_qp.fullPivLu().solve(rho_rhs);
-
-        // remove rows corresponding to q_select indices
-        std::vector<uint8> indices = select_q_invert(select_q);
-        for (int i = 0; i < n_qp - n_qs; ++i) {
-            rho.row(i) = rho_s.row(indices.at(i));
+    RpsSolveInfo MahiExoII::inverse_kinematics(const RpsKinematics::VectorQs& q_ser, RpsKinematics::VectorQs& q_par) {
+        RpsSolveInfo info = m_rps_kinematics.inverse(q_ser, m_q_par_ik, m_qp_ik, m_rho_ik, m_jac_ik, true);
+        m_ik_stats.record(info);
+        if (!info.converged) {
+            // don't seed the next solve from a failed one
+            m_qp_ik = RpsKinematics::qp_guess();
+            return info;
         }
+        q_par = m_q_par_ik;
+        return info;
     }
 
-    void MahiExoII::generate_rho(std::vector<uint8> select_q, const Eigen::VectorXd& qp, Eigen::MatrixXd& rho) const {
-
-        // build selection matrix
-        Eigen::MatrixXd A = Eigen::MatrixXd::Zero(n_qs, n_qp);
-        for (int i = 0; i < n_qs; ++i) {
-            A(i, select_q[i]) = 1;
+    RpsSolveInfo MahiExoII::inverse_kinematics_velocity(const RpsKinematics::VectorQs& q_ser, const RpsKinematics::VectorQs& q_ser_dot, RpsKinematics::VectorQs& q_par, RpsKinematics::VectorQs& q_par_dot) {
+        RpsSolveInfo info = inverse_kinematics(q_ser, q_par);
+        if (info.converged) {
+            q_par_dot.noalias() = m_jac_ik * q_ser_dot;
         }
-
-        // initialize temporary variables containing kinematic constraints etc.
-        Eigen::MatrixXd phi_d_qp = Eigen::MatrixXd::Zero(n_qp - n_qs, n_qp);
-        Eigen::MatrixXd psi_d_qp = Eigen::MatrixXd::Zero(n_qp, n_qp);
-        Eigen::MatrixXd rho_s = Eigen::MatrixXd::Zero(n_qp, n_qs);
-        Eigen::MatrixXd rho_rhs = Eigen::MatrixXd::Zero(n_qp, n_qs);
-        rho_rhs.bottomRows(n_qs) = Eigen::MatrixXd::Identity(n_qs, n_qs);
-
-        // compute rho_s
-        psi_d_qp_update(A, qp, phi_d_qp, psi_d_qp);
-        rho_s = psi_d_qp.fullPivLu().solve(rho_rhs);
-
-        // remove rows corresponding to q_select indices
-        std::vector<uint8> indices = select_q_invert(select_q);
-        for (int i = 0; i < n_qp - n_qs; ++i) {
-            rho.row(i) = rho_s.row(indices.at(i));
-        }
-
-    }
-
-    void MahiExoII::psi_update(const Eigen::MatrixXd& A, const Eigen::VectorXd& qs, const Eigen::VectorXd& qp, Eigen::VectorXd& phi, Eigen::VectorXd& psi) const {
-        phi_update(qp, phi);
-        psi.head(n_qp - n_qs) = phi;
-        psi.tail(n_qs) = A*qp - qs;
-    }
-
-
-    void MahiExoII::psi_d_qp_update(const Eigen::MatrixXd& A, const Eigen::VectorXd& qp, Eigen::MatrixXd& phi_d_qp, Eigen::MatrixXd& psi_d_qp) const {
-        phi_d_qp_update(qp, phi_d_qp);
-        psi_d_qp.block<n_qp - n_qs, n_qp>(0, 0) = phi_d_qp;
-        psi_d_qp.block<n_qs, n_qp>(n_qp - n_qs, 0) = A;
-    }
-
-    void MahiExoII::phi_update(const Eigen::VectorXd& qp, Eigen::VectorXd& phi) const {
-
-        phi << qp[3] * sin(qp[0]) - qp[9] - r_*cos(alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*sin(alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])),
-        R_*cos(alpha5_) - qp[10] - a56_*sin(alpha5_) - qp[3] * cos(alpha5_)*cos(qp[0]) - r_*cos(alpha13_)*cos(qp[7])*cos(qp[8]) + r_*cos(qp[7])*sin(alpha13_)*sin(qp[8]),
-        a56_*cos(alpha5_) - qp[11] + R_*sin(alpha5_) - qp[3] * sin(alpha5_)*cos(qp[0]) - r_*cos(alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin(alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])),
-        qp[4] * sin(qp[1]) - qp[9] - r_*cos(alpha13_ - (2 * PI) / 3)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])),
-        R_*cos(alpha5_ - (2 * PI) / 3) - qp[10] - a56_*sin(alpha5_ - (2 * PI) / 3) - qp[4] * cos(alpha5_ - (2 * PI) / 3)*cos(qp[1]) - r_*cos(qp[7])*cos(qp[8])*cos(alpha13_ - (2 * PI) / 3) + r_*cos(qp[7])*sin(qp[8])*sin(alpha13_ - (2 * PI) / 3),
-        a56_*cos(alpha5_ - (2 * PI) / 3) - qp[11] + R_*sin(alpha5_ - (2 * PI) / 3) - qp[4] * cos(qp[1])*sin(alpha5_ - (2 * PI) / 3) - r_*cos(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])),
-        qp[5] * sin(qp[2]) - qp[9] - r_*cos((2 * PI) / 3 + alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])),
-        R_*cos((2 * PI) / 3 + alpha5_) - qp[10] - a56_*sin((2 * PI) / 3 + alpha5_) - qp[5] * cos((2 * PI) / 3 + alpha5_)*cos(qp[2]) - r_*cos(qp[7])*cos(qp[8])*cos((2 * PI) / 3 + alpha13_) + r_*cos(qp[7])*sin(qp[8])*sin((2 * PI) / 3 + alpha13_),
-        a56_*cos((2 * PI) / 3 + alpha5_) - qp[11] + R_*sin((2 * PI) / 3 + alpha5_) - qp[5] * cos(qp[2])*sin((2 * PI) / 3 + alpha5_) - r_*cos((2 * PI) / 3 + alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8]));
+        return info;
     }
 
-    void MahiExoII::phi_d_qp_update(const Eigen::VectorXd& qp, Eigen::MatrixXd& phi_d_qp) const {
-
-        phi_d_qp << qp[3] * cos(qp[0]), 0, 0, sin(qp[0]), 0, 0, -r_*cos(alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin(alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[6])*cos(alpha13_)*cos(qp[7])*cos(qp[8]) - r_*cos(qp[6])*cos(qp[7])*sin(alpha13_)*sin(qp[8]), r_*sin(alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*cos(alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), -1, 0, 0,
-        qp[3] * cos(alpha5_)*sin(qp[0]), 0, 0, -cos(alpha5_)*cos(qp[0]), 0, 0, 0, r_*cos(alpha13_)*cos(qp[8])*sin(qp[7]) - r_*sin(alpha13_)*sin(qp[7])*sin(qp[8]), r_*cos(alpha13_)*cos(qp[7])*sin(qp[8]) + r_*cos(qp[7])*cos(qp[8])*sin(alpha13_), 0, -1, 0,
-        qp[3] * sin(alpha5_)*sin(qp[0]), 0, 0, -sin(alpha5_)*cos(qp[0]), 0, 0, r_*cos(alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) + r_*sin(alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[7])*sin(qp[6])*sin(alpha13_)*sin(qp[8]) - r_*cos(alpha13_)*cos(qp[7])*cos(qp[8])*sin(qp[6]), r_*sin(alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*cos(alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), 0, 0, -1,
-        0, qp[4] * cos(qp[1]), 0, 0, sin(qp[1]), 0, -r_*cos(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[6])*cos(qp[7])*cos(qp[8])*cos(alpha13_ - (2 * PI) / 3) - r_*cos(qp[6])*cos(qp[7])*sin(qp[8])*sin(alpha13_ - (2 * PI) / 3), r_*sin(alpha13_ - (2 * PI) / 3)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*cos(alpha13_ - (2 * PI) / 3)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), -1, 0, 0,
-        0, qp[4] * cos(alpha5_ - (2 * PI) / 3)*sin(qp[1]), 0, 0, -cos(alpha5_ - (2 * PI) / 3)*cos(qp[1]), 0, 0, r_*cos(qp[8])*cos(alpha13_ - (2 * PI) / 3)*sin(qp[7]) - r_*sin(qp[7])*sin(qp[8])*sin(alpha13_ - (2 * PI) / 3), r_*cos(qp[7])*cos(qp[8])*sin(alpha13_ - (2 * PI) / 3) + r_*cos(qp[7])*cos(alpha13_ - (2 * PI) / 3)*sin(qp[8]), 0, -1, 0,
-        0, qp[4] * sin(alpha5_ - (2 * PI) / 3)*sin(qp[1]), 0, 0, -cos(qp[1])*sin(alpha5_ - (2 * PI) / 3), 0, r_*cos(alpha13_ - (2 * PI) / 3)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) + r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[7])*sin(qp[6])*sin(qp[8])*sin(alpha13_ - (2 * PI) / 3) - r_*cos(qp[7])*cos(qp[8])*cos(alpha13_ - (2 * PI) / 3)*sin(qp[6]), r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*cos(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), 0, 0, -1,
-        0, 0, qp[5] * cos(qp[2]), 0, 0, sin(qp[2]), -r_*cos((2 * PI) / 3 + alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[6])*cos(qp[7])*cos(qp[8])*cos((2 * PI) / 3 + alpha13_) - r_*cos(qp[6])*cos(qp[7])*sin(qp[8])*sin((2 * PI) / 3 + alpha13_), r_*sin((2 * PI) / 3 + alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*cos((2 * PI) / 3 + alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), -1, 0, 0,
-        0, 0, qp[5] * cos((2 * PI) / 3 + alpha5_)*sin(qp[2]), 0, 0, -cos((2 * PI) / 3 + alpha5_)*cos(qp[2]), 0, r_*cos(qp[8])*cos((2 * PI) / 3 + alpha13_)*sin(qp[7]) - r_*sin(qp[7])*sin(qp[8])*sin((2 * PI) / 3 + alpha13_), r_*cos(qp[7])*cos(qp[8])*sin((2 * PI) / 3 + alpha13_) + r_*cos(qp[7])*cos((2 * PI) / 3 + alpha13_)*sin(qp[8]), 0, -1, 0,
-        0, 0, qp[5] * sin((2 * PI) / 3 + alpha5_)*sin(qp[2]), 0, 0, -cos(qp[2])*sin((2 * PI) / 3 + alpha5_), r_*cos((2 * PI) / 3 + alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) + r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[7])*sin(qp[6])*sin(qp[8])*sin((2 * PI) / 3 + alpha13_) - r_*cos(qp[7])*cos(qp[8])*cos((2 * PI) / 3 + alpha13_)*sin(qp[6]), r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*cos((2 * PI) / 3 + alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), 0, 0, -1;
-    }
-
-    std::vector<uint8> MahiExoII::select_q_invert(std::vector<uint8> select_q) const {
-        std::vector<uint8> indices{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
-        for (int i = 0; i < n_qs; ++i) {
-            indices.erase(indices.begin() + select_q[i]);
+    bool MahiExoII::anatomical_to_robot_positions(const std::vector<double>& anat_pos, std::vector<double>& robot_pos) {
+        if (anat_pos.size() != n_aj) {
+            LOG(Error) << "Anatomical position vector has " << anat_pos.size() << " elements, expected " << n_aj << ".";
+            return false;
         }
-        return indices;
+        RpsKinematics::VectorQs q_ser, q_par;
+        q_ser << anat_pos[2], anat_pos[3], anat_pos[4];
+        if (!inverse_kinematics(q_ser, q_par).converged)
+            return false;
+
+        robot_pos.resize(n_rj);
+        robot_pos[0] = anat_pos[0]; // elbow flexion/extension
+        robot_pos[1] = anat_pos[1]; // forearm pronation/supination
+        robot_pos[2] = q_par[0];    // prismatic link 1
+        robot_pos[3] = q_par[1];    // prismatic link 2
+        robot_pos[4] = q_par[2];    // prismatic link 3
+        return true;
     }
 
     //////////////// MISC USEFUL UTILITY FUNCTIONS ////////////////
@@ -683,8 +681,8 @@ namespace meii {
                 for (std::size_t i = 0; i < 2; i++) {
 
                     // get positions and velocities
-                    double pos_act = meii_joints[i]->get_position();
-                    double vel_act = meii_joints[i]->get_velocity();
+                    double pos_act = m_joint_state.position[i];
+                    double vel_act = m_joint_state.velocity[i];
 
                     double torque = 0;
                     if (i == calibrating_joint) {
@@ -712,7 +710,7 @@ namespace meii {
                             if (!moving) {
                                 daq_encoder_write(i,encoder_offsets[i]);
                                 returning = true;
-                                // update the reference position to be the current one
+                                // update the reference position to be the current one (read the joint, the encoder was just rewritten)
                                 pos_ref = meii_joints[i]->get_position();
                             }
                         }
@@ -744,21 +742,21 @@ namespace meii {
                         torque = clamp(torque, sat_torques[i]);
                     }
                     // print("joint {} - pos: {}, ref: {}, torque: {}", i, pos_act, pos_ref, torque);
-                    meii_joints[i]->set_torque(torque);
+                    set_joint_torque(i, torque);
                 }
 
                 // set rps joint torques
                 for (std::size_t i = 0; i < 3; ++i) {
-					double torque = robot_joint_pd_controllers_[i + 2].calculate(zeros[i+2], meii_joints[i + 2]->get_position(), 0, meii_joints[i + 2]->get_velocity());
+					double torque = robot_joint_pd_controllers_[i + 2].calculate(zeros[i+2], m_joint_state.position[i + 2], 0, m_joint_state.velocity[i + 2]);
                     torque = clamp(torque, sat_torques[i]+2);
-                    meii_joints[i + 2]->set_torque(torque);
+                    set_joint_torque(i + 2, torque);
 				}
             }
             else{
                 for (size_t i = 0; i < 2; i++){
-                    double torque = robot_joint_pd_controllers_[i].calculate(neutral_points[i], meii_joints[i]->get_position(), 0, meii_joints[i]->get_velocity());
+                    double torque = robot_joint_pd_controllers_[i].calculate(neutral_points[i], m_joint_state.position[i], 0, m_joint_state.velocity[i]);
                     torque = clamp(torque, sat_torques[i]);
-                    meii_joints[i]->set_torque(torque);
+                    set_joint_torque(i, torque);
                 }
 
                 std::vector<bool> par_moving = {true, true, true};
@@ -794,7 +792,7 @@ namespace meii {
                         if (std::all_of(par_moving.begin(), par_moving.end(), [](bool v) { return !v; })) {
                             for (size_t j = 0; j < 3; j++){
                                 daq_encoder_write((int32)j+2,encoder_offsets[j+2]);
-                                // update the reference position to be the current one
+                                // update the reference position to be the current one (read the joint, the encoder was just rewritten)
                                 par_pos_ref[j] = meii_joints[j+2]->get_position();
                             }                        
                             par_returning = {true, true, true};
@@ -827,7 +825,7 @@ namespace meii {
                             torque = clamp(torque, sat_torques[dof_num]);
                         }
                     }
-                    meii_joints[dof_num]->set_torque(torque);
+                    set_joint_torque(dof_num, torque);
                 }
             }
             
@@ -1,5 +1,7 @@
 #include <MEII/MahiExoII/MahiExoIIVirtual.hpp>
 #include <MEII/MahiExoII/JointVirtual.hpp>
+#include <MEII/MahiExoII/CosimLink.hpp>
+#include <MEII/MahiExoII/SharedFrameLink.hpp>
 #include <Mahi/Robo/Control/Limiter.hpp>
 #include <Mahi/Com/MelShare.hpp>
 #include <array>
@@ -13,10 +15,40 @@ namespace meii {
     ///////////////////////// STANDARD CLASS FUNCTIONS AND PARAMS /////////////////////////
 
     MahiExoIIVirtual::MahiExoIIVirtual(MeiiConfigurationVirtual configuration) :
-        MahiExoII(),
+        MahiExoII(configuration.m_parameters),
         config_vr(configuration)
     {
 
+        std::array<double, MeiiPlant::n_joints> positions;
+        for (std::size_t i = 0; i < positions.size(); ++i)
+            positions[i] = i < config_vr.m_rest_positions.size() ? config_vr.m_rest_positions[i] : 0.0;
+
+        if (config_vr.m_plant == VirtualPlant::SharedFrame) {
+            m_plant = std::make_shared<SharedFrameLink>(config_vr.m_frame_name, positions);
+        }
+        else if (config_vr.m_plant == VirtualPlant::Headless) {
+            m_plant = std::allocate_shared<MeiiPlant>(Eigen::aligned_allocator<MeiiPlant>(), config_vr.m_plant_parameters, params_, positions);
+        }
+        else if (config_vr.m_plant == VirtualPlant::Cosim) {
+            m_plant = std::make_shared<CosimLink>(config_vr.m_cosim_name, config_vr.m_cosim_period);
+        }
+
+        if (m_plant) {
+            for (int i = 0; i < n_rj; ++i) {
+                auto joint = std::make_shared<JointVirtual>("meii_joint_" + std::to_string(i+1),
+                                                     std::array<double, 2>({ params_.pos_limits_min_[i] , params_.pos_limits_max_[i] }),
+                                                     params_.vel_limits_[i],
+                                                     params_.joint_torque_limits[i],
+                                                     Limiter(params_.motor_cont_limits_[i],
+                                                                params_.motor_peak_limits_[i],
+                                                                params_.motor_i2t_times_[i]),
+                                                     m_plant,
+                                                     i);
+                meii_joints.push_back(joint);
+            }
+            return;
+        }
+
         for (int i = 0; i < n_rj; ++i) {
 
             auto ms_trq = std::make_shared<MelShare>(config_vr.m_torque_ms_names[i]);
@@ -37,5 +69,15 @@ namespace meii {
         }
     }
 
+    bool MahiExoIIVirtual::daq_read_all() {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::DaqRead);
+        return m_plant ? m_plant->update(get_loop_time()) : true;
+    }
+
+    bool MahiExoIIVirtual::daq_write_all() {
+        LoopProfiler::Probe probe(m_profiler, LoopProfiler::DaqWrite);
+        return m_plant ? m_plant->apply() : true;
+    }
+
 
 } // namespace meii
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include <MEII/MahiExoII/MeiiPlant.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include <algorithm>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    // smallest magnitude of det(jac_ik) the wrist can reach, about 2% of its value with the wrist centered [m^3/rad^2].
+    // det(jac_ik) is negative over the working assembly mode
+    static const double jac_ik_det_min = 1e-4;
+    // how far past a link stop [m], or past jac_ik_det_min [m^3/rad^2], a substep of the wrist may end. Sliding along a stop
+    // drifts past it by the curvature of the step, which the next substep takes back
+    static const double wrist_slack = 1e-9;
+
+    MeiiPlant::MeiiPlant(const MeiiPlantParameters& plant_params, const MeiiParameters& params, const std::array<double, n_joints>& positions) :
+        m_plant_params(plant_params),
+        m_pos_min(params.pos_limits_min_),
+        m_pos_max(params.pos_limits_max_),
+        m_substep(1.0 / plant_params.substep_rate_)
+    {
+        reset(positions);
+    }
+
+    bool MeiiPlant::reset(const std::array<double, n_joints>& positions) {
+        for (std::size_t i = 0; i < n_joints; ++i)
+            m_position[i] = std::min(std::max(positions[i], m_pos_min[i]), m_pos_max[i]);
+        m_velocity.fill(0.0);
+        m_torque.fill(0.0);
+        m_pending = 0.0;
+        m_update_time = Time::Zero;
+        m_substeps = 0;
+        m_wrist_holds = 0;
+        m_noise_rng.seed(m_plant_params.seed_);
+        m_noise.reset();
+
+        // the wrist state lives in serial coordinates, so the link lengths are only kept if they assemble
+        bool assembled = true;
+        RpsKinematics::VectorQs q_par(m_position[2], m_position[3], m_position[4]);
+        RpsKinematics::MatrixRho rho;
+        RpsKinematics::MatrixJac jac_fk;
+        m_qp = RpsKinematics::qp_guess();
+        if (!m_rps.forward(q_par, m_q_ser, m_qp, rho, jac_fk).converged || !solve_wrist(m_q_ser, m_qp, q_par, m_jac_ik, 0.0)) {
+            LOG(Error) << "RPS link lengths " << q_par[0] << ", " << q_par[1] << ", " << q_par[2] << " of the simulated plant have no assembly within the stops, starting the wrist at the nominal pose";
+            m_qp = RpsKinematics::qp_guess();
+            for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i)
+                m_q_ser[i] = m_qp[rps_select_ser.q[i]];
+            solve_wrist(m_q_ser, m_qp, q_par, m_jac_ik, 0.0);
+            assembled = false;
+        }
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i)
+            m_position[i + 2] = q_par[i];
+        m_q_ser_dot.setZero();
+
+        measure();
+        return assembled;
+    }
+
+    bool MeiiPlant::update(Time time) {
+        // a new loop clock can start behind the last update, in which case the plant waits for it
+        if (time > m_update_time)
+            step(time - m_update_time);
+        m_update_time = time;
+        measure();
+        return true;
+    }
+
+    void MeiiPlant::step(Time dt) {
+        m_pending += std::min(dt, m_plant_params.max_step_).as_seconds();
+        while (m_pending >= m_substep) {
+            substep();
+            m_pending -= m_substep;
+        }
+    }
+
+    void MeiiPlant::substep() {
+        const double h = m_substep;
+        for (std::size_t i = 0; i < 2; ++i) {
+            // damping is integrated implicitly, so no damping or inertia can make a substep unstable
+            const double inertia = m_plant_params.inertia_[i];
+            double velocity = m_velocity[i] + h * m_torque[i] / inertia;
+            // coulomb friction can stop a joint within a substep, but never reverse it
+            const double friction = h * m_plant_params.friction_[i] / inertia;
+            velocity = velocity > friction ? velocity - friction : velocity < -friction ? velocity + friction : 0.0;
+            m_velocity[i] = velocity / (1.0 + h * m_plant_params.damping_[i] / inertia);
+            m_position[i] += h * m_velocity[i];
+            // hard stops absorb all velocity into them
+            if (m_position[i] < m_pos_min[i]) {
+                m_position[i] = m_pos_min[i];
+                m_velocity[i] = std::max(m_velocity[i], 0.0);
+            }
+            else if (m_position[i] > m_pos_max[i]) {
+                m_position[i] = m_pos_max[i];
+                m_velocity[i] = std::min(m_velocity[i], 0.0);
+            }
+        }
+        substep_wrist();
+        m_substeps++;
+    }
+
+    void MeiiPlant::substep_wrist() {
+        typedef RpsKinematics::VectorQs VectorQs;
+        const double h = m_substep;
+        const RpsKinematics::MatrixJac& jac = m_jac_ik;
+
+        // the links carry the friction, forces and most of the inertia, which act on the serial coordinates through jac_ik
+        VectorQs inertia, damping, force;
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+            inertia[i] = m_plant_params.inertia_[i + 2];
+            damping[i] = m_plant_params.damping_[i + 2];
+            force[i] = m_torque[i + 2];
+        }
+        RpsKinematics::MatrixJac mass = jac.transpose() * inertia.asDiagonal() * jac;
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i)
+            mass(i, i) += m_plant_params.wrist_inertia_[i];
+        const Eigen::LDLT<RpsKinematics::MatrixJac> mass_ldlt(mass);
+        VectorQs velocity = m_q_ser_dot + h * mass_ldlt.solve(jac.transpose() * force);
+
+        // coulomb friction is an impulse on each link, limited to the one that stops the link on its own
+        const VectorQs link_velocity = jac * velocity;
+        VectorQs impulse;
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+            const double stop = inertia[i] * std::abs(link_velocity[i]);
+            const double friction = std::min(h * m_plant_params.friction_[i + 2], stop);
+            impulse[i] = link_velocity[i] > 0.0 ? -friction : link_velocity[i] < 0.0 ? friction : 0.0;
+        }
+        velocity += mass_ldlt.solve(jac.transpose() * impulse);
+
+        // damping is integrated implicitly, as for the other joints
+        const RpsKinematics::MatrixJac damped = mass + h * jac.transpose() * damping.asDiagonal() * jac;
+        velocity = damped.ldlt().solve(mass * velocity);
+
+        // a link at its stop, or the wrist at the edge of its working assembly mode, loses the velocity that would take
+        // it past, like the hard stops of the other joints. What is left slides along the stop, and the step shrinks
+        // until it ends on an assembly
+        auto stop = [&](const VectorQs& normal, double max_rate) {
+            const double rate = normal.dot(velocity);
+            if (rate <= max_rate)
+                return false;
+            const VectorQs response = mass_ldlt.solve(normal);
+            velocity -= response * ((rate - max_rate) / normal.dot(response));
+            return true;
+        };
+        RpsKinematics::VectorQp qp = m_qp;
+        VectorQs q_ser, q_par;
+        RpsKinematics::MatrixJac jac_next;
+        double fraction = 1.0;
+        bool moved = false;
+        for (std::size_t attempt = 0; attempt < 8; ++attempt) {
+            q_ser = m_q_ser + fraction * h * velocity;
+            qp = m_qp;
+            jac_next = m_jac_ik;
+            // a solution far from the last one is another assembly mode, which the mechanism cannot jump to
+            moved = solve_wrist(q_ser, qp, q_par, jac_next, wrist_slack) && (qp - m_qp).cwiseAbs().maxCoeff() <= 0.01;
+            if (moved)
+                break;
+            // the rates that end the step on each stop, which move the wrist back if it already is a little past one
+            const double dt = fraction * h;
+            bool stopped = false;
+            for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+                stopped = stop(-jac.row(i).transpose(), (m_position[i + 2] - m_pos_min[i + 2]) / dt) || stopped;
+                stopped = stop(jac.row(i).transpose(), (m_pos_max[i + 2] - m_position[i + 2]) / dt) || stopped;
+            }
+            if (jac_next.determinant() > -jac_ik_det_min)
+                stopped = stop(wrist_det_gradient(), (-jac_ik_det_min - jac.determinant()) / dt) || stopped;
+            if (!stopped)
+                fraction *= 0.5;
+        }
+
+        if (moved) {
+            m_q_ser = q_ser;
+            m_q_ser_dot = velocity;
+            m_qp = qp;
+            m_jac_ik = jac_next;
+        }
+        else {
+            if (m_wrist_holds == 0)
+                LOG(Warning) << "RPS wrist of the simulated plant has no assembly along its step from " << m_q_ser[0] << ", " << m_q_ser[1] << ", " << m_q_ser[2] << ", holding it still";
+            m_wrist_holds++;
+            m_q_ser_dot.setZero();
+        }
+        const VectorQs link_velocity_out = m_jac_ik * m_q_ser_dot;
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+            m_position[i + 2] = m_qp[rps_select_par.q[i]];
+            m_velocity[i + 2] = link_velocity_out[i];
+        }
+    }
+
+    RpsKinematics::VectorQs MeiiPlant::wrist_det_gradient() const {
+        // by finite differences, as it is only needed while the wrist is near a singularity
+        const double dq = 1e-6;
+        RpsKinematics::VectorQs gradient, q_ser, q_par;
+        RpsKinematics::VectorQp qp;
+        RpsKinematics::MatrixJac jac_ik;
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+            q_ser = m_q_ser;
+            q_ser[i] += dq;
+            qp = m_qp;
+            jac_ik = m_jac_ik;
+            // only jac_ik is needed, so the stops are not checked, and a failed solve leaves no gradient along i
+            solve_wrist(q_ser, qp, q_par, jac_ik, 1.0);
+            gradient[i] = (jac_ik.determinant() - m_jac_ik.determinant()) / dq;
+        }
+        return gradient;
+    }
+
+    bool MeiiPlant::solve_wrist(const RpsKinematics::VectorQs& q_ser, RpsKinematics::VectorQp& qp, RpsKinematics::VectorQs& q_par, RpsKinematics::MatrixJac& jac_ik, double slack) const {
+        RpsKinematics::MatrixRho rho;
+        RpsKinematics::MatrixJac jac_solver;
+        if (!m_rps.inverse(q_ser, q_par, qp, rho, jac_solver, true).converged)
+            return false;
+        // the solver's jac_ik comes from the factorization before its last step, so refactorize at the solution for a
+        // jac_ik that is smooth in q_ser. The link lengths are entries 3 to 5 of the dependent variables
+        m_rps.generate_rho(rps_select_ser, qp, rho);
+        jac_ik = rho.block<3, 3>(3, 0);
+        // the legs cannot fold through the base, which is where the mechanism changes assembly mode
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+            if (q_par[i] < m_pos_min[i + 2] - slack || q_par[i] > m_pos_max[i + 2] + slack)
+                return false;
+            if (qp[i] < RpsKinematics::theta_min_ || qp[i] > PI - RpsKinematics::theta_min_)
+                return false;
+        }
+        // near a singularity of jac_ik the link lengths no longer fix the wrist, and past it the assembly mode changes
+        return jac_ik.determinant() <= -jac_ik_det_min + slack;
+    }
+
+    void MeiiPlant::measure() {
+        for (std::size_t i = 0; i < n_joints; ++i) {
+            // noiseless joints draw nothing, so they cost nothing and leave the other joints' noise unchanged
+            m_measured_position[i] = m_position[i];
+            m_measured_velocity[i] = m_velocity[i];
+            if (m_plant_params.position_noise_[i] > 0.0)
+                m_measured_position[i] += m_plant_params.position_noise_[i] * m_noise(m_noise_rng);
+            if (m_plant_params.velocity_noise_[i] > 0.0)
+                m_measured_velocity[i] += m_plant_params.velocity_noise_[i] * m_noise(m_noise_rng);
+        }
+    }
+
+} // namespace meii
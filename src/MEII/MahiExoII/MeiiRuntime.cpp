@@ -0,0 +1,209 @@
+#include <MEII/MahiExoII/MeiiRuntime.hpp>
+#include <Mahi/Util/Console.hpp>
+#include <Mahi/Util/Timing/Clock.hpp>
+#include <Mahi/Util/Timing/Timer.hpp>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+        /// pins the calling thread to cpu and raises it to real-time priority, returns false if either failed
+        bool make_current_thread_realtime(int cpu) {
+        #if defined(_WIN32)
+            bool pinned = SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+            bool raised = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+            return pinned && raised;
+        #elif defined(__linux__)
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(cpu, &cpus);
+            bool pinned = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+            sched_param param;
+            param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+            bool raised = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+            return pinned && raised;
+        #else
+            return false;
+        #endif
+        }
+    }
+
+    MeiiRuntime::MeiiRuntime(MahiExoII& meii, Time period, std::size_t queue_capacity) :
+        m_meii(meii),
+        m_period(period),
+        m_worker_period(milliseconds(10)),
+        m_frames(queue_capacity),
+        m_messages(queue_capacity),
+        m_keys(64),
+        m_running(false),
+        m_stop_requested(false),
+        m_rt_done(false),
+        m_ticks(0),
+        m_overruns(0),
+        m_max_tick_us(0)
+    {
+        m_meii.get_profiler().set_period(period);
+    }
+
+    MeiiRuntime::~MeiiRuntime() {
+        request_stop();
+        join();
+    }
+
+    bool MeiiRuntime::start() {
+        if (m_running) {
+            LOG(Error) << "MeiiRuntime is already running.";
+            return false;
+        }
+        m_running = true;
+        m_stop_requested = false;
+        m_rt_done = false;
+        m_tick = 0;
+        m_ticks = 0;
+        m_overruns = 0;
+        m_max_tick_us = 0;
+        m_worker_thread = std::thread(&MeiiRuntime::worker_loop, this);
+        m_rt_thread = std::thread(&MeiiRuntime::rt_loop, this);
+        return true;
+    }
+
+    void MeiiRuntime::join() {
+        if (m_rt_thread.joinable())
+            m_rt_thread.join();
+        if (m_worker_thread.joinable())
+            m_worker_thread.join();
+        m_running = false;
+    }
+
+    void MeiiRuntime::run(const std::atomic<bool>& stop_flag) {
+        if (!start())
+            return;
+        while (!stop_flag && !m_rt_done) {
+            sleep(milliseconds(10));
+        }
+        request_stop();
+        join();
+    }
+
+    bool MeiiRuntime::post_message(Severity severity, const char* text) {
+        RuntimeMessage message;
+        message.severity = severity;
+        message.tick = m_tick;
+        std::strncpy(message.text, text, sizeof(message.text) - 1);
+        message.text[sizeof(message.text) - 1] = '\0';
+        return m_messages.push(message);
+    }
+
+    RuntimeStats MeiiRuntime::get_stats() const {
+        RuntimeStats stats;
+        stats.ticks = m_ticks;
+        stats.overruns = m_overruns;
+        stats.max_tick_time = microseconds(m_max_tick_us);
+        stats.telemetry_dropped = m_frames.get_dropped();
+        stats.messages_dropped = m_messages.get_dropped();
+        stats.keys_dropped = m_keys.get_dropped();
+        return stats;
+    }
+
+    void MeiiRuntime::rt_loop() {
+        if (m_rt_cpu >= 0 && !make_current_thread_realtime(m_rt_cpu))
+            post_message(Warning, "Failed to pin the real-time thread or raise its priority, running with default scheduling.");
+
+        MeiiStateFrame frame;
+        if (m_watchdog && !m_meii.daq_watchdog_start()) {
+            post_message(Error, "Failed to start the DAQ watchdog, stopping.");
+            m_stop_requested = true;
+        }
+
+        Clock tick_clock;
+        LoopClock clock(m_period, m_clock_mode);
+        m_meii.set_loop_clock(&clock);
+        Time t = Time::Zero;
+        while (!m_stop_requested) {
+            tick_clock.restart();
+
+            // read -> kinematics -> control -> write, nothing else happens on this thread
+            m_meii.daq_read_all();
+            m_meii.update_kinematics();
+            bool keep_going = !m_control || m_control(m_meii, t);
+            m_meii.daq_write_all();
+            if (m_watchdog && !m_meii.daq_watchdog_kick()) {
+                post_message(Error, "DAQ watchdog expired, stopping.");
+                keep_going = false;
+            }
+
+            // hand the state to the worker, dropping it if the worker has fallen behind
+            m_meii.read_state(frame);
+            m_frames.push(frame);
+
+            int64 tick_us = tick_clock.get_elapsed_time().as_microseconds();
+            if (tick_us > m_period.as_microseconds())
+                m_overruns++;
+            if (tick_us > m_max_tick_us)
+                m_max_tick_us = tick_us;
+            m_ticks++;
+            m_tick++;
+
+            if (!keep_going)
+                break;
+            t = clock.wait();
+        }
+        m_meii.set_loop_clock(nullptr);
+        m_rt_done = true;
+    }
+
+    void MeiiRuntime::worker_loop() {
+        Timer timer(m_worker_period, Timer::Sleep);
+        while (!m_rt_done) {
+            if (m_keyboard) {
+                int key;
+                while ((key = get_key_nb()) != 0)
+                    m_keys.push(key);
+            }
+            drain();
+            timer.wait();
+        }
+        // the real-time thread has exited, so everything it queued is already visible
+        drain();
+    }
+
+    void MeiiRuntime::drain() {
+        MeiiStateFrame frame;
+        while (m_frames.pop(frame)) {
+            if (m_telemetry)
+                m_telemetry(frame);
+        }
+        RuntimeMessage message;
+        while (m_messages.pop(message)) {
+            switch (message.severity) {
+                case Fatal:
+                case Error:
+                    LOG(Error) << "[tick " << message.tick << "] " << message.text;
+                    break;
+                case Warning:
+                    LOG(Warning) << "[tick " << message.tick << "] " << message.text;
+                    break;
+                default:
+                    LOG(Info) << "[tick " << message.tick << "] " << message.text;
+                    break;
+            }
+        }
+    }
+
+} // namespace meii
@@ -0,0 +1,209 @@
+#include <MEII/MahiExoII/MonteCarloSweep.hpp>
+#include <MEII/MahiExoII/MahiExoIIVirtual.hpp>
+#include <MEII/MahiExoII/MeiiConfigurationVirtual.hpp>
+#include <MEII/Utility/LoopClock.hpp>
+#include <MEII/Utility/WorkStealingPool.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include <Mahi/Util/Timing/Clock.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    MonteCarloSweep::MonteCarloSweep(std::size_t sessions, Time period) :
+        m_session_count(sessions),
+        m_period(period),
+        m_rest_positions({-45*DEG2RAD, 0, 0.0952, 0.0952, 0.0952}),
+        m_max_time(seconds(600))
+    { }
+
+    void MonteCarloSweep::draw(std::size_t index, SweepSession& session) const {
+        // seeded by the session rather than drawn in turn, so a session does not depend on which thread ran it
+        std::seed_seq seq{ static_cast<uint32>(m_seed), static_cast<uint32>(m_seed >> 32),
+                           static_cast<uint32>(index), static_cast<uint32>(static_cast<uint64>(index) >> 32) };
+        std::mt19937_64 rng(seq);
+        std::uniform_real_distribution<double> unit(-1.0, 1.0);
+
+        session.index = index;
+        session.plant_parameters = m_plant_parameters;
+        for (std::size_t i = 0; i < SweepVariation::n_joints; ++i) {
+            session.plant_parameters.inertia_[i] *= 1.0 + m_variation.inertia_spread * unit(rng);
+            session.plant_parameters.damping_[i] *= 1.0 + m_variation.damping_spread * unit(rng);
+            session.plant_parameters.friction_[i] *= 1.0 + m_variation.friction_spread * unit(rng);
+            session.plant_parameters.position_noise_[i] = m_variation.position_noise[i];
+            session.plant_parameters.velocity_noise_[i] = m_variation.velocity_noise[i];
+        }
+        session.plant_parameters.seed_ = rng();
+        session.parameters = m_parameters;
+        if (m_variation.vary_parameters)
+            m_variation.vary_parameters(rng, session.parameters);
+    }
+
+    SweepSession MonteCarloSweep::run_session(std::size_t index, const ProtocolFactory& make_protocol) const {
+        SweepSession session;
+        draw(index, session);
+
+        MahiExoIIVirtual meii(MeiiConfigurationVirtual(VirtualPlant::Headless, session.plant_parameters, m_rest_positions, session.parameters));
+        LoopClock clock(m_period, LoopClock::Lockstep);
+        meii.set_loop_clock(&clock);
+        Protocol protocol = make_protocol();
+
+        // torques above their limit are saturated rather than tripping, and counted as saturation
+        const uint32 trip_limits = SafetyMonitor::all_limits() & ~SafetyMonitor::limit_mask(SafetyMonitor::Torque);
+        MahiExoII::JointArray ref, position;
+        std::array<double, SweepSession::n_joints> squared_error;
+        squared_error.fill(0.0);
+
+        session.ran = meii.enable();
+        Time t = Time::Zero;
+        while (session.ran && t < m_max_time) {
+            if (!meii.daq_read_all()) {
+                session.ran = false;
+                break;
+            }
+            meii.update_kinematics();
+            if (!protocol(meii, t, ref))
+                break;
+
+            session.trip = meii.check_limits(trip_limits);
+            session.ticks++;
+            meii.get_anatomical_joint_positions(position);
+            for (std::size_t i = 0; i < SweepSession::n_joints; ++i) {
+                const double error = std::abs(ref[i] - position[i]);
+                squared_error[i] += error * error;
+                session.max_error[i] = std::max(session.max_error[i], error);
+            }
+            const JointState& state = meii.get_joint_state();
+            bool saturated = false;
+            for (std::size_t i = 0; i < JointState::n_joints; ++i) {
+                if (state.torque[i] != state.command_torque[i]) {
+                    session.saturated_ticks[i]++;
+                    saturated = true;
+                }
+            }
+            if (saturated)
+                session.any_saturated_ticks++;
+            if (session.trip != 0)
+                break;
+
+            meii.daq_write_all();
+            t = clock.wait();
+        }
+        meii.disable();
+        meii.set_loop_clock(nullptr);
+        // thousands of sessions would each log their latencies on destruction
+        meii.get_profiler().reset();
+
+        session.time = t;
+        for (std::size_t i = 0; i < SweepSession::n_joints; ++i)
+            session.rms_error[i] = session.ticks > 0 ? std::sqrt(squared_error[i] / session.ticks) : 0.0;
+        return session;
+    }
+
+    bool MonteCarloSweep::run(const ProtocolFactory& make_protocol) {
+        m_sessions.assign(m_session_count, SweepSession());
+        Clock wall_clock;
+        std::size_t threads;
+        {
+            // one task per session, each writing only its own slot, so the sessions need no locking
+            WorkStealingPool pool(m_threads);
+            threads = pool.get_thread_count();
+            for (std::size_t i = 0; i < m_session_count; ++i)
+                pool.submit([this, i, &make_protocol] { m_sessions[i] = run_session(i, make_protocol); });
+            pool.wait();
+        }
+        summarize(wall_clock.get_elapsed_time(), threads);
+        if (m_summary.failed > 0) {
+            LOG(Error) << m_summary.failed << " of " << m_summary.sessions << " Monte-Carlo sessions failed to run.";
+            return false;
+        }
+        return true;
+    }
+
+    void MonteCarloSweep::summarize(Time wall_time, std::size_t threads) {
+        m_summary = SweepSummary();
+        m_summary.sessions = m_sessions.size();
+        m_summary.wall_time = wall_time;
+        m_summary.threads = threads;
+        if (m_sessions.empty())
+            return;
+
+        int64 simulated_us = 0;
+        for (const SweepSession& session : m_sessions) {
+            if (!session.ran)
+                m_summary.failed++;
+            if (session.trip != 0)
+                m_summary.tripped++;
+            for (std::size_t l = 0; l < SafetyMonitor::n_limits; ++l) {
+                if (session.trip & SafetyMonitor::limit_mask(static_cast<SafetyMonitor::Limit>(l)))
+                    m_summary.limit_trips[l]++;
+            }
+            m_summary.ticks += session.ticks;
+            m_summary.saturated_ticks += session.any_saturated_ticks;
+            for (std::size_t i = 0; i < SweepSummary::n_joints; ++i) {
+                m_summary.mean_rms_error[i] += session.rms_error[i] / m_sessions.size();
+                m_summary.max_error[i] = std::max(m_summary.max_error[i], session.max_error[i]);
+            }
+            simulated_us += session.time.as_microseconds();
+        }
+        m_summary.simulated_time = microseconds(simulated_us);
+
+        std::vector<double> rms(m_sessions.size());
+        for (std::size_t i = 0; i < SweepSummary::n_joints; ++i) {
+            for (std::size_t s = 0; s < m_sessions.size(); ++s)
+                rms[s] = m_sessions[s].rms_error[i];
+            std::size_t rank = static_cast<std::size_t>(std::ceil(0.95 * rms.size())) - 1;
+            std::nth_element(rms.begin(), rms.begin() + rank, rms.end());
+            m_summary.p95_rms_error[i] = rms[rank];
+        }
+
+        // the joints track in different units, so sessions are compared by their error relative to the mean
+        double worst = -1.0;
+        for (const SweepSession& session : m_sessions) {
+            double score = 0.0;
+            for (std::size_t i = 0; i < SweepSummary::n_joints; ++i) {
+                if (m_summary.mean_rms_error[i] > 0.0)
+                    score = std::max(score, session.rms_error[i] / m_summary.mean_rms_error[i]);
+            }
+            if (score > worst) {
+                worst = score;
+                m_summary.worst_session = session.index;
+            }
+        }
+    }
+
+    std::string MonteCarloSweep::report() const {
+        const SweepSummary& summary = m_summary;
+        const double wall = std::max(summary.wall_time.as_seconds(), 1e-6);
+        std::ostringstream out;
+        out << summary.sessions << " sessions on " << summary.threads << " threads in " << std::fixed << std::setprecision(2) << summary.wall_time.as_seconds() << " s, "
+            << std::setprecision(1) << summary.sessions / wall << " sessions/s, "
+            << std::setprecision(0) << summary.simulated_time.as_seconds() / wall << "x real time\n";
+        out << std::left << std::setw(7) << "joint" << std::right
+            << std::setw(12) << "mean rms" << std::setw(12) << "p95 rms" << std::setw(12) << "max" << "  [rad] or [m]\n";
+        out << std::setprecision(5);
+        for (std::size_t i = 0; i < SweepSummary::n_joints; ++i) {
+            out << std::left << std::setw(7) << i << std::right
+                << std::setw(12) << summary.mean_rms_error[i]
+                << std::setw(12) << summary.p95_rms_error[i]
+                << std::setw(12) << summary.max_error[i] << "\n";
+        }
+        out << std::setprecision(2);
+        out << "saturated ticks: " << summary.saturated_ticks << " of " << summary.ticks
+            << " (" << 100.0 * summary.saturated_ticks / std::max<uint64>(summary.ticks, 1) << " %)\n";
+        out << "limit trips:     " << summary.tripped << " sessions ("
+            << "position min " << summary.limit_trips[SafetyMonitor::PositionMin]
+            << ", position max " << summary.limit_trips[SafetyMonitor::PositionMax]
+            << ", velocity " << summary.limit_trips[SafetyMonitor::Velocity]
+            << ", I^2t " << summary.limit_trips[SafetyMonitor::I2t] << ")\n";
+        if (summary.failed > 0)
+            out << "failed:          " << summary.failed << " sessions\n";
+        out << "worst session:   " << summary.worst_session;
+        return out.str();
+    }
+
+} // namespace meii
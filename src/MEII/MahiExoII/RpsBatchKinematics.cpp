@@ -0,0 +1,342 @@
+#include <MEII/MahiExoII/RpsBatchKinematics.hpp>
+#include <Mahi/Util/Math/Constants.hpp>
+#include <Mahi/Util/Timing/Clock.hpp>
+#include "RpsGeometry.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+
+        const std::size_t W = RpsBatchKinematics::lanes;
+        const double round_trip_tol = 1e-9; // largest difference between q_ser and the forward kinematics of the inverse solution [rad] or [m]
+
+        // outcome of one lane of a block
+        enum class LaneStatus {
+            Solved,   // the block solved the lane
+            Fallback, // the block could not solve the lane, so it goes to the general solver
+            Failed    // the general solver already ran on the lane and did not converge
+        };
+
+        // samples handed back by one thread
+        struct BlockCounts {
+            std::size_t fallbacks = 0;
+            std::size_t failures = 0;
+        };
+
+        // solves one sample with the general solver, for lanes the batch path could not handle
+        bool solve_scalar(const RpsKinematics& rps, const RpsSelection& in, const RpsSelection& out, const double* q_in, double* q_out) {
+            RpsKinematics::VectorQs qs(q_in[0], q_in[1], q_in[2]);
+            RpsKinematics::VectorQp qp;
+            RpsKinematics::MatrixRho rho;
+            RpsKinematics::MatrixRhoS rho_s;
+            bool converged = rps.solve(in, qs, qp, rho, rho_s).converged;
+            for (std::size_t i = 0; i < 3; ++i) {
+                q_out[i] = converged ? qp[out.q[i]] : std::numeric_limits<double>::quiet_NaN();
+            }
+            return converged;
+        }
+
+        // Forward kinematics on one block of W samples with the general solver, one lane at a time. The reduced
+        // Newton iteration would run on all lanes at once, but from its own seed it ends on a different assembly
+        // mode than the general solver on a small fraction of samples, and MahiExoII runs the general solver online
+        void forward_block(const RpsKinematics& rps, const double (&l)[3][W], double (&q_ser)[3][W], LaneStatus (&status)[W]) {
+            for (std::size_t k = 0; k < W; ++k) {
+                double sample_in[3] = { l[0][k], l[1][k], l[2][k] };
+                double sample_out[3];
+                bool solved = solve_scalar(rps, rps_select_par, rps_select_ser, sample_in, sample_out);
+                for (std::size_t i = 0; i < 3; ++i)
+                    q_ser[i][k] = sample_out[i];
+                status[k] = solved ? LaneStatus::Solved : LaneStatus::Failed;
+            }
+        }
+
+        // reduced forward kinematics on one block of W samples, see RpsKinematics::reduced_newton()
+        void reduced_forward_block(const double (&l)[3][W], double (&q_ser)[3][W], bool (&ok)[W], uint32 max_it, double tol) {
+            const RpsLegGeometry& g = rps_leg_geometry();
+
+            double th[3][W];
+            double px[3][W], py[3][W], pz[3][W];
+            double err[W];
+            // seed as RpsKinematics::theta_guess()
+            for (std::size_t i = 0; i < 3; ++i)
+                for (std::size_t k = 0; k < W; ++k)
+                    th[i][k] = std::acos(std::min(std::max(g.reach / l[i][k], -1.0), 1.0));
+
+            for (uint32 it = 0; ; ++it) {
+                // spherical joint positions and their derivatives w.r.t. the leg angles
+                double dx[3][W], dy[3][W], dz[3][W];
+                for (std::size_t i = 0; i < 3; ++i) {
+                    for (std::size_t k = 0; k < W; ++k) {
+                        double s = std::sin(th[i][k]);
+                        double c = std::cos(th[i][k]);
+                        px[i][k] = l[i][k] * s;
+                        py[i][k] = g.base[i][1] - l[i][k] * g.cos_b[i] * c;
+                        pz[i][k] = g.base[i][2] - l[i][k] * g.sin_b[i] * c;
+                        dx[i][k] = l[i][k] * c;
+                        dy[i][k] = l[i][k] * g.cos_b[i] * s;
+                        dz[i][k] = l[i][k] * g.sin_b[i] * s;
+                    }
+                }
+
+                // distance constraints f and their cyclic jacobian, row j has entries a[j] at column j and b[j] at column j+1
+                double f[3][W], a[3][W], b[3][W];
+                for (std::size_t j = 0; j < 3; ++j) {
+                    std::size_t n = (j + 1) % 3;
+                    for (std::size_t k = 0; k < W; ++k) {
+                        double ex = px[j][k] - px[n][k];
+                        double ey = py[j][k] - py[n][k];
+                        double ez = pz[j][k] - pz[n][k];
+                        f[j][k] = ex * ex + ey * ey + ez * ez - g.side_sq;
+                        a[j][k] = 2 * (ex * dx[j][k] + ey * dy[j][k] + ez * dz[j][k]);
+                        b[j][k] = -2 * (ex * dx[n][k] + ey * dy[n][k] + ez * dz[n][k]);
+                    }
+                }
+
+                double worst = 0;
+                for (std::size_t k = 0; k < W; ++k) {
+                    err[k] = std::sqrt(f[0][k] * f[0][k] + f[1][k] * f[1][k] + f[2][k] * f[2][k]);
+                    worst = std::max(worst, err[k] == err[k] ? err[k] : std::numeric_limits<double>::infinity());
+                }
+                if (worst <= tol || it == max_it)
+                    break;
+
+                // Newton step, solving the cyclic 3x3 system by Cramer's rule
+                for (std::size_t k = 0; k < W; ++k) {
+                    double inv_det = 1.0 / (a[0][k] * a[1][k] * a[2][k] + b[0][k] * b[1][k] * b[2][k]);
+                    double d0 = (a[1][k] * a[2][k] * f[0][k] - a[2][k] * b[0][k] * f[1][k] + b[0][k] * b[1][k] * f[2][k]) * inv_det;
+                    double d1 = (a[0][k] * a[2][k] * f[1][k] - a[0][k] * b[1][k] * f[2][k] + b[1][k] * b[2][k] * f[0][k]) * inv_det;
+                    double d2 = (a[0][k] * a[1][k] * f[2][k] + b[0][k] * b[2][k] * f[1][k] - a[1][k] * b[2][k] * f[0][k]) * inv_det;
+                    // stay clear of the folded back solutions, see RpsKinematics::reduced_newton()
+                    th[0][k] = std::min(std::max(th[0][k] - d0, RpsKinematics::theta_min_), PI - RpsKinematics::theta_min_);
+                    th[1][k] = std::min(std::max(th[1][k] - d1, RpsKinematics::theta_min_), PI - RpsKinematics::theta_min_);
+                    th[2][k] = std::min(std::max(th[2][k] - d2, RpsKinematics::theta_min_), PI - RpsKinematics::theta_min_);
+                }
+            }
+
+            // recover the platform pose from the spherical joints, see RpsKinematics::reduced_newton()
+            const double scale = 2 / (3 * RpsKinematics::r_);
+            for (std::size_t k = 0; k < W; ++k) {
+                double cx = (px[0][k] + px[1][k] + px[2][k]) / 3;
+                double cy = (py[0][k] + py[1][k] + py[2][k]) / 3;
+                double cz = (pz[0][k] + pz[1][k] + pz[2][k]) / 3;
+                double xx = 0, xy = 0, xz = 0, yx = 0, yy = 0, yz = 0;
+                for (std::size_t i = 0; i < 3; ++i) {
+                    xx += (px[i][k] - cx) * g.cos_g[i];
+                    xy += (py[i][k] - cy) * g.cos_g[i];
+                    xz += (pz[i][k] - cz) * g.cos_g[i];
+                    yx += (px[i][k] - cx) * g.sin_g[i];
+                    yy += (py[i][k] - cy) * g.sin_g[i];
+                    yz += (pz[i][k] - cz) * g.sin_g[i];
+                }
+                xx *= scale; xy *= scale; xz *= scale;
+                yx *= scale; yy *= scale; yz *= scale;
+                double zx = xy * yz - xz * yy;
+                double zy = xz * yx - xx * yz;
+                double zz = xx * yy - xy * yx;
+                q_ser[0][k] = std::atan2(-zz, zx);
+                q_ser[1][k] = std::atan2(zy, std::sqrt(xy * xy + yy * yy));
+                q_ser[2][k] = cx;
+                ok[k] = err[k] <= tol;
+            }
+        }
+
+        // Constants of the closed form inverse kinematics. With c8 = cos(q8) and s8 = sin(q8), leg i's
+        // spherical joint must lie in the plane of the leg: m_i * (q10, q11) + n_i(q6, q7) * (c8, s8) = a56_,
+        // where m_i = (-sin_b[i], cos_b[i]). w is orthogonal to both columns of m, so w * n * (c8, s8) = a56_ * sum(w)
+        // fixes q8, and the pseudo-inverse of m gives (q10, q11).
+        struct InverseConstants {
+            InverseConstants() {
+                const RpsLegGeometry& g = rps_leg_geometry();
+                Eigen::Matrix<double, 3, 2> m;
+                for (std::size_t i = 0; i < 3; ++i) {
+                    m(i, 0) = -g.sin_b[i];
+                    m(i, 1) = g.cos_b[i];
+                }
+                Eigen::Vector3d w_vec = m.col(0).cross(m.col(1));
+                Eigen::Matrix<double, 2, 3> pinv = (m.transpose() * m).inverse() * m.transpose();
+                for (std::size_t i = 0; i < 3; ++i) {
+                    w[i] = w_vec[i];
+                    m_pinv[0][i] = pinv(0, i);
+                    m_pinv[1][i] = pinv(1, i);
+                }
+                w_sum = w_vec.sum();
+            }
+            double w[3];
+            double w_sum;
+            double m_pinv[2][3];
+        };
+
+        // closed form inverse kinematics on one block of W samples. Lanes whose link lengths do not lead the reduced
+        // forward kinematics back to q fall back on the general solver
+        void inverse_block(const double (&q)[3][W], double (&l)[3][W], LaneStatus (&status)[W], uint32 max_it, double tol) {
+            static const InverseConstants ic;
+            const RpsLegGeometry& g = rps_leg_geometry();
+            const double r = RpsKinematics::r_;
+            const double a56 = RpsKinematics::a56_;
+
+            bool ok[W];
+            for (std::size_t k = 0; k < W; ++k) {
+                double s6 = std::sin(q[0][k]), c6 = std::cos(q[0][k]);
+                double s7 = std::sin(q[1][k]), c7 = std::cos(q[1][k]);
+
+                // coefficients of (c8, s8) in each leg plane constraint
+                double nc[3], ns[3];
+                for (std::size_t i = 0; i < 3; ++i) {
+                    nc[i] = r * (-g.sin_b[i] * g.cos_g[i] * c7 + g.cos_b[i] * (g.cos_g[i] * s6 * s7 + g.sin_g[i] * c6));
+                    ns[i] = r * (g.sin_b[i] * g.sin_g[i] * c7 + g.cos_b[i] * (g.cos_g[i] * c6 - g.sin_g[i] * s6 * s7));
+                }
+
+                // alpha * c8 + beta * s8 = gamma, take the root closest to q8 = 0
+                double alpha = ic.w[0] * nc[0] + ic.w[1] * nc[1] + ic.w[2] * nc[2];
+                double beta = ic.w[0] * ns[0] + ic.w[1] * ns[1] + ic.w[2] * ns[2];
+                double rho = std::sqrt(alpha * alpha + beta * beta);
+                double ratio = a56 * ic.w_sum / rho;
+                ok[k] = std::abs(ratio) <= 1;
+                double phi = std::atan2(beta, alpha);
+                double half = std::acos(std::min(1.0, std::max(-1.0, ratio)));
+                double q8_a = std::remainder(phi + half, 2 * PI);
+                double q8_b = std::remainder(phi - half, 2 * PI);
+                double q8 = std::abs(q8_a) < std::abs(q8_b) ? q8_a : q8_b;
+                double s8 = std::sin(q8), c8 = std::cos(q8);
+
+                // platform translation
+                double rhs[3];
+                for (std::size_t i = 0; i < 3; ++i) {
+                    rhs[i] = a56 - nc[i] * c8 - ns[i] * s8;
+                }
+                double q10 = ic.m_pinv[0][0] * rhs[0] + ic.m_pinv[0][1] * rhs[1] + ic.m_pinv[0][2] * rhs[2];
+                double q11 = ic.m_pinv[1][0] * rhs[0] + ic.m_pinv[1][1] * rhs[1] + ic.m_pinv[1][2] * rhs[2];
+
+                // platform axes, see phi_update()
+                double xx = s6 * s8 - c6 * c8 * s7, xy = c7 * c8, xz = c6 * s8 + c8 * s6 * s7;
+                double yx = c8 * s6 + c6 * s7 * s8, yy = -c7 * s8, yz = c6 * c8 - s6 * s7 * s8;
+
+                // each link length is the distance from its revolute joint to its spherical joint
+                for (std::size_t i = 0; i < 3; ++i) {
+                    double dx = q[2][k] + r * (g.cos_g[i] * xx + g.sin_g[i] * yx);
+                    double dy = q10 + r * (g.cos_g[i] * xy + g.sin_g[i] * yy) - g.base[i][1];
+                    double dz = q11 + r * (g.cos_g[i] * xz + g.sin_g[i] * yz) - g.base[i][2];
+                    l[i][k] = std::sqrt(dx * dx + dy * dy + dz * dz);
+                }
+            }
+
+            // the root closest to q8 = 0 is not always the assembly mode the forward kinematics finds, so
+            // check every lane by a round trip rather than trusting the closed form
+            double q_check[3][W];
+            bool ok_check[W];
+            reduced_forward_block(l, q_check, ok_check, max_it, tol);
+            for (std::size_t k = 0; k < W; ++k) {
+                double error = 0;
+                for (std::size_t i = 0; i < 3; ++i)
+                    error = std::max(error, std::abs(q_check[i][k] - q[i][k]));
+                status[k] = ok[k] && ok_check[k] && error <= round_trip_tol ? LaneStatus::Solved : LaneStatus::Fallback;
+            }
+        }
+
+        // runs block on samples [begin, end), padding the last block with copies of the last sample
+        template <typename Block>
+        BlockCounts run_range(Block block, const RpsSelection& in, const RpsSelection& out, std::size_t begin, std::size_t end, const double* const q_in[3], double* const q_out[3], unsigned char* converged) {
+            BlockCounts counts;
+            RpsKinematics rps;
+            double x[3][W], y[3][W];
+            LaneStatus status[W];
+            for (std::size_t start = begin; start < end; start += W) {
+                std::size_t count = std::min(W, end - start);
+                for (std::size_t i = 0; i < 3; ++i) {
+                    for (std::size_t k = 0; k < W; ++k) {
+                        x[i][k] = q_in[i][start + std::min(k, count - 1)];
+                    }
+                }
+                block(rps, x, y, status);
+                for (std::size_t k = 0; k < count; ++k) {
+                    bool solved = status[k] == LaneStatus::Solved;
+                    if (status[k] == LaneStatus::Failed) {
+                        counts.failures++;
+                    }
+                    else if (status[k] == LaneStatus::Fallback) {
+                        double sample_in[3] = { x[0][k], x[1][k], x[2][k] };
+                        double sample_out[3];
+                        counts.fallbacks++;
+                        solved = solve_scalar(rps, in, out, sample_in, sample_out);
+                        if (!solved)
+                            counts.failures++;
+                        for (std::size_t i = 0; i < 3; ++i)
+                            y[i][k] = sample_out[i];
+                    }
+                    for (std::size_t i = 0; i < 3; ++i)
+                        q_out[i][start + k] = y[i][k];
+                    if (converged)
+                        converged[start + k] = solved ? 1 : 0;
+                }
+            }
+            return counts;
+        }
+
+        // splits [0, n) into lane aligned ranges, one per thread
+        template <typename Block>
+        RpsBatchResult run(Block block, const RpsSelection& in, const RpsSelection& out, std::size_t n_threads, std::size_t n, const double* const q_in[3], double* const q_out[3], unsigned char* converged) {
+            RpsBatchResult result;
+            result.samples = n;
+            Clock clock;
+
+            std::size_t n_blocks = (n + W - 1) / W;
+            n_threads = std::max<std::size_t>(1, std::min(n_threads, n_blocks));
+            std::size_t blocks_per_thread = (n_blocks + n_threads - 1) / std::max<std::size_t>(1, n_threads);
+            std::vector<BlockCounts> counts(n_threads);
+            std::vector<std::thread> threads;
+            for (std::size_t t = 0; t < n_threads; ++t) {
+                std::size_t begin = std::min(n, t * blocks_per_thread * W);
+                std::size_t end = std::min(n, (t + 1) * blocks_per_thread * W);
+                if (t + 1 == n_threads) {
+                    // the calling thread takes the last range
+                    counts[t] = run_range(block, in, out, begin, end, q_in, q_out, converged);
+                }
+                else {
+                    threads.emplace_back([&, t, begin, end]() {
+                        counts[t] = run_range(block, in, out, begin, end, q_in, q_out, converged);
+                    });
+                }
+            }
+            for (auto& thread : threads)
+                thread.join();
+
+            for (const auto& c : counts) {
+                result.fallbacks += c.fallbacks;
+                result.failures += c.failures;
+            }
+            result.seconds = clock.get_elapsed_time().as_seconds();
+            return result;
+        }
+
+    } // namespace
+
+    RpsBatchKinematics::RpsBatchKinematics(std::size_t n_threads, uint32 max_it, double tol) :
+        m_n_threads(n_threads > 0 ? n_threads : std::max(1u, std::thread::hardware_concurrency())),
+        m_max_it(max_it),
+        m_tol(tol)
+    { }
+
+    RpsBatchResult RpsBatchKinematics::forward(std::size_t n, const double* const q_par[3], double* const q_ser[3], unsigned char* converged) const {
+        auto block = [](const RpsKinematics& rps, const double (&x)[3][W], double (&y)[3][W], LaneStatus (&status)[W]) {
+            forward_block(rps, x, y, status);
+        };
+        return run(block, rps_select_par, rps_select_ser, m_n_threads, n, q_par, q_ser, converged);
+    }
+
+    RpsBatchResult RpsBatchKinematics::inverse(std::size_t n, const double* const q_ser[3], double* const q_par[3], unsigned char* converged) const {
+        uint32 max_it = m_max_it;
+        double tol = m_tol;
+        auto block = [max_it, tol](const RpsKinematics&, const double (&x)[3][W], double (&y)[3][W], LaneStatus (&status)[W]) {
+            inverse_block(x, y, status, max_it, tol);
+        };
+        return run(block, rps_select_ser, rps_select_par, m_n_threads, n, q_ser, q_par, converged);
+    }
+
+} // namespace meii
@@ -0,0 +1,39 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+#pragma once
+
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+
+namespace meii {
+
+    /// Constant geometry of the three RPS legs, which differ only by a rotation of 2pi/3 about the x axis.
+    /// Leg i's revolute joint sits at base[i] and the leg moves in the plane spanned by the x axis and
+    /// (0, -cos_b[i], -sin_b[i]). Its spherical joint sits at r_*(cos_g[i], sin_g[i], 0) in the platform frame.
+    struct RpsLegGeometry {
+        RpsLegGeometry();
+        std::array<Eigen::Vector3d, 3> base; // revolute joint location of each leg on the forearm
+        std::array<double, 3> cos_b, sin_b;  // orientation of the plane each leg moves in
+        std::array<double, 3> cos_g, sin_g;  // angle of each spherical joint on the platform
+        double side_sq;                      // squared distance between any two spherical joints
+        double reach;                        // l*cos(theta) of every leg when the link lengths are equal
+    };
+
+    /// returns the leg geometry shared by the RPS solvers
+    const RpsLegGeometry& rps_leg_geometry();
+
+} // namespace meii
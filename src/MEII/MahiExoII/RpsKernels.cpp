@@ -0,0 +1,202 @@
+// This file is generated by scripts/generate_rps_kernels.py. Do not edit it by hand.
+
+#include "RpsKernels.hpp"
+#include <cmath>
+
+namespace meii {
+
+    void rps_phi_kernel(const double* qp, double* phi) {
+        double s0, c0; rps_sincos(qp[0], s0, c0);
+        double s1, c1; rps_sincos(qp[1], s1, c1);
+        double s2, c2; rps_sincos(qp[2], s2, c2);
+        double s6, c6; rps_sincos(qp[6], s6, c6);
+        double s7, c7; rps_sincos(qp[7], s7, c7);
+        double s8, c8; rps_sincos(qp[8], s8, c8);
+        const double x0 = 0.0046089477815699645*c8;
+        const double x1 = 0.05268051420404056*s8;
+        const double x2 = c6*s7;
+        const double x3 = c0*qp[3];
+        const double x4 = c7*c8;
+        const double x5 = s6*s7;
+        const double x6 = 0.04792713747591107*c8;
+        const double x7 = 0.02234879123846475*s8;
+        const double x8 = 0.02234879123846475*c8;
+        const double x9 = 0.04792713747591107*s8;
+        const double x10 = c7*s8;
+        const double x11 = -qp[11];
+        const double x12 = 0.04331818969434111*c8;
+        const double x13 = 0.030331722965575784*c8;
+        const double x14 = 0.04331818969434111*s8;
+        const double x15 = c2*qp[5];
+        phi[0] = 0.05268051420404056*c6*c8*s7 + qp[3]*s0 - qp[9] - s6*x0 - s6*x1 - 0.0046089477815699645*s8*x2;
+        phi[1] = 0.0046089477815699645*c7*s8 - qp[10] - 0.9955366242582216*x3 - 0.05268051420404056*x4 + 0.10406538063301853;
+        phi[2] = -c6*x0 - c6*x1 - 0.05268051420404056*c8*x5 - qp[11] + 0.0046089477815699645*s6*s7*s8 - 0.09437600203730027*x3 + 0.009480188216748313;
+        phi[3] = qp[4]*s1 - qp[9] + s6*x6 + s6*x7 - x2*x8 + x2*x9;
+        phi[4] = 0.4160362968571967*c1*qp[4] + 0.02234879123846475*c7*c8 - qp[10] - 0.04792713747591107*x10 - 0.04382260648814731;
+        phi[5] = 0.9093480080240736*c1*qp[4] + c6*x6 + c6*x7 + x11 + x5*x8 - x5*x9 - 0.09486335739106533;
+        phi[6] = qp[5]*s2 - qp[9] + 0.030331722965575784*s6*s8 - s6*x12 - x13*x2 - x14*x2;
+        phi[7] = -qp[10] + 0.04331818969434111*x10 + 0.5795003274010248*x15 + 0.030331722965575784*x4 - 0.06024277414487119;
+        phi[8] = 0.030331722965575784*c6*s8 - c6*x12 + x11 + x13*x5 + x14*x5 - 0.8149720059867732*x15 + 0.085383169174317;
+    }
+
+    void rps_phi_d_qp_kernel(const double* qp, double* phi_d_qp) {
+        double s0, c0; rps_sincos(qp[0], s0, c0);
+        double s1, c1; rps_sincos(qp[1], s1, c1);
+        double s2, c2; rps_sincos(qp[2], s2, c2);
+        double s6, c6; rps_sincos(qp[6], s6, c6);
+        double s7, c7; rps_sincos(qp[7], s7, c7);
+        double s8, c8; rps_sincos(qp[8], s8, c8);
+        const double x0 = qp[3]*s0;
+        const double x1 = qp[4]*s1;
+        const double x2 = qp[5]*s2;
+        const double x3 = 0.0046089477815699645*c8;
+        const double x4 = c6*x3;
+        const double x5 = 0.05268051420404056*s8;
+        const double x6 = c6*x5;
+        const double x7 = c8*s7;
+        const double x8 = 0.05268051420404056*x7;
+        const double x9 = s6*x3;
+        const double x10 = s6*x5;
+        const double x11 = s7*s8;
+        const double x12 = 0.0046089477815699645*x11;
+        const double x13 = 0.04792713747591107*c8;
+        const double x14 = c6*x13;
+        const double x15 = 0.02234879123846475*s8;
+        const double x16 = c6*x15;
+        const double x17 = 0.02234879123846475*x7;
+        const double x18 = 0.04792713747591107*x11;
+        const double x19 = s6*x13;
+        const double x20 = s6*x15;
+        const double x21 = 0.04331818969434111*c8;
+        const double x22 = c6*x21;
+        const double x23 = 0.030331722965575784*s8;
+        const double x24 = c6*x23;
+        const double x25 = 0.030331722965575784*x7;
+        const double x26 = 0.04331818969434111*x11;
+        const double x27 = s6*x21;
+        const double x28 = s6*x23;
+        const double x29 = 0.05268051420404056*c8;
+        const double x30 = c6*x29;
+        const double x31 = 0.0046089477815699645*c6*s8;
+        const double x32 = s6*x29;
+        const double x33 = 0.02234879123846475*c8;
+        const double x34 = s6*x33;
+        const double x35 = 0.04792713747591107*s8;
+        const double x36 = s6*x35;
+        const double x37 = 0.030331722965575784*c8;
+        const double x38 = c6*x37;
+        const double x39 = 0.04331818969434111*s8;
+        const double x40 = c6*x39;
+        const double x41 = s6*x37;
+        const double x42 = s6*x39;
+        phi_d_qp[0] = c0*qp[3];
+        phi_d_qp[1] = 0.9955366242582216*x0;
+        phi_d_qp[2] = 0.09437600203730027*x0;
+        phi_d_qp[3] = 0;
+        phi_d_qp[4] = 0;
+        phi_d_qp[5] = 0;
+        phi_d_qp[6] = 0;
+        phi_d_qp[7] = 0;
+        phi_d_qp[8] = 0;
+        phi_d_qp[9] = 0;
+        phi_d_qp[10] = 0;
+        phi_d_qp[11] = 0;
+        phi_d_qp[12] = c1*qp[4];
+        phi_d_qp[13] = -0.4160362968571967*x1;
+        phi_d_qp[14] = -0.9093480080240736*x1;
+        phi_d_qp[15] = 0;
+        phi_d_qp[16] = 0;
+        phi_d_qp[17] = 0;
+        phi_d_qp[18] = 0;
+        phi_d_qp[19] = 0;
+        phi_d_qp[20] = 0;
+        phi_d_qp[21] = 0;
+        phi_d_qp[22] = 0;
+        phi_d_qp[23] = 0;
+        phi_d_qp[24] = c2*qp[5];
+        phi_d_qp[25] = -0.5795003274010248*x2;
+        phi_d_qp[26] = 0.8149720059867732*x2;
+        phi_d_qp[27] = s0;
+        phi_d_qp[28] = -0.9955366242582216*c0;
+        phi_d_qp[29] = -0.09437600203730027*c0;
+        phi_d_qp[30] = 0;
+        phi_d_qp[31] = 0;
+        phi_d_qp[32] = 0;
+        phi_d_qp[33] = 0;
+        phi_d_qp[34] = 0;
+        phi_d_qp[35] = 0;
+        phi_d_qp[36] = 0;
+        phi_d_qp[37] = 0;
+        phi_d_qp[38] = 0;
+        phi_d_qp[39] = s1;
+        phi_d_qp[40] = 0.4160362968571967*c1;
+        phi_d_qp[41] = 0.9093480080240736*c1;
+        phi_d_qp[42] = 0;
+        phi_d_qp[43] = 0;
+        phi_d_qp[44] = 0;
+        phi_d_qp[45] = 0;
+        phi_d_qp[46] = 0;
+        phi_d_qp[47] = 0;
+        phi_d_qp[48] = 0;
+        phi_d_qp[49] = 0;
+        phi_d_qp[50] = 0;
+        phi_d_qp[51] = s2;
+        phi_d_qp[52] = 0.5795003274010248*c2;
+        phi_d_qp[53] = -0.8149720059867732*c2;
+        phi_d_qp[54] = 0.0046089477815699645*s6*s7*s8 - s6*x8 - x4 - x6;
+        phi_d_qp[55] = 0;
+        phi_d_qp[56] = c6*x12 - c6*x8 + x10 + x9;
+        phi_d_qp[57] = s6*x17 - s6*x18 + x14 + x16;
+        phi_d_qp[58] = 0;
+        phi_d_qp[59] = 0.02234879123846475*c6*c8*s7 - c6*x18 - x19 - x20;
+        phi_d_qp[60] = s6*x25 + s6*x26 - x22 + x24;
+        phi_d_qp[61] = 0;
+        phi_d_qp[62] = c6*x25 + c6*x26 + x27 - x28;
+        phi_d_qp[63] = c7*x30 - c7*x31;
+        phi_d_qp[64] = -x12 + x8;
+        phi_d_qp[65] = 0.0046089477815699645*c7*s6*s8 - c7*x32;
+        phi_d_qp[66] = 0.04792713747591107*c6*c7*s8 - c6*c7*x33;
+        phi_d_qp[67] = 0.04792713747591107*s7*s8 - x17;
+        phi_d_qp[68] = c7*x34 - c7*x36;
+        phi_d_qp[69] = -c7*x38 - c7*x40;
+        phi_d_qp[70] = -x25 - x26;
+        phi_d_qp[71] = c7*x41 + c7*x42;
+        phi_d_qp[72] = 0.0046089477815699645*s6*s8 - s7*x4 - s7*x6 - x32;
+        phi_d_qp[73] = c7*x3 + c7*x5;
+        phi_d_qp[74] = s7*x10 + s7*x9 - x30 + x31;
+        phi_d_qp[75] = s7*x14 + s7*x16 + x34 - x36;
+        phi_d_qp[76] = -c7*x13 - c7*x15;
+        phi_d_qp[77] = 0.02234879123846475*c6*c8 - c6*x35 - s7*x19 - s7*x20;
+        phi_d_qp[78] = -s7*x22 + s7*x24 + x41 + x42;
+        phi_d_qp[79] = c7*x21 - c7*x23;
+        phi_d_qp[80] = s7*x27 - s7*x28 + x38 + x40;
+        phi_d_qp[81] = -1;
+        phi_d_qp[82] = 0;
+        phi_d_qp[83] = 0;
+        phi_d_qp[84] = -1;
+        phi_d_qp[85] = 0;
+        phi_d_qp[86] = 0;
+        phi_d_qp[87] = -1;
+        phi_d_qp[88] = 0;
+        phi_d_qp[89] = 0;
+        phi_d_qp[90] = 0;
+        phi_d_qp[91] = -1;
+        phi_d_qp[92] = 0;
+        phi_d_qp[93] = 0;
+        phi_d_qp[94] = -1;
+        phi_d_qp[95] = 0;
+        phi_d_qp[96] = 0;
+        phi_d_qp[97] = -1;
+        phi_d_qp[98] = 0;
+        phi_d_qp[99] = 0;
+        phi_d_qp[100] = 0;
+        phi_d_qp[101] = -1;
+        phi_d_qp[102] = 0;
+        phi_d_qp[103] = 0;
+        phi_d_qp[104] = -1;
+        phi_d_qp[105] = 0;
+        phi_d_qp[106] = 0;
+        phi_d_qp[107] = -1;
+    }
+
+} // namespace meii
@@ -0,0 +1,45 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+#pragma once
+
+#include <cmath>
+
+namespace meii {
+
+    // Kernels generated by scripts/generate_rps_kernels.py, used by RpsKinematics. RpsKernels.cpp
+    // is generated, so change the constraints in the script and re-run it rather than editing
+    // the file. The hand written RpsKinematics::phi_update_reference() and
+    // phi_d_qp_update_reference() are only the test oracle that ex_rps_kernels_check compares
+    // the kernels against.
+
+    /// computes sin(x) and cos(x) together where the platform provides it
+    inline void rps_sincos(double x, double& s, double& c) {
+#if defined(__GLIBC__)
+        ::sincos(x, &s, &c);
+#else
+        s = std::sin(x);
+        c = std::cos(x);
+#endif
+    }
+
+    /// generated kernel for the 9 RPS constraints phi at qp (12 values)
+    void rps_phi_kernel(const double* qp, double* phi);
+    /// generated kernel for the 9x12 derivative of phi w.r.t. qp, written column-major
+    void rps_phi_d_qp_kernel(const double* qp, double* phi_d_qp);
+
+} // namespace meii
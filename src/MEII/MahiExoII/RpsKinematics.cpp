@@ -0,0 +1,564 @@
+#include <MEII/MahiExoII/RpsKinematics.hpp>
+#include <MEII/MahiExoII/RpsLookupTable.hpp>
+#include "RpsGeometry.hpp"
+#include "RpsKernels.hpp"
+#include <Mahi/Util/Math/Constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    // geometric parameters
+    const double RpsKinematics::R_ = 0.1044956;
+    const double RpsKinematics::r_ = 0.05288174521;
+    const double RpsKinematics::a56_ = 0.0268986 - 0.0272820;
+    const double RpsKinematics::alpha5_ = 0.094516665054824;
+    const double RpsKinematics::alpha13_ = 5 * DEG2RAD;
+    const double RpsKinematics::theta_min_ = 1 * DEG2RAD;
+
+    RpsLegGeometry::RpsLegGeometry() {
+        const double beta[3] = { 0, -2 * PI / 3, 2 * PI / 3 };
+        for (std::size_t i = 0; i < 3; ++i) {
+            cos_b[i] = cos(RpsKinematics::alpha5_ + beta[i]);
+            sin_b[i] = sin(RpsKinematics::alpha5_ + beta[i]);
+            cos_g[i] = cos(RpsKinematics::alpha13_ + beta[i]);
+            sin_g[i] = sin(RpsKinematics::alpha13_ + beta[i]);
+            base[i] = Eigen::Vector3d(0,
+                                      RpsKinematics::R_ * cos_b[i] - RpsKinematics::a56_ * sin_b[i],
+                                      RpsKinematics::a56_ * cos_b[i] + RpsKinematics::R_ * sin_b[i]);
+        }
+        side_sq = 3 * RpsKinematics::r_ * RpsKinematics::r_;
+        reach = RpsKinematics::R_ - sqrt(RpsKinematics::r_ * RpsKinematics::r_ - RpsKinematics::a56_ * RpsKinematics::a56_);
+    }
+
+    namespace {
+        const RpsLegGeometry s_legs;
+    }
+
+    const RpsLegGeometry& rps_leg_geometry() {
+        return s_legs;
+    }
+
+    ///////////////////////// SOLVER DIAGNOSTICS /////////////////////////
+
+    void RpsSolverStats::record(const RpsSolveInfo& info) {
+        iteration_histogram[std::min<std::size_t>(info.iterations, n_bins - 1)]++;
+        solves++;
+        if (info.warm_started) warm_starts++;
+        if (info.cold_restart) cold_restarts++;
+        if (!info.converged) failures++;
+        if (info.table_lookup) table_lookups++;
+        last = info;
+    }
+
+    void RpsSolverStats::reset() {
+        iteration_histogram.fill(0);
+        solves = 0;
+        warm_starts = 0;
+        cold_restarts = 0;
+        failures = 0;
+        table_lookups = 0;
+        last = RpsSolveInfo();
+    }
+
+    double RpsSolverStats::mean_iterations() const {
+        if (solves == 0) return 0;
+        uint64 total = 0;
+        for (std::size_t i = 0; i < n_bins; ++i) {
+            total += i * iteration_histogram[i];
+        }
+        return (double)total / solves;
+    }
+
+    ///////////////////////// KINEMATICS ENGINE /////////////////////////
+
+    RpsKinematics::RpsKinematics(uint32 max_it, double tol) :
+        m_max_it(max_it),
+        m_tol(tol),
+        m_fk_method(RpsFkMethod::General)
+    { }
+
+    const RpsKinematics::VectorQp& RpsKinematics::qp_guess() {
+        static const VectorQp guess = (VectorQp() << PI / 4, PI / 4, PI / 4, 0.1305, 0.1305, 0.1305, 0, 0, 0, 0.0923, 0, 0).finished();
+        return guess;
+    }
+
+    void RpsKinematics::theta_guess(const VectorQs& q_par, VectorQs& theta) {
+        // with equal link lengths the platform is centered and l*cos(theta) = reach for every leg
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            theta[i] = acos(std::min(std::max(s_legs.reach / q_par[i], -1.0), 1.0));
+        }
+    }
+
+    RpsSolveInfo RpsKinematics::forward(const VectorQs& q_par_in, VectorQs& q_ser_out, VectorQp& qp_out, MatrixRho& rho_fk, MatrixJac& jac_fk, bool warm_start) const {
+        MatrixRhoS rho_s;
+        RpsSolveInfo info = solve_forward(q_par_in, qp_out, rho_fk, rho_s, warm_start);
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            q_ser_out[i] = qp_out[rps_select_ser.q[i]];
+            jac_fk.row(i) = rho_s.row(rps_select_ser.q[i]);
+        }
+        return info;
+    }
+
+    RpsSolveInfo RpsKinematics::forward_velocity(const VectorQs& q_par_in, VectorQs& q_ser_out, VectorQp& qp_out, MatrixRho& rho_fk, MatrixJac& jac_fk, const VectorQs& q_par_dot_in, VectorQs& q_ser_dot_out, VectorQp& qp_dot_out, bool warm_start) const {
+        RpsSolveInfo info = forward(q_par_in, q_ser_out, qp_out, rho_fk, jac_fk, warm_start);
+        map_velocity(rps_select_par, rho_fk, jac_fk, q_par_dot_in, q_ser_dot_out, qp_dot_out);
+        return info;
+    }
+
+    RpsSolveInfo RpsKinematics::inverse(const VectorQs& q_ser_in, VectorQs& q_par_out, VectorQp& qp_out, MatrixRho& rho_ik, MatrixJac& jac_ik, bool warm_start) const {
+        MatrixRhoS rho_s;
+        RpsSolveInfo info = solve(rps_select_ser, q_ser_in, qp_out, rho_ik, rho_s, warm_start);
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            q_par_out[i] = qp_out[rps_select_par.q[i]];
+            jac_ik.row(i) = rho_s.row(rps_select_par.q[i]);
+        }
+        return info;
+    }
+
+    RpsSolveInfo RpsKinematics::inverse_velocity(const VectorQs& q_ser_in, VectorQs& q_par_out, VectorQp& qp_out, MatrixRho& rho_ik, MatrixJac& jac_ik, const VectorQs& q_ser_dot_in, VectorQs& q_par_dot_out, VectorQp& qp_dot_out, bool warm_start) const {
+        RpsSolveInfo info = inverse(q_ser_in, q_par_out, qp_out, rho_ik, jac_ik, warm_start);
+        map_velocity(rps_select_ser, rho_ik, jac_ik, q_ser_dot_in, q_par_dot_out, qp_dot_out);
+        return info;
+    }
+
+    void RpsKinematics::map_velocity(const RpsSelection& select, const MatrixRho& rho, const MatrixJac& jac, const VectorQs& qs_dot, VectorQs& q_dot, VectorQp& qp_dot) {
+        q_dot.noalias() = jac * qs_dot;
+        VectorQb qb_dot;
+        qb_dot.noalias() = rho * qs_dot;
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            qp_dot[select.q[i]] = qs_dot[i];
+        }
+        for (std::size_t i = 0; i < n_qb; ++i) {
+            qp_dot[select.b[i]] = qb_dot[i];
+        }
+    }
+
+    RpsSolveInfo RpsKinematics::solve(const RpsSelection& select, const VectorQs& qs, VectorQp& qp, MatrixRho& rho, MatrixRhoS& rho_s, bool warm_start) const {
+
+        RpsSolveInfo info;
+        Eigen::PartialPivLU<MatrixPhiB> lu;
+        MatrixRho phi_d_qs;
+
+        // seed from the previous solution if requested, and fall back on the cold guess if that diverges
+        bool solved = false;
+        if (warm_start && qp.allFinite()) {
+            info.warm_started = true;
+            solved = newton(select, qs, qp, lu, phi_d_qs, info, true);
+            info.cold_restart = !solved;
+        }
+        if (!solved) {
+            qp = qp_guess();
+            info.converged = newton(select, qs, qp, lu, phi_d_qs, info, false);
+        }
+        else {
+            info.converged = true;
+        }
+
+        rho_solve(select, lu, phi_d_qs, rho, rho_s);
+
+        return info;
+    }
+
+    bool RpsKinematics::newton(const RpsSelection& select, const VectorQs& qs, VectorQp& qp, Eigen::PartialPivLU<MatrixPhiB>& lu, MatrixRho& phi_d_qs, RpsSolveInfo& info, bool stop_on_divergence) const {
+
+        // temporary variables containing kinematic constraints etc.
+        VectorQp psi;
+        MatrixPhiB phi_d_qb;
+        VectorQb dqb;
+
+        // initialize variables for keeping track of error
+        double err = 0;
+        double err_last = std::numeric_limits<double>::infinity();
+
+        // run no more than max_it iterations of updating the solution for qp
+        // exit loop once the error is below the input tolerance
+        uint32 it = 0;
+        while (true) {
+            psi_update(select, qs, qp, psi); // calculate 9 constraints and tracking error on specified qs
+
+            // update the error. this ends up being sqrt of sum of squares
+            err = psi.norm();
+            if (err <= m_tol || it == m_max_it)
+                break;
+            if (stop_on_divergence && !(err < err_last)) {
+                // residual is growing (or NaN), so this seed is not in the basin of the solution
+                info.iterations += it;
+                info.residual = err;
+                return false;
+            }
+            err_last = err;
+
+            // the selection rows of psi give the step in the specified variables directly, which
+            // leaves phi_d_qb * dqb = phi - phi_d_qs * dqs for the remaining ones
+            phi_d_qp_split(select, qp, phi_d_qb, phi_d_qs);
+            lu.compute(phi_d_qb);
+            dqb.noalias() = psi.head<n_qb>() - phi_d_qs * psi.tail<n_qs>();
+            dqb = lu.solve(dqb);
+            for (std::size_t i = 0; i < n_qs; ++i) {
+                qp[select.q[i]] = qs[i];
+            }
+            for (std::size_t i = 0; i < n_qb; ++i) {
+                qp[select.b[i]] -= dqb[i];
+            }
+
+            it++;
+        }
+
+        // the seed was already a solution, but the factorization is still needed for rho
+        if (it == 0) {
+            phi_d_qp_split(select, qp, phi_d_qb, phi_d_qs);
+            lu.compute(phi_d_qb);
+        }
+
+        info.iterations += it;
+        info.residual = err;
+        return err <= m_tol;
+    }
+
+    RpsSolveInfo RpsKinematics::solve_forward(const VectorQs& q_par, VectorQp& qp, MatrixRho& rho, MatrixRhoS& rho_s, bool warm_start) const {
+        switch (m_fk_method) {
+            case RpsFkMethod::Table:
+                if (m_table && m_table->lookup(q_par, qp)) {
+                    // the stored rho_s is only accurate enough to interpolate qp, and jac_fk maps the serial torques
+                    // to the links, so rho is built from one factorization at the interpolated qp
+                    rho_update(rps_select_par, qp, rho, rho_s);
+                    RpsSolveInfo info;
+                    info.converged = true;
+                    info.table_lookup = true;
+                    return info;
+                }
+                return solve(rps_select_par, q_par, qp, rho, rho_s, warm_start);
+            case RpsFkMethod::Reduced:
+                return solve_reduced(q_par, qp, rho, rho_s, warm_start);
+            default:
+                return solve(rps_select_par, q_par, qp, rho, rho_s, warm_start);
+        }
+    }
+
+    RpsSolveInfo RpsKinematics::solve_reduced(const VectorQs& q_par, VectorQp& qp, MatrixRho& rho, MatrixRhoS& rho_s, bool warm_start) const {
+
+        RpsSolveInfo info;
+        VectorQs theta;
+
+        // seed from the previous leg angles if requested, and fall back on the cold guess if that diverges
+        bool solved = false;
+        if (warm_start && qp.head<n_qs>().allFinite()) {
+            info.warm_started = true;
+            theta = qp.head<n_qs>();
+            solved = reduced_newton(q_par, theta, qp, info, true);
+            info.cold_restart = !solved;
+        }
+        if (!solved) {
+            theta_guess(q_par, theta);
+            solved = reduced_newton(q_par, theta, qp, info, false);
+        }
+        if (!solved) {
+            // outside the region where the reduced problem is well behaved, use the general solver
+            RpsSolveInfo general = solve(rps_select_par, q_par, qp, rho, rho_s, false);
+            general.iterations += info.iterations;
+            general.warm_started = info.warm_started;
+            general.cold_restart = info.cold_restart;
+            return general;
+        }
+        info.converged = true;
+
+        // rho follows from the constraint jacobian at the solution
+        rho_update(rps_select_par, qp, rho, rho_s);
+
+        // report the residual of the full constraints so it is comparable with solve()
+        VectorQp psi;
+        psi_update(rps_select_par, q_par, qp, psi);
+        info.residual = psi.norm();
+
+        return info;
+    }
+
+    bool RpsKinematics::reduced_newton(const VectorQs& q_par, VectorQs& theta, VectorQp& qp, RpsSolveInfo& info, bool stop_on_divergence) const {
+
+        std::array<Eigen::Vector3d, 3> p;   // spherical joint positions
+        std::array<Eigen::Vector3d, 3> dp;  // derivative of each spherical joint position w.r.t. its leg angle
+        VectorQs f;                         // distance constraints between spherical joints
+        MatrixJac f_d_theta;                // derivative of f w.r.t. theta
+
+        double err = 0;
+        double err_last = std::numeric_limits<double>::infinity();
+
+        uint32 it = 0;
+        while (true) {
+            for (std::size_t i = 0; i < 3; ++i) {
+                double s = sin(theta[i]);
+                double c = cos(theta[i]);
+                p[i] = s_legs.base[i] + q_par[i] * Eigen::Vector3d(s, -s_legs.cos_b[i] * c, -s_legs.sin_b[i] * c);
+                dp[i] = q_par[i] * Eigen::Vector3d(c, s_legs.cos_b[i] * s, s_legs.sin_b[i] * s);
+            }
+            f_d_theta.setZero();
+            for (std::size_t i = 0; i < 3; ++i) {
+                std::size_t j = (i + 1) % 3;
+                Eigen::Vector3d d = p[i] - p[j];
+                f[i] = d.squaredNorm() - s_legs.side_sq;
+                f_d_theta(i, i) = 2 * d.dot(dp[i]);
+                f_d_theta(i, j) = -2 * d.dot(dp[j]);
+            }
+
+            err = f.norm();
+            if (err <= m_tol || it == m_max_it)
+                break;
+            if (stop_on_divergence && !(err < err_last)) {
+                info.iterations += it;
+                return false;
+            }
+            err_last = err;
+
+            theta -= f_d_theta.partialPivLu().solve(f);
+            // The distance constraints are also met with the legs folded back through the forearm
+            // (negative leg angles), so keep the iteration on the physical side
+            for (std::size_t i = 0; i < n_qs; ++i) {
+                theta[i] = std::min(std::max(theta[i], theta_min_), PI - theta_min_);
+            }
+            it++;
+        }
+        info.iterations += it;
+        if (!(err <= m_tol))
+            return false;
+
+        // the platform center is the centroid of the spherical joints, and since the joints sit at
+        // angles g_i on a circle of radius r_, the first two columns of the platform rotation are
+        // 2/(3 r_) * sum((p_i - center) * [cos(g_i), sin(g_i)])
+        Eigen::Vector3d center = (p[0] + p[1] + p[2]) / 3;
+        Eigen::Vector3d x_axis = Eigen::Vector3d::Zero();
+        Eigen::Vector3d y_axis = Eigen::Vector3d::Zero();
+        for (std::size_t i = 0; i < 3; ++i) {
+            x_axis += (p[i] - center) * s_legs.cos_g[i];
+            y_axis += (p[i] - center) * s_legs.sin_g[i];
+        }
+        x_axis *= 2 / (3 * r_);
+        y_axis *= 2 / (3 * r_);
+        Eigen::Vector3d z_axis = x_axis.cross(y_axis);
+
+        // invert the platform rotation used in phi, see phi_update()
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            qp[i] = atan2(sin(theta[i]), cos(theta[i]));
+        }
+        qp.segment<n_qs>(3) = q_par;
+        qp[6] = atan2(-z_axis[2], z_axis[0]);
+        qp[7] = atan2(z_axis[1], sqrt(x_axis[1] * x_axis[1] + y_axis[1] * y_axis[1]));
+        qp[8] = atan2(-y_axis[1], x_axis[1]);
+        qp.tail<n_qs>() = center;
+
+        return true;
+    }
+
+    RpsValidationResult RpsKinematics::validate_reduced(const VectorQs& q_par_min, const VectorQs& q_par_max, std::size_t n_grid) const {
+
+        RpsValidationResult result;
+
+        VectorQs q_par, q_ser_general, q_ser_reduced;
+        VectorQp qp_general, qp_reduced;
+        MatrixRho rho_general, rho_reduced;
+        MatrixRhoS rho_s_general, rho_s_reduced;
+        MatrixJac jac_general, jac_reduced;
+
+        for (std::size_t i = 0; i < n_grid; ++i) {
+            for (std::size_t j = 0; j < n_grid; ++j) {
+                for (std::size_t k = 0; k < n_grid; ++k) {
+                    std::size_t idx[3] = { i, j, k };
+                    for (std::size_t n = 0; n < n_qs; ++n) {
+                        double frac = n_grid > 1 ? (double)idx[n] / (n_grid - 1) : 0.5;
+                        q_par[n] = q_par_min[n] + frac * (q_par_max[n] - q_par_min[n]);
+                    }
+                    result.samples++;
+
+                    if (!solve(rps_select_par, q_par, qp_general, rho_general, rho_s_general).converged) {
+                        result.general_failures++;
+                        continue;
+                    }
+                    // run the reduced iteration directly so a silent fallback on solve() is not counted as agreement
+                    RpsSolveInfo info;
+                    VectorQs theta;
+                    theta_guess(q_par, theta);
+                    if (!reduced_newton(q_par, theta, qp_reduced, info, false)) {
+                        result.reduced_failures++;
+                        continue;
+                    }
+                    rho_update(rps_select_par, qp_reduced, rho_reduced, rho_s_reduced);
+
+                    for (std::size_t n = 0; n < n_qs; ++n) {
+                        q_ser_general[n] = qp_general[rps_select_ser.q[n]];
+                        q_ser_reduced[n] = qp_reduced[rps_select_ser.q[n]];
+                        jac_general.row(n) = rho_s_general.row(rps_select_ser.q[n]);
+                        jac_reduced.row(n) = rho_s_reduced.row(rps_select_ser.q[n]);
+                    }
+                    double q_ser_error = (q_ser_general - q_ser_reduced).cwiseAbs().maxCoeff();
+                    double jac_error = (jac_general - jac_reduced).cwiseAbs().maxCoeff() / std::max(1.0, jac_general.cwiseAbs().maxCoeff());
+                    // far from the nominal pose the mechanism has more than one assembly mode, and the
+                    // two methods are not guaranteed to pick the same one from the cold guess
+                    if (q_ser_error > 1e-6) {
+                        result.branch_mismatches++;
+                        continue;
+                    }
+                    if (q_ser_error > result.max_q_ser_error) {
+                        result.max_q_ser_error = q_ser_error;
+                        result.worst_q_par = q_par;
+                    }
+                    result.max_jac_fk_error = std::max(result.max_jac_fk_error, jac_error);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    RpsValidationResult RpsKinematics::validate_table(const VectorQs& q_par_min, const VectorQs& q_par_max, std::size_t n_grid) const {
+
+        RpsValidationResult result;
+        if (!m_table)
+            return result;
+
+        VectorQs q_par, q_ser_general, q_ser_table;
+        VectorQp qp_general, qp_table;
+        MatrixRho rho_general, rho_table;
+        MatrixRhoS rho_s_general, rho_s_table;
+        MatrixJac jac_general, jac_table;
+
+        for (std::size_t i = 0; i < n_grid; ++i) {
+            for (std::size_t j = 0; j < n_grid; ++j) {
+                for (std::size_t k = 0; k < n_grid; ++k) {
+                    // cell centers rather than corners, so the points fall between the table's nodes
+                    std::size_t idx[3] = { i, j, k };
+                    for (std::size_t n = 0; n < n_qs; ++n) {
+                        double frac = (idx[n] + 0.5) / n_grid;
+                        q_par[n] = q_par_min[n] + frac * (q_par_max[n] - q_par_min[n]);
+                    }
+                    result.samples++;
+
+                    if (!m_table->lookup(q_par, qp_table)) {
+                        result.table_misses++;
+                        continue;
+                    }
+                    rho_update(rps_select_par, qp_table, rho_table, rho_s_table);
+                    // warm start from the table so the solver stays on the table's assembly mode
+                    qp_general = qp_table;
+                    if (!solve(rps_select_par, q_par, qp_general, rho_general, rho_s_general, true).converged) {
+                        result.general_failures++;
+                        continue;
+                    }
+
+                    for (std::size_t n = 0; n < n_qs; ++n) {
+                        q_ser_general[n] = qp_general[rps_select_ser.q[n]];
+                        q_ser_table[n] = qp_table[rps_select_ser.q[n]];
+                        jac_general.row(n) = rho_s_general.row(rps_select_ser.q[n]);
+                        jac_table.row(n) = rho_s_table.row(rps_select_ser.q[n]);
+                    }
+                    double q_ser_error = (q_ser_general - q_ser_table).cwiseAbs().maxCoeff();
+                    double jac_error = (jac_general - jac_table).cwiseAbs().maxCoeff() / std::max(1.0, jac_general.cwiseAbs().maxCoeff());
+                    if (q_ser_error > result.max_q_ser_error) {
+                        result.max_q_ser_error = q_ser_error;
+                        result.worst_q_par = q_par;
+                    }
+                    result.max_jac_fk_error = std::max(result.max_jac_fk_error, jac_error);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void RpsKinematics::generate_rho(const RpsSelection& select, const VectorQp& qp, MatrixRho& rho) const {
+        MatrixRhoS rho_s;
+        rho_update(select, qp, rho, rho_s);
+    }
+
+    void RpsKinematics::solve_static_torques(const RpsSelection& select, const VectorQb& tau_b, const VectorQp& qp, VectorQs& tau_s) const {
+        MatrixRho rho;
+        generate_rho(select, qp, rho);
+        tau_s.noalias() = -rho.transpose() * tau_b;
+    }
+
+    void RpsKinematics::solve_static_torques(const RpsSelection& select, const VectorQb& tau_b, const VectorQp& qp, VectorQs& tau_s, VectorQp& tau_p) const {
+        solve_static_torques(select, tau_b, qp, tau_s);
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            tau_p[select.q[i]] = tau_s[i];
+        }
+        for (std::size_t i = 0; i < n_qb; ++i) {
+            tau_p[select.b[i]] = tau_b[i];
+        }
+    }
+
+    void RpsKinematics::psi_update(const RpsSelection& select, const VectorQs& qs, const VectorQp& qp, VectorQp& psi) {
+        VectorQb phi;
+        phi_update(qp, phi);
+        psi.head<n_qb>() = phi;
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            psi[n_qb + i] = qp[select.q[i]] - qs[i];
+        }
+    }
+
+    void RpsKinematics::phi_d_qp_split(const RpsSelection& select, const VectorQp& qp, MatrixPhiB& phi_d_qb, MatrixRho& phi_d_qs) {
+        MatrixPhi phi_d_qp;
+        phi_d_qp_update(qp, phi_d_qp);
+        for (std::size_t i = 0; i < n_qb; ++i) {
+            phi_d_qb.col(i) = phi_d_qp.col(select.b[i]);
+        }
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            phi_d_qs.col(i) = phi_d_qp.col(select.q[i]);
+        }
+    }
+
+    void RpsKinematics::rho_solve(const RpsSelection& select, const Eigen::PartialPivLU<MatrixPhiB>& lu, const MatrixRho& phi_d_qs, MatrixRho& rho, MatrixRhoS& rho_s) {
+        // phi_d_qb * rho + phi_d_qs = 0 keeps the constraints satisfied as the specified variables move
+        rho = -lu.solve(phi_d_qs);
+        for (std::size_t i = 0; i < n_qb; ++i) {
+            rho_s.row(select.b[i]) = rho.row(i);
+        }
+        for (std::size_t i = 0; i < n_qs; ++i) {
+            rho_s.row(select.q[i]) = MatrixJac::Identity().row(i);
+        }
+    }
+
+    void RpsKinematics::rho_update(const RpsSelection& select, const VectorQp& qp, MatrixRho& rho, MatrixRhoS& rho_s) {
+        MatrixPhiB phi_d_qb;
+        MatrixRho phi_d_qs;
+        phi_d_qp_split(select, qp, phi_d_qb, phi_d_qs);
+        Eigen::PartialPivLU<MatrixPhiB> lu(phi_d_qb);
+        rho_solve(select, lu, phi_d_qs, rho, rho_s);
+    }
+
+    void RpsKinematics::phi_update(const VectorQp& qp, VectorQb& phi) {
+        rps_phi_kernel(qp.data(), phi.data());
+    }
+
+    void RpsKinematics::phi_d_qp_update(const VectorQp& qp, MatrixPhi& phi_d_qp) {
+        rps_phi_d_qp_kernel(qp.data(), phi_d_qp.data());
+    }
+
+    void RpsKinematics::phi_update_reference(const VectorQp& qp, VectorQb& phi) {
+
+        phi << qp[3] * sin(qp[0]) - qp[9] - r_*cos(alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*sin(alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])),
+        R_*cos(alpha5_) - qp[10] - a56_*sin(alpha5_) - qp[3] * cos(alpha5_)*cos(qp[0]) - r_*cos(alpha13_)*cos(qp[7])*cos(qp[8]) + r_*cos(qp[7])*sin(alpha13_)*sin(qp[8]),
+        a56_*cos(alpha5_) - qp[11] + R_*sin(alpha5_) - qp[3] * sin(alpha5_)*cos(qp[0]) - r_*cos(alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin(alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])),
+        qp[4] * sin(qp[1]) - qp[9] - r_*cos(alpha13_ - (2 * PI) / 3)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])),
+        R_*cos(alpha5_ - (2 * PI) / 3) - qp[10] - a56_*sin(alpha5_ - (2 * PI) / 3) - qp[4] * cos(alpha5_ - (2 * PI) / 3)*cos(qp[1]) - r_*cos(qp[7])*cos(qp[8])*cos(alpha13_ - (2 * PI) / 3) + r_*cos(qp[7])*sin(qp[8])*sin(alpha13_ - (2 * PI) / 3),
+        a56_*cos(alpha5_ - (2 * PI) / 3) - qp[11] + R_*sin(alpha5_ - (2 * PI) / 3) - qp[4] * cos(qp[1])*sin(alpha5_ - (2 * PI) / 3) - r_*cos(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])),
+        qp[5] * sin(qp[2]) - qp[9] - r_*cos((2 * PI) / 3 + alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])),
+        R_*cos((2 * PI) / 3 + alpha5_) - qp[10] - a56_*sin((2 * PI) / 3 + alpha5_) - qp[5] * cos((2 * PI) / 3 + alpha5_)*cos(qp[2]) - r_*cos(qp[7])*cos(qp[8])*cos((2 * PI) / 3 + alpha13_) + r_*cos(qp[7])*sin(qp[8])*sin((2 * PI) / 3 + alpha13_),
+        a56_*cos((2 * PI) / 3 + alpha5_) - qp[11] + R_*sin((2 * PI) / 3 + alpha5_) - qp[5] * cos(qp[2])*sin((2 * PI) / 3 + alpha5_) - r_*cos((2 * PI) / 3 + alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8]));
+    }
+
+    void RpsKinematics::phi_d_qp_update_reference(const VectorQp& qp, MatrixPhi& phi_d_qp) {
+
+        phi_d_qp << qp[3] * cos(qp[0]), 0, 0, sin(qp[0]), 0, 0, -r_*cos(alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin(alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[6])*cos(alpha13_)*cos(qp[7])*cos(qp[8]) - r_*cos(qp[6])*cos(qp[7])*sin(alpha13_)*sin(qp[8]), r_*sin(alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*cos(alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), -1, 0, 0,
+        qp[3] * cos(alpha5_)*sin(qp[0]), 0, 0, -cos(alpha5_)*cos(qp[0]), 0, 0, 0, r_*cos(alpha13_)*cos(qp[8])*sin(qp[7]) - r_*sin(alpha13_)*sin(qp[7])*sin(qp[8]), r_*cos(alpha13_)*cos(qp[7])*sin(qp[8]) + r_*cos(qp[7])*cos(qp[8])*sin(alpha13_), 0, -1, 0,
+        qp[3] * sin(alpha5_)*sin(qp[0]), 0, 0, -sin(alpha5_)*cos(qp[0]), 0, 0, r_*cos(alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) + r_*sin(alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[7])*sin(qp[6])*sin(alpha13_)*sin(qp[8]) - r_*cos(alpha13_)*cos(qp[7])*cos(qp[8])*sin(qp[6]), r_*sin(alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*cos(alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), 0, 0, -1,
+        0, qp[4] * cos(qp[1]), 0, 0, sin(qp[1]), 0, -r_*cos(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[6])*cos(qp[7])*cos(qp[8])*cos(alpha13_ - (2 * PI) / 3) - r_*cos(qp[6])*cos(qp[7])*sin(qp[8])*sin(alpha13_ - (2 * PI) / 3), r_*sin(alpha13_ - (2 * PI) / 3)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*cos(alpha13_ - (2 * PI) / 3)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), -1, 0, 0,
+        0, qp[4] * cos(alpha5_ - (2 * PI) / 3)*sin(qp[1]), 0, 0, -cos(alpha5_ - (2 * PI) / 3)*cos(qp[1]), 0, 0, r_*cos(qp[8])*cos(alpha13_ - (2 * PI) / 3)*sin(qp[7]) - r_*sin(qp[7])*sin(qp[8])*sin(alpha13_ - (2 * PI) / 3), r_*cos(qp[7])*cos(qp[8])*sin(alpha13_ - (2 * PI) / 3) + r_*cos(qp[7])*cos(alpha13_ - (2 * PI) / 3)*sin(qp[8]), 0, -1, 0,
+        0, qp[4] * sin(alpha5_ - (2 * PI) / 3)*sin(qp[1]), 0, 0, -cos(qp[1])*sin(alpha5_ - (2 * PI) / 3), 0, r_*cos(alpha13_ - (2 * PI) / 3)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) + r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[7])*sin(qp[6])*sin(qp[8])*sin(alpha13_ - (2 * PI) / 3) - r_*cos(qp[7])*cos(qp[8])*cos(alpha13_ - (2 * PI) / 3)*sin(qp[6]), r_*sin(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*cos(alpha13_ - (2 * PI) / 3)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), 0, 0, -1,
+        0, 0, qp[5] * cos(qp[2]), 0, 0, sin(qp[2]), -r_*cos((2 * PI) / 3 + alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[6])*cos(qp[7])*cos(qp[8])*cos((2 * PI) / 3 + alpha13_) - r_*cos(qp[6])*cos(qp[7])*sin(qp[8])*sin((2 * PI) / 3 + alpha13_), r_*sin((2 * PI) / 3 + alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) - r_*cos((2 * PI) / 3 + alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), -1, 0, 0,
+        0, 0, qp[5] * cos((2 * PI) / 3 + alpha5_)*sin(qp[2]), 0, 0, -cos((2 * PI) / 3 + alpha5_)*cos(qp[2]), 0, r_*cos(qp[8])*cos((2 * PI) / 3 + alpha13_)*sin(qp[7]) - r_*sin(qp[7])*sin(qp[8])*sin((2 * PI) / 3 + alpha13_), r_*cos(qp[7])*cos(qp[8])*sin((2 * PI) / 3 + alpha13_) + r_*cos(qp[7])*cos((2 * PI) / 3 + alpha13_)*sin(qp[8]), 0, -1, 0,
+        0, 0, qp[5] * sin((2 * PI) / 3 + alpha5_)*sin(qp[2]), 0, 0, -cos(qp[2])*sin((2 * PI) / 3 + alpha5_), r_*cos((2 * PI) / 3 + alpha13_)*(sin(qp[6])*sin(qp[8]) - cos(qp[6])*cos(qp[8])*sin(qp[7])) + r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[8])*sin(qp[6]) + cos(qp[6])*sin(qp[7])*sin(qp[8])), r_*cos(qp[7])*sin(qp[6])*sin(qp[8])*sin((2 * PI) / 3 + alpha13_) - r_*cos(qp[7])*cos(qp[8])*cos((2 * PI) / 3 + alpha13_)*sin(qp[6]), r_*sin((2 * PI) / 3 + alpha13_)*(cos(qp[6])*sin(qp[8]) + cos(qp[8])*sin(qp[6])*sin(qp[7])) - r_*cos((2 * PI) / 3 + alpha13_)*(cos(qp[6])*cos(qp[8]) - sin(qp[6])*sin(qp[7])*sin(qp[8])), 0, 0, -1;
+    }
+
+} // namespace meii
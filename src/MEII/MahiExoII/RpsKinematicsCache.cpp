@@ -0,0 +1,66 @@
+#include <MEII/MahiExoII/RpsKinematicsCache.hpp>
+#include <cstring>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    RpsKinematicsCache::RpsKinematicsCache() :
+        m_hits(0),
+        m_misses(0)
+    {
+        clear();
+    }
+
+    bool RpsKinematicsCache::lookup(const RpsKinematics::VectorQs& q_par, RpsKinematics::VectorQs& q_ser, RpsKinematics::VectorQp& qp, RpsKinematics::MatrixRho& rho_fk, RpsKinematics::MatrixJac& jac_fk) {
+        Key key = make_key(q_par);
+        const Entry& entry = m_entries[slot(key)];
+        if (!entry.valid || entry.key != key) {
+            m_misses++;
+            return false;
+        }
+        m_hits++;
+        q_ser = entry.q_ser;
+        qp = entry.qp;
+        rho_fk = entry.rho_fk;
+        jac_fk = entry.jac_fk;
+        return true;
+    }
+
+    void RpsKinematicsCache::insert(const RpsKinematics::VectorQs& q_par, const RpsKinematics::VectorQs& q_ser, const RpsKinematics::VectorQp& qp, const RpsKinematics::MatrixRho& rho_fk, const RpsKinematics::MatrixJac& jac_fk) {
+        Key key = make_key(q_par);
+        Entry& entry = m_entries[slot(key)];
+        entry.key = key;
+        entry.valid = true;
+        entry.q_ser = q_ser;
+        entry.qp = qp;
+        entry.rho_fk = rho_fk;
+        entry.jac_fk = jac_fk;
+    }
+
+    void RpsKinematicsCache::clear() {
+        for (auto& entry : m_entries) {
+            entry.valid = false;
+        }
+    }
+
+    RpsKinematicsCache::Key RpsKinematicsCache::make_key(const RpsKinematics::VectorQs& q_par) {
+        Key key;
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+            // +0.0 and -0.0 are the same position
+            double q = q_par[i] == 0 ? 0.0 : q_par[i];
+            std::memcpy(&key[i], &q, sizeof(q));
+        }
+        return key;
+    }
+
+    std::size_t RpsKinematicsCache::slot(const Key& key) {
+        // neighboring encoder counts differ only in the low mantissa bits, so every bit is mixed (splitmix64 finalizer)
+        uint64 h = key[0] ^ (key[1] * 0x9E3779B97F4A7C15ull) ^ (key[2] * 0xC2B2AE3D27D4EB4Full);
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+        h ^= h >> 31;
+        return (std::size_t)h & (n_entries - 1);
+    }
+
+} // namespace meii
@@ -0,0 +1,305 @@
+#include <MEII/MahiExoII/RpsLookupTable.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+        const char rps_table_magic[8] = { 'M', 'E', 'I', 'I', 'R', 'P', 'S', '\0' };
+    }
+
+    RpsLookupTable::RpsLookupTable() :
+        m_header(nullptr),
+        m_nodes(nullptr),
+        m_address(nullptr),
+        m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE),
+        m_mapping(nullptr)
+#endif
+    {
+        m_inv_step[0] = m_inv_step[1] = m_inv_step[2] = 0;
+    }
+
+    RpsLookupTable::~RpsLookupTable() {
+        close();
+    }
+
+    bool RpsLookupTable::open(const std::string& filepath) {
+        close();
+
+#ifdef _WIN32
+        m_file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            LOG(Error) << "Failed to open RPS lookup table " << filepath;
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+            LOG(Error) << "Failed to read the size of RPS lookup table " << filepath;
+            close();
+            return false;
+        }
+        m_size = static_cast<std::size_t>(size.QuadPart);
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) {
+            LOG(Error) << "Failed to map RPS lookup table " << filepath;
+            close();
+            return false;
+        }
+        m_address = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_address == nullptr) {
+            LOG(Error) << "Failed to map RPS lookup table " << filepath;
+            close();
+            return false;
+        }
+#else
+        int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG(Error) << "Failed to open RPS lookup table " << filepath;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            LOG(Error) << "Failed to read the size of RPS lookup table " << filepath;
+            ::close(fd);
+            return false;
+        }
+        m_size = static_cast<std::size_t>(st.st_size);
+        void* address = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            LOG(Error) << "Failed to map RPS lookup table " << filepath;
+            m_size = 0;
+            return false;
+        }
+        m_address = address;
+#endif
+
+        // validate the header before trusting anything in the file
+        const RpsLookupTableHeader* header = static_cast<const RpsLookupTableHeader*>(m_address);
+        if (m_size < sizeof(RpsLookupTableHeader) || std::memcmp(header->magic, rps_table_magic, sizeof(rps_table_magic)) != 0) {
+            LOG(Error) << filepath << " is not an RPS lookup table";
+            close();
+            return false;
+        }
+        if (header->version != version || header->n_values != n_values) {
+            LOG(Error) << "RPS lookup table " << filepath << " has version " << header->version << ", expected " << version;
+            close();
+            return false;
+        }
+        std::size_t n_nodes = 1;
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (header->n_grid[i] < 2 || !(header->q_par_max[i] > header->q_par_min[i])) {
+                LOG(Error) << "RPS lookup table " << filepath << " has an invalid grid";
+                close();
+                return false;
+            }
+            n_nodes *= header->n_grid[i];
+        }
+        if (m_size != sizeof(RpsLookupTableHeader) + n_nodes * n_values * sizeof(double)) {
+            LOG(Error) << "RPS lookup table " << filepath << " is truncated";
+            close();
+            return false;
+        }
+
+        m_header = header;
+        m_nodes = reinterpret_cast<const double*>(static_cast<const char*>(m_address) + sizeof(RpsLookupTableHeader));
+        for (std::size_t i = 0; i < 3; ++i) {
+            m_inv_step[i] = (m_header->n_grid[i] - 1) / (m_header->q_par_max[i] - m_header->q_par_min[i]);
+        }
+        return true;
+    }
+
+    void RpsLookupTable::close() {
+#ifdef _WIN32
+        if (m_address != nullptr)
+            UnmapViewOfFile(m_address);
+        if (m_mapping != nullptr)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_address != nullptr)
+            munmap(m_address, m_size);
+#endif
+        m_address = nullptr;
+        m_size = 0;
+        m_header = nullptr;
+        m_nodes = nullptr;
+    }
+
+    bool RpsLookupTable::lookup(const RpsKinematics::VectorQs& q_par, RpsKinematics::VectorQp& qp) const {
+        if (m_header == nullptr)
+            return false;
+
+        // locate the cell containing q_par and the position within it
+        std::size_t cell[3];
+        double frac[3];
+        for (std::size_t i = 0; i < 3; ++i) {
+            double x = (q_par[i] - m_header->q_par_min[i]) * m_inv_step[i];
+            if (!(x >= 0 && x <= m_header->n_grid[i] - 1))
+                return false;
+            cell[i] = std::min(static_cast<std::size_t>(x), static_cast<std::size_t>(m_header->n_grid[i] - 2));
+            frac[i] = x - cell[i];
+        }
+
+        // trilinear weights, nodes, and offset of q_par from each of the 8 cell corners
+        double weight[8];
+        const double* corner[8];
+        double offset[8][3];
+        for (std::size_t c = 0; c < 8; ++c) {
+            std::size_t d[3] = { (c >> 2) & 1, (c >> 1) & 1, c & 1 };
+            weight[c] = 1;
+            for (std::size_t i = 0; i < 3; ++i) {
+                weight[c] *= d[i] ? frac[i] : 1 - frac[i];
+                offset[c][i] = (frac[i] - d[i]) / m_inv_step[i];
+            }
+            corner[c] = m_nodes + node_index(cell[0] + d[0], cell[1] + d[1], cell[2] + d[2]) * n_values;
+            // unsolved nodes are stored as NaN
+            if (corner[c][0] != corner[c][0])
+                return false;
+        }
+
+        // Blending the corner values with trilinear weights has a second order error of -f''*h^2*t*(1-t)/2,
+        // and blending first order extrapolations from the corners (rho_s is the gradient of qp) has the
+        // same error with the opposite sign. Averaging the two cancels it.
+        double* qp_out = qp.data();
+        for (std::size_t v = 0; v < RpsKinematics::n_qp; ++v) {
+            double sum = 0;
+            for (std::size_t c = 0; c < 8; ++c) {
+                const double* grad = corner[c] + RpsKinematics::n_qp + v;
+                double step = grad[0] * offset[c][0] + grad[RpsKinematics::n_qp] * offset[c][1] + grad[2 * RpsKinematics::n_qp] * offset[c][2];
+                sum += weight[c] * (corner[c][v] + 0.5 * step);
+            }
+            qp_out[v] = sum;
+        }
+
+        // the link lengths are exact, not interpolated
+        for (std::size_t i = 0; i < RpsKinematics::n_qs; ++i) {
+            qp[rps_select_par.q[i]] = q_par[i];
+        }
+        return true;
+    }
+
+    std::size_t RpsLookupTable::generate(const std::string& filepath, const RpsKinematics& rps, const RpsKinematics::VectorQs& q_par_min, const RpsKinematics::VectorQs& q_par_max, std::size_t n_grid, double max_rho) {
+        if (n_grid < 2) {
+            LOG(Error) << "RPS lookup table needs at least 2 nodes along each link length";
+            return 0;
+        }
+
+        RpsLookupTableHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, rps_table_magic, sizeof(rps_table_magic));
+        header.version = version;
+        header.n_values = static_cast<uint32>(n_values);
+        for (std::size_t i = 0; i < 3; ++i) {
+            header.n_grid[i] = static_cast<uint32>(n_grid);
+            header.q_par_min[i] = q_par_min[i];
+            header.q_par_max[i] = q_par_max[i];
+        }
+
+        const std::size_t n_nodes = n_grid * n_grid * n_grid;
+        std::vector<double> nodes(n_nodes * n_values, std::numeric_limits<double>::quiet_NaN());
+        std::vector<bool> solved(n_nodes, false);
+
+        auto node_q_par = [&](std::size_t index) {
+            std::size_t idx[3] = { index / (n_grid * n_grid), (index / n_grid) % n_grid, index % n_grid };
+            RpsKinematics::VectorQs q_par;
+            for (std::size_t i = 0; i < 3; ++i) {
+                q_par[i] = q_par_min[i] + idx[i] * (q_par_max[i] - q_par_min[i]) / (n_grid - 1);
+            }
+            return q_par;
+        };
+
+        RpsKinematics::VectorQp qp;
+        RpsKinematics::MatrixRho rho;
+        RpsKinematics::MatrixRhoS rho_s;
+
+        // seed with a cold solve at the node closest to the nominal pose
+        std::size_t seed[3];
+        for (std::size_t i = 0; i < 3; ++i) {
+            double x = (RpsKinematics::qp_guess()[rps_select_par.q[i]] - q_par_min[i]) * (n_grid - 1) / (q_par_max[i] - q_par_min[i]);
+            seed[i] = static_cast<std::size_t>(std::round(std::min(std::max(x, 0.0), n_grid - 1.0)));
+        }
+        std::size_t seed_index = (seed[0] * n_grid + seed[1]) * n_grid + seed[2];
+        if (!rps.solve(rps_select_par, node_q_par(seed_index), qp, rho, rho_s).converged) {
+            LOG(Error) << "RPS lookup table generation failed to solve the seed node";
+            return 0;
+        }
+
+        // flood outward, warm starting each node from the neighbor that reached it. A warm start
+        // that diverges is rejected rather than restarted, since a cold restart could land on a
+        // different assembly mode; the node may still be reached later through another neighbor.
+        std::deque<std::size_t> frontier;
+        std::size_t n_solved = 0;
+        auto store = [&](std::size_t index) {
+            std::memcpy(&nodes[index * n_values], qp.data(), RpsKinematics::n_qp * sizeof(double));
+            std::memcpy(&nodes[index * n_values + RpsKinematics::n_qp], rho_s.data(), RpsKinematics::n_qp * RpsKinematics::n_qs * sizeof(double));
+            solved[index] = true;
+            frontier.push_back(index);
+            n_solved++;
+        };
+        store(seed_index);
+
+        const std::ptrdiff_t offsets[3] = { static_cast<std::ptrdiff_t>(n_grid * n_grid), static_cast<std::ptrdiff_t>(n_grid), 1 };
+        while (!frontier.empty()) {
+            std::size_t index = frontier.front();
+            frontier.pop_front();
+            std::size_t idx[3] = { index / (n_grid * n_grid), (index / n_grid) % n_grid, index % n_grid };
+            for (std::size_t axis = 0; axis < 3; ++axis) {
+                for (int dir = -1; dir <= 1; dir += 2) {
+                    if ((dir < 0 && idx[axis] == 0) || (dir > 0 && idx[axis] == n_grid - 1))
+                        continue;
+                    std::size_t neighbor = index + dir * offsets[axis];
+                    if (solved[neighbor])
+                        continue;
+                    std::memcpy(qp.data(), &nodes[index * n_values], RpsKinematics::n_qp * sizeof(double));
+                    RpsSolveInfo info = rps.solve(rps_select_par, node_q_par(neighbor), qp, rho, rho_s, true);
+                    // near a singularity the solution bends too sharply to interpolate, so leave it to the solver
+                    if (info.converged && !info.cold_restart && rho_s.cwiseAbs().maxCoeff() <= max_rho)
+                        store(neighbor);
+                }
+            }
+        }
+
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            LOG(Error) << "Failed to create RPS lookup table " << filepath;
+            return 0;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(double));
+        if (!file) {
+            LOG(Error) << "Failed to write RPS lookup table " << filepath;
+            return 0;
+        }
+        return n_solved;
+    }
+
+} // namespace meii
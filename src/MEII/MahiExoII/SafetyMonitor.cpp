@@ -0,0 +1,143 @@
+#include <MEII/MahiExoII/SafetyMonitor.hpp>
+#include <MEII/Utility/EventLog.hpp>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+        const char* limit_names[SafetyMonitor::n_limits] = {
+            "position exceeded the min position limit",
+            "position exceeded the max position limit",
+            "velocity exceeded the velocity limit",
+            "command torque exceeded the torque limit",
+            "motor exceeded its I^2t limit"
+        };
+    }
+
+    SafetyMonitor::SafetyMonitor(const MeiiParameters& params) {
+        const double inf = std::numeric_limits<double>::infinity();
+        m_pos_min.fill(-inf);
+        m_pos_max.fill(inf);
+        m_vel_max.fill(inf);
+        m_trq_max.fill(inf);
+        m_amps_per_torque.fill(0);
+        m_cont_sq.fill(0);
+        m_i2t_budget.fill(inf);
+        m_i2t.fill(0);
+        for (std::size_t j = 0; j < n_joints; ++j) {
+            m_pos_min[j] = params.pos_limits_min_[j];
+            m_pos_max[j] = params.pos_limits_max_[j];
+            m_vel_max[j] = params.vel_limits_[j];
+            m_trq_max[j] = params.joint_torque_limits[j];
+            // motor torque = joint torque * eta, and current = motor torque / kt, as in JointHardware::set_torque()
+            m_amps_per_torque[j] = params.eta_[j] / params.kt_[j];
+            m_cont_sq[j] = params.motor_cont_limits_[j] * params.motor_cont_limits_[j];
+            m_i2t_budget[j] = (params.motor_peak_limits_[j] * params.motor_peak_limits_[j] - m_cont_sq[j]) * params.motor_i2t_times_[j].as_seconds();
+        }
+
+        // register the diagnostics up front so report() never allocates
+        EventLog& events = event_log();
+        for (std::size_t l = 0; l < n_limits; ++l) {
+            for (std::size_t j = 0; j < n_joints; ++j) {
+                std::ostringstream text;
+                text << "Safety monitor: MEII joint " << j << " " << limit_names[l];
+                switch (l) {
+                    case PositionMin: text << " " << m_pos_min[j]; break;
+                    case PositionMax: text << " " << m_pos_max[j]; break;
+                    case Velocity:    text << " " << m_vel_max[j]; break;
+                    case Torque:      text << " " << m_trq_max[j]; break;
+                    case I2t:         text << ", fraction of budget used"; break;
+                }
+                m_events[l * n_joints + j] = events.register_event(Warning, text.str());
+            }
+        }
+    }
+
+    uint32 SafetyMonitor::check(const JointState& state, uint32 limits) {
+        const int64 time_us = state.time.as_microseconds();
+        const double dt = m_last_time_us < 0 || time_us < m_last_time_us ? 0.0 : (time_us - m_last_time_us) * 1e-6;
+        m_last_time_us = time_us;
+
+        // pad the state to the lane count, padding lanes sit at zero inside infinite limits
+        double pos[n_lanes] = {}, vel[n_lanes] = {}, cmd[n_lanes] = {}, trq[n_lanes] = {};
+        for (std::size_t j = 0; j < n_joints; ++j) {
+            pos[j] = state.position[j];
+            vel[j] = state.velocity[j];
+            cmd[j] = state.command_torque[j];
+            trq[j] = state.torque[j];
+        }
+
+        // one branch-free pass per limit, each lane's flag is shifted into its bit
+        uint32 violations = 0;
+        for (std::size_t j = 0; j < n_lanes; ++j)
+            violations |= (uint32)(pos[j] < m_pos_min[j]) << (PositionMin * n_joints + j);
+        for (std::size_t j = 0; j < n_lanes; ++j)
+            violations |= (uint32)(pos[j] > m_pos_max[j]) << (PositionMax * n_joints + j);
+        for (std::size_t j = 0; j < n_lanes; ++j)
+            violations |= (uint32)(std::abs(vel[j]) > m_vel_max[j]) << (Velocity * n_joints + j);
+        for (std::size_t j = 0; j < n_lanes; ++j)
+            violations |= (uint32)(std::abs(cmd[j]) > m_trq_max[j]) << (Torque * n_joints + j);
+        for (std::size_t j = 0; j < n_lanes; ++j) {
+            const double amps = trq[j] * m_amps_per_torque[j];
+            const double i2t = m_i2t[j] + (amps * amps - m_cont_sq[j]) * dt;
+            m_i2t[j] = i2t > 0.0 ? i2t : 0.0;
+            violations |= (uint32)(m_i2t[j] >= m_i2t_budget[j]) << (I2t * n_joints + j);
+        }
+        // padding lanes never violate, so this only drops the limits the caller did not ask for
+        violations &= limits;
+
+        m_violations = violations;
+        if (violations != 0)
+            report(violations, state);
+        return violations;
+    }
+
+    void SafetyMonitor::reset() {
+        m_i2t.fill(0);
+        m_last_time_us = -1;
+        m_violations = 0;
+    }
+
+    void SafetyMonitor::report(uint32 violations, const JointState& state) {
+        EventLog& events = event_log();
+        for (std::size_t b = 0; b < n_limits * n_joints; ++b) {
+            if ((violations & (1u << b)) == 0)
+                continue;
+            const std::size_t j = b % n_joints;
+            double value = 0;
+            switch (b / n_joints) {
+                case PositionMin:
+                case PositionMax: value = state.position[j]; break;
+                case Velocity:    value = state.velocity[j]; break;
+                case Torque:      value = state.command_torque[j]; break;
+                case I2t:         value = get_i2t_usage(j); break;
+            }
+            events.record(m_events[b], value);
+        }
+    }
+
+    std::string SafetyMonitor::describe(uint32 violations, const JointState& state) const {
+        std::ostringstream text;
+        for (std::size_t b = 0; b < n_limits * n_joints; ++b) {
+            if ((violations & (1u << b)) == 0)
+                continue;
+            const std::size_t j = b % n_joints;
+            if (text.tellp() > 0)
+                text << "\n";
+            text << "MEII joint " << j << " " << limit_names[b / n_joints];
+            switch (b / n_joints) {
+                case PositionMin: text << " " << m_pos_min[j] << " with a value of " << state.position[j]; break;
+                case PositionMax: text << " " << m_pos_max[j] << " with a value of " << state.position[j]; break;
+                case Velocity:    text << " " << m_vel_max[j] << " with a value of " << state.velocity[j]; break;
+                case Torque:      text << " " << m_trq_max[j] << " with a value of " << state.command_torque[j]; break;
+                case I2t:         text << " with " << 100.0 * get_i2t_usage(j) << " % of its budget used"; break;
+            }
+        }
+        return text.str();
+    }
+
+} // namespace meii
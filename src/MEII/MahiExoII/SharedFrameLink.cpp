@@ -0,0 +1,56 @@
+#include <MEII/MahiExoII/SharedFrameLink.hpp>
+
+using namespace mahi::util;
+using namespace mahi::com;
+
+namespace meii {
+
+    namespace {
+        static_assert(sizeof(SharedFrameState) == 11 * sizeof(double), "SharedFrameState must fill SharedFrameRegion::state");
+        static_assert(sizeof(SharedFrameRegion) == 152, "SharedFrameRegion must match the documented layout");
+
+        // a writer finishes in well under a microsecond, so this many failed attempts means it stopped halfway
+        const uint64 max_retries = 1024;
+    }
+
+    SharedFrameLink::SharedFrameLink(const std::string& name, const std::array<double, n_joints>& rest_positions) :
+        m_shm(name, OpenOrCreate, sizeof(SharedFrameRegion)),
+        m_region(static_cast<SharedFrameRegion*>(m_shm.get_address())),
+        m_state_version(0)
+    {
+        m_region->magic = SharedFrameRegion::magic_value;
+        m_region->version = SharedFrameRegion::version_value;
+        m_state.time = 0.0;
+        for (std::size_t i = 0; i < n_joints; ++i) {
+            m_state.position[i] = rest_positions[i];
+            m_state.velocity[i] = 0.0;
+            m_command.torque[i] = 0.0;
+        }
+    }
+
+    bool SharedFrameLink::update(Time time) {
+        // until the simulator publishes, keep the rest positions
+        if (m_region->state.sequence.load(std::memory_order_acquire) == 0)
+            return true;
+        return m_region->state.try_read(m_state, m_state_version, max_retries);
+    }
+
+    bool SharedFrameLink::apply() {
+        m_region->command.write(m_command);
+        return true;
+    }
+
+    SharedFrameSimulator::SharedFrameSimulator(const std::string& name) :
+        m_shm(name, OpenOrCreate, sizeof(SharedFrameRegion)),
+        m_region(static_cast<SharedFrameRegion*>(m_shm.get_address()))
+    {
+        m_region->magic = SharedFrameRegion::magic_value;
+        m_region->version = SharedFrameRegion::version_value;
+    }
+
+    bool SharedFrameSimulator::read_command(SharedFrameCommand& command) const {
+        uint64 version;
+        return m_region->command.try_read(command, version, max_retries);
+    }
+
+} // namespace meii
@@ -0,0 +1,636 @@
+#include <MEII/Utility/ColumnarLog.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include "Crc32.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+        const char file_magic[8] = { 'M', 'E', 'I', 'I', 'C', 'O', 'L', '\0' };
+        const char index_magic[8] = { 'M', 'E', 'I', 'I', 'C', 'I', 'X', '\0' };
+        const char chunk_magic[4] = { 'C', 'O', 'L', 'C' };
+        const uint32 file_version = 1;
+
+        /// header written in front of every chunk, followed by one ColumnHeader per field and the columns
+        struct ChunkHeader {
+            char magic[4];       // "COLC"
+            uint32 n_records;    // records in the chunk
+            uint64 first;        // index of the first record in the log
+            double t_first;      // time of the first record [s]
+            double t_last;       // time of the last record [s]
+            uint64 payload_size; // size of the column headers and columns [bytes]
+            uint32 table_crc;    // CRC-32 of the column headers
+            uint32 reserved;     // zero
+        };
+
+        /// describes one encoded column of a chunk
+        struct ColumnHeader {
+            uint8 encoding;      // ColumnEncoding
+            uint8 reserved[3];   // zero
+            uint32 size;         // size of the encoded column [bytes]
+            uint32 crc;          // CRC-32 of the encoded column
+            uint32 reserved2;    // zero
+            double quantum;      // quantum of ColumnEncoding::Quantized columns
+        };
+
+        /// written at the very end of a closed log
+        struct IndexTrailer {
+            uint64 index_offset; // file offset of the first ColumnarChunkInfo [bytes]
+            uint64 n_chunks;     // number of ColumnarChunkInfos
+            char magic[8];       // "MEIICIX"
+        };
+
+        enum ColumnEncoding : uint8 {
+            Raw       = 0, // values as stored in the record
+            Delta     = 1, // zigzag varint deltas of integers
+            Xor       = 2, // varint XOR of the bits of consecutive floating point values
+            Quantized = 3  // zigzag varint deltas of round(value / quantum) and varint XOR residuals
+        };
+
+        inline uint64 zigzag(int64 v) { return ((uint64)v << 1) ^ (uint64)(v >> 63); }
+        inline int64 unzigzag(uint64 u) { return (int64)(u >> 1) ^ -(int64)(u & 1); }
+
+        inline void put_varint(std::vector<uint8>& out, uint64 v) {
+            while (v >= 0x80) {
+                out.push_back((uint8)v | 0x80);
+                v >>= 7;
+            }
+            out.push_back((uint8)v);
+        }
+
+        inline bool get_varint(const uint8*& p, const uint8* end, uint64& v) {
+            v = 0;
+            for (int shift = 0; shift < 64 && p < end; shift += 7) {
+                uint8 byte = *p++;
+                v |= (uint64)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                    return true;
+            }
+            return false;
+        }
+
+        /// returns the raw bits of a floating point field, zero extended
+        inline uint64 float_bits(const uint8* src, RecordType type) {
+            if (type == RecordType::Float32) {
+                uint32 bits;
+                std::memcpy(&bits, src, sizeof(bits));
+                return bits;
+            }
+            uint64 bits;
+            std::memcpy(&bits, src, sizeof(bits));
+            return bits;
+        }
+
+        inline double bits_to_double(uint64 bits, RecordType type) {
+            if (type == RecordType::Float32) {
+                uint32 b = (uint32)bits;
+                float f;
+                std::memcpy(&f, &b, sizeof(f));
+                return f;
+            }
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            return d;
+        }
+
+        /// returns a field stored as type at src as a double
+        inline double raw_to_double(const uint8* src, RecordType type) {
+            switch (type) {
+                case RecordType::Float64: { double v; std::memcpy(&v, src, sizeof(v)); return v; }
+                case RecordType::Float32: { float v;  std::memcpy(&v, src, sizeof(v)); return v; }
+                case RecordType::Int64:   { int64 v;  std::memcpy(&v, src, sizeof(v)); return (double)v; }
+                case RecordType::Int32:   { int32 v;  std::memcpy(&v, src, sizeof(v)); return v; }
+                case RecordType::UInt8:   return *src;
+            }
+            return 0;
+        }
+
+        inline bool is_float(RecordType type) {
+            return type == RecordType::Float64 || type == RecordType::Float32;
+        }
+    }
+
+    ///////////////////////// COLUMNAR LOG WRITER /////////////////////////
+
+    ColumnarLogWriter::ColumnarLogWriter(const RecordSchema& schema, std::size_t time_field, std::size_t chunk_records) :
+        m_schema(schema),
+        m_time_field(time_field),
+        m_chunk_records(std::max<std::size_t>(chunk_records, 1)),
+        m_quanta(schema.get_field_count(), 0.0),
+        m_buffer(m_chunk_records * schema.get_record_size()),
+        m_table(schema.get_field_count() * sizeof(ColumnHeader))
+    { }
+
+    ColumnarLogWriter::~ColumnarLogWriter() {
+        close();
+    }
+
+    void ColumnarLogWriter::set_quantum(std::size_t field, double quantum) {
+        if (m_schema.get_field_type(field) != RecordType::Float64 || !(quantum > 0)) {
+            LOG(Error) << "Field " << m_schema.get_field_name(field) << " can not be quantized by " << quantum << ".";
+            return;
+        }
+        m_quanta[field] = quantum;
+    }
+
+    bool ColumnarLogWriter::open(const std::string& filepath) {
+        if (is_open()) {
+            LOG(Error) << "ColumnarLogWriter already has a file open.";
+            return false;
+        }
+        if (m_time_field >= m_schema.get_field_count()) {
+            LOG(Error) << "ColumnarLogWriter time field " << m_time_field << " is not in the schema.";
+            return false;
+        }
+        m_file = std::fopen(filepath.c_str(), "wb");
+        if (m_file == nullptr) {
+            LOG(Error) << "Failed to open " << filepath << " for writing.";
+            return false;
+        }
+        m_offset = 0;
+        m_records = 0;
+        m_buffered = 0;
+        m_index.clear();
+
+        uint32 record_size = (uint32)m_schema.get_record_size();
+        uint32 n_fields = (uint32)m_schema.get_field_count();
+        uint32 time_field = (uint32)m_time_field;
+        bool ok = write(file_magic, sizeof(file_magic)) && write(&file_version, sizeof(file_version)) &&
+                  write(&record_size, sizeof(record_size)) && write(&n_fields, sizeof(n_fields)) &&
+                  write(&time_field, sizeof(time_field));
+        for (std::size_t i = 0; ok && i < n_fields; ++i) {
+            uint8 type = (uint8)m_schema.get_field_type(i);
+            uint8 length = (uint8)m_schema.get_field_name(i).size();
+            ok = write(&type, 1) && write(&length, 1) && write(m_schema.get_field_name(i).data(), length);
+        }
+        if (!ok) {
+            LOG(Error) << "Failed to write the header of " << filepath << ".";
+            std::fclose(m_file);
+            m_file = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    bool ColumnarLogWriter::append(const uint8* record) {
+        if (!is_open())
+            return false;
+        std::memcpy(&m_buffer[m_buffered * m_schema.get_record_size()], record, m_schema.get_record_size());
+        m_buffered++;
+        m_records++;
+        if (m_buffered == m_chunk_records)
+            return write_chunk();
+        return true;
+    }
+
+    bool ColumnarLogWriter::close() {
+        if (!is_open())
+            return false;
+        bool ok = m_buffered == 0 || write_chunk();
+        IndexTrailer trailer;
+        trailer.index_offset = m_offset;
+        trailer.n_chunks = m_index.size();
+        std::memcpy(trailer.magic, index_magic, sizeof(index_magic));
+        ok = ok && (m_index.empty() || write(m_index.data(), m_index.size() * sizeof(ColumnarChunkInfo)));
+        ok = ok && write(&trailer, sizeof(trailer));
+        ok = std::fclose(m_file) == 0 && ok;
+        m_file = nullptr;
+        if (!ok)
+            LOG(Error) << "Failed to finish the columnar log.";
+        return ok;
+    }
+
+    bool ColumnarLogWriter::write(const void* data, std::size_t size) {
+        if (std::fwrite(data, 1, size, m_file) != size)
+            return false;
+        m_offset += size;
+        return true;
+    }
+
+    bool ColumnarLogWriter::write_chunk() {
+        const std::size_t n = m_buffered;
+        const std::size_t n_fields = m_schema.get_field_count();
+        const std::size_t record_size = m_schema.get_record_size();
+        m_buffered = 0;
+
+        m_columns.clear();
+        for (std::size_t f = 0; f < n_fields; ++f) {
+            const RecordType type = m_schema.get_field_type(f);
+            const std::size_t size = record_type_size(type);
+            const uint8* records = m_buffer.data();
+            const uint8* src = records + m_schema.get_field_offset(f);
+
+            // raw is always possible and is the fallback
+            m_best.clear();
+            for (std::size_t r = 0; r < n; ++r)
+                m_best.insert(m_best.end(), src + r * record_size, src + r * record_size + size);
+            ColumnHeader column;
+            std::memset(&column, 0, sizeof(column));
+            column.encoding = Raw;
+
+            if (!is_float(type)) {
+                m_candidate.clear();
+                int64 prev = 0;
+                for (std::size_t r = 0; r < n; ++r) {
+                    int64 v = m_schema.get_int(records + r * record_size, f);
+                    put_varint(m_candidate, zigzag((int64)((uint64)v - (uint64)prev)));
+                    prev = v;
+                }
+                if (m_candidate.size() < m_best.size()) {
+                    m_best.swap(m_candidate);
+                    column.encoding = Delta;
+                }
+            }
+            else {
+                m_candidate.clear();
+                uint64 prev = 0;
+                for (std::size_t r = 0; r < n; ++r) {
+                    uint64 bits = float_bits(src + r * record_size, type);
+                    put_varint(m_candidate, bits ^ prev);
+                    prev = bits;
+                }
+                if (m_candidate.size() < m_best.size()) {
+                    m_best.swap(m_candidate);
+                    column.encoding = Xor;
+                }
+
+                const double q = m_quanta[f];
+                if (q > 0) {
+                    m_candidate.clear();
+                    int64 prev_k = 0;
+                    bool representable = true;
+                    for (std::size_t r = 0; r < n && representable; ++r) {
+                        uint64 bits = float_bits(src + r * record_size, type);
+                        double v = bits_to_double(bits, type);
+                        double scaled = v / q;
+                        if (!(std::abs(scaled) < 4503599627370496.0)) { // 2^52, also rejects NaN and inf
+                            representable = false;
+                            break;
+                        }
+                        int64 k = std::llround(scaled);
+                        double snapped = (double)k * q;
+                        uint64 snapped_bits;
+                        std::memcpy(&snapped_bits, &snapped, sizeof(snapped_bits));
+                        put_varint(m_candidate, zigzag(k - prev_k));
+                        put_varint(m_candidate, bits ^ snapped_bits);
+                        prev_k = k;
+                    }
+                    if (representable && m_candidate.size() < m_best.size()) {
+                        m_best.swap(m_candidate);
+                        column.encoding = Quantized;
+                        column.quantum = q;
+                    }
+                }
+            }
+            column.size = (uint32)m_best.size();
+            column.crc = crc32(0, m_best.data(), m_best.size());
+            std::memcpy(&m_table[f * sizeof(ColumnHeader)], &column, sizeof(column));
+            m_columns.insert(m_columns.end(), m_best.begin(), m_best.end());
+        }
+
+        ColumnarChunkInfo info;
+        info.t_first = m_schema.get_double(&m_buffer[0], m_time_field);
+        info.t_last = m_schema.get_double(&m_buffer[(n - 1) * record_size], m_time_field);
+        info.offset = m_offset;
+        info.first = m_records - n;
+        info.n_records = (uint32)n;
+        info.reserved = 0;
+
+        ChunkHeader header;
+        std::memcpy(header.magic, chunk_magic, sizeof(chunk_magic));
+        header.n_records = info.n_records;
+        header.first = info.first;
+        header.t_first = info.t_first;
+        header.t_last = info.t_last;
+        header.payload_size = m_table.size() + m_columns.size();
+        header.table_crc = crc32(0, m_table.data(), m_table.size());
+        header.reserved = 0;
+
+        // flush every chunk so a crash loses at most the one being filled, the reader rebuilds the index
+        bool ok = write(&header, sizeof(header)) &&
+                  write(m_table.data(), m_table.size()) &&
+                  write(m_columns.data(), m_columns.size()) &&
+                  std::fflush(m_file) == 0;
+        if (!ok) {
+            LOG(Error) << "Failed to write a chunk of " << n << " records.";
+            return false;
+        }
+        m_index.push_back(info);
+        return true;
+    }
+
+    ///////////////////////// COLUMNAR LOG READER /////////////////////////
+
+    ColumnarLogReader::ColumnarLogReader() :
+        m_time_field(0),
+        m_recovered(false),
+        m_data(nullptr),
+        m_address(nullptr),
+        m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE),
+        m_mapping(nullptr)
+#endif
+    { }
+
+    ColumnarLogReader::~ColumnarLogReader() {
+        close();
+    }
+
+    bool ColumnarLogReader::open(const std::string& filepath) {
+        close();
+
+#ifdef _WIN32
+        m_file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            LOG(Error) << "Failed to open columnar log " << filepath;
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+            LOG(Error) << "Failed to read the size of columnar log " << filepath;
+            close();
+            return false;
+        }
+        m_size = static_cast<std::size_t>(size.QuadPart);
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) {
+            LOG(Error) << "Failed to map columnar log " << filepath;
+            close();
+            return false;
+        }
+        m_address = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_address == nullptr) {
+            LOG(Error) << "Failed to map columnar log " << filepath;
+            close();
+            return false;
+        }
+#else
+        int fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG(Error) << "Failed to open columnar log " << filepath;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            LOG(Error) << "Failed to read the size of columnar log " << filepath;
+            ::close(fd);
+            return false;
+        }
+        m_size = static_cast<std::size_t>(st.st_size);
+        void* address = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            LOG(Error) << "Failed to map columnar log " << filepath;
+            m_size = 0;
+            return false;
+        }
+        m_address = address;
+#endif
+        m_data = static_cast<const uint8*>(m_address);
+
+        // schema header
+        std::size_t offset = 0;
+        auto read = [&](void* dst, std::size_t size) {
+            if (offset + size > m_size)
+                return false;
+            std::memcpy(dst, m_data + offset, size);
+            offset += size;
+            return true;
+        };
+        char magic[8];
+        uint32 version = 0, record_size = 0, n_fields = 0, time_field = 0;
+        bool ok = read(magic, sizeof(magic)) && std::memcmp(magic, file_magic, sizeof(magic)) == 0 &&
+                  read(&version, sizeof(version)) && version == file_version &&
+                  read(&record_size, sizeof(record_size)) && read(&n_fields, sizeof(n_fields)) &&
+                  read(&time_field, sizeof(time_field)) && time_field < n_fields;
+        m_schema = RecordSchema();
+        for (uint32 i = 0; ok && i < n_fields; ++i) {
+            uint8 type, length;
+            ok = read(&type, 1) && type <= (uint8)RecordType::UInt8 && read(&length, 1) && offset + length <= m_size;
+            if (ok) {
+                m_schema.add_field(std::string(reinterpret_cast<const char*>(m_data + offset), length), (RecordType)type);
+                offset += length;
+            }
+        }
+        if (!ok || m_schema.get_record_size() != record_size) {
+            LOG(Error) << filepath << " is not a MEII columnar log of version " << file_version << ".";
+            close();
+            return false;
+        }
+        m_time_field = time_field;
+
+        // index, or the chunks themselves if the writer never closed the log
+        IndexTrailer trailer;
+        m_index.clear();
+        m_recovered = false;
+        if (m_size >= offset + sizeof(trailer)) {
+            std::memcpy(&trailer, m_data + m_size - sizeof(trailer), sizeof(trailer));
+            if (std::memcmp(trailer.magic, index_magic, sizeof(index_magic)) == 0 &&
+                trailer.index_offset >= offset &&
+                trailer.n_chunks <= (m_size - offset - sizeof(trailer)) / sizeof(ColumnarChunkInfo) &&
+                trailer.index_offset + trailer.n_chunks * sizeof(ColumnarChunkInfo) + sizeof(trailer) == m_size) {
+                m_index.resize(trailer.n_chunks);
+                if (trailer.n_chunks > 0)
+                    std::memcpy(m_index.data(), m_data + trailer.index_offset, trailer.n_chunks * sizeof(ColumnarChunkInfo));
+                // the index has no checksum of its own, so it is only trusted if it matches the chunk headers
+                if (check_index(offset, (std::size_t)trailer.index_offset))
+                    return true;
+                LOG(Warning) << "The index of " << filepath << " does not match its chunks.";
+                m_index.clear();
+            }
+        }
+        rebuild_index(offset);
+        m_recovered = true;
+        LOG(Warning) << filepath << " was not closed or has a damaged index, recovered " << m_index.size() << " chunks.";
+        return true;
+    }
+
+    void ColumnarLogReader::close() {
+#ifdef _WIN32
+        if (m_address != nullptr)
+            UnmapViewOfFile(m_address);
+        if (m_mapping != nullptr)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_address != nullptr)
+            munmap(m_address, m_size);
+#endif
+        m_address = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+        m_index.clear();
+    }
+
+    void ColumnarLogReader::rebuild_index(std::size_t offset) {
+        const std::size_t table_size = m_schema.get_field_count() * sizeof(ColumnHeader);
+        uint64 next = 0;
+        ChunkHeader header;
+        while (offset + sizeof(header) <= m_size) {
+            std::memcpy(&header, m_data + offset, sizeof(header));
+            if (std::memcmp(header.magic, chunk_magic, sizeof(chunk_magic)) != 0 || header.first != next ||
+                header.payload_size < table_size || header.payload_size > m_size - offset - sizeof(header) ||
+                crc32(0, m_data + offset + sizeof(header), table_size) != header.table_crc)
+                break;
+            ColumnarChunkInfo info;
+            info.t_first = header.t_first;
+            info.t_last = header.t_last;
+            info.offset = offset;
+            info.first = header.first;
+            info.n_records = header.n_records;
+            info.reserved = 0;
+            m_index.push_back(info);
+            next += header.n_records;
+            offset += sizeof(header) + (std::size_t)header.payload_size;
+        }
+    }
+
+    bool ColumnarLogReader::check_index(std::size_t data_offset, std::size_t index_offset) const {
+        const std::size_t table_size = m_schema.get_field_count() * sizeof(ColumnHeader);
+        std::size_t offset = data_offset;
+        uint64 next = 0;
+        ChunkHeader header;
+        for (const ColumnarChunkInfo& info : m_index) {
+            if (info.offset != offset || index_offset - offset < sizeof(header))
+                return false;
+            std::memcpy(&header, m_data + offset, sizeof(header));
+            if (std::memcmp(header.magic, chunk_magic, sizeof(chunk_magic)) != 0 || header.first != next || info.first != next ||
+                header.n_records != info.n_records || header.t_first != info.t_first || header.t_last != info.t_last ||
+                header.payload_size < table_size || header.payload_size > index_offset - offset - sizeof(header) ||
+                crc32(0, m_data + offset + sizeof(header), table_size) != header.table_crc)
+                return false;
+            next += header.n_records;
+            offset += sizeof(header) + (std::size_t)header.payload_size;
+        }
+        return offset == index_offset;
+    }
+
+    uint64 ColumnarLogReader::get_record_count() const {
+        return m_index.empty() ? 0 : m_index.back().first + m_index.back().n_records;
+    }
+
+    std::size_t ColumnarLogReader::find_chunk(double time) const {
+        auto it = std::lower_bound(m_index.begin(), m_index.end(), time,
+                                   [](const ColumnarChunkInfo& chunk, double t) { return chunk.t_last < t; });
+        return (std::size_t)(it - m_index.begin());
+    }
+
+    bool ColumnarLogReader::read_column(std::size_t chunk, std::size_t field, std::vector<double>& values) const {
+        values.clear();
+        if (chunk >= m_index.size() || field >= m_schema.get_field_count())
+            return false;
+        const ColumnarChunkInfo& info = m_index[chunk];
+        const std::size_t n = info.n_records;
+        const std::size_t table_offset = (std::size_t)info.offset + sizeof(ChunkHeader);
+        const std::size_t table_size = m_schema.get_field_count() * sizeof(ColumnHeader);
+        if (table_offset + table_size > m_size)
+            return false;
+
+        // find the column after the columns before it
+        ColumnHeader column;
+        std::size_t column_offset = table_offset + table_size;
+        for (std::size_t f = 0; f <= field; ++f) {
+            std::memcpy(&column, m_data + table_offset + f * sizeof(ColumnHeader), sizeof(column));
+            if (f < field)
+                column_offset += column.size;
+        }
+        if (column_offset + column.size > m_size || crc32(0, m_data + column_offset, column.size) != column.crc) {
+            LOG(Error) << "Column " << m_schema.get_field_name(field) << " of chunk " << chunk << " is corrupt.";
+            return false;
+        }
+
+        // every encoding takes at least a byte per record, so a larger count is damage, not a real column
+        if (n > column.size)
+            return false;
+        const RecordType type = m_schema.get_field_type(field);
+        const uint8* p = m_data + column_offset;
+        const uint8* end = p + column.size;
+        values.resize(n);
+        switch (column.encoding) {
+            case Raw: {
+                const std::size_t size = record_type_size(type);
+                if (column.size != n * size)
+                    return false;
+                for (std::size_t r = 0; r < n; ++r)
+                    values[r] = raw_to_double(p + r * size, type);
+                return true;
+            }
+            case Delta: {
+                uint64 prev = 0, u;
+                for (std::size_t r = 0; r < n; ++r) {
+                    if (!get_varint(p, end, u))
+                        return false;
+                    prev += (uint64)unzigzag(u);
+                    values[r] = (double)(int64)prev;
+                }
+                return true;
+            }
+            case Xor: {
+                uint64 prev = 0, u;
+                for (std::size_t r = 0; r < n; ++r) {
+                    if (!get_varint(p, end, u))
+                        return false;
+                    prev ^= u;
+                    values[r] = bits_to_double(prev, type);
+                }
+                return true;
+            }
+            case Quantized: {
+                int64 k = 0;
+                uint64 u, residual;
+                for (std::size_t r = 0; r < n; ++r) {
+                    if (!get_varint(p, end, u) || !get_varint(p, end, residual))
+                        return false;
+                    k += unzigzag(u);
+                    double snapped = (double)k * column.quantum;
+                    uint64 bits;
+                    std::memcpy(&bits, &snapped, sizeof(bits));
+                    values[r] = bits_to_double(bits ^ residual, type);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ColumnarLogReader::read_range(std::size_t field, double t_begin, double t_end, std::vector<double>& times, std::vector<double>& values) const {
+        times.clear();
+        values.clear();
+        std::vector<double> chunk_times, chunk_values;
+        for (std::size_t c = find_chunk(t_begin); c < m_index.size() && m_index[c].t_first <= t_end; ++c) {
+            if (!read_column(c, m_time_field, chunk_times) || !read_column(c, field, chunk_values))
+                return false;
+            for (std::size_t r = 0; r < chunk_times.size(); ++r) {
+                if (chunk_times[r] >= t_begin && chunk_times[r] <= t_end) {
+                    times.push_back(chunk_times[r]);
+                    values.push_back(chunk_values[r]);
+                }
+            }
+        }
+        return true;
+    }
+
+} // namespace meii
@@ -0,0 +1,45 @@
+// MIT License
+//
+// MEII - MAHI Exo-II Library
+// Copyright (c) 2020 Mechatronics and Haptic Interfaces Lab - Rice University
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// Author(s): Craig McDonald (craig.g.mcdonald@gmail.com)
+
+
+#pragma once
+
+#include <Mahi/Util/Types.hpp>
+#include <cstddef>
+
+namespace meii {
+
+    /// continues the CRC-32 (IEEE 802.3) crc over size bytes of data, start with crc = 0
+    inline mahi::util::uint32 crc32(mahi::util::uint32 crc, const mahi::util::uint8* data, std::size_t size) {
+        static const struct Table {
+            mahi::util::uint32 entries[256];
+            Table() {
+                for (mahi::util::uint32 i = 0; i < 256; ++i) {
+                    mahi::util::uint32 c = i;
+                    for (int k = 0; k < 8; ++k)
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    entries[i] = c;
+                }
+            }
+        } table;
+        crc = ~crc;
+        for (std::size_t i = 0; i < size; ++i)
+            crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+} // namespace meii
@@ -0,0 +1,138 @@
+#include <MEII/Utility/EventLog.hpp>
+#include <Mahi/Util/Timing/Clock.hpp>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+        inline uint64 to_bits(double value) {
+            uint64 bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+
+        inline double from_bits(uint64 bits) {
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    }
+
+    EventLog::EventLog(Time window) :
+        m_window(window),
+        m_slots(max_events),
+        m_count(0),
+        m_last_report_us(Clock::get_current_time().as_microseconds()),
+        m_stop(false)
+    {
+        m_reporter = std::thread(&EventLog::report_loop, this);
+    }
+
+    EventLog::~EventLog() {
+        {
+            std::lock_guard<std::mutex> lock(m_stop_mutex);
+            m_stop = true;
+        }
+        m_stop_cv.notify_one();
+        if (m_reporter.joinable())
+            m_reporter.join();
+    }
+
+    std::size_t EventLog::register_event(Severity severity, const std::string& message, const std::string& unit) {
+        std::lock_guard<std::mutex> lock(m_register_mutex);
+        std::size_t event = m_count.load(std::memory_order_relaxed);
+        // identical events, such as the same joint limit of several exos in one process, share a slot
+        for (std::size_t i = 0; i < event; ++i) {
+            if (m_slots[i].severity == severity && m_slots[i].message == message && m_slots[i].unit == unit)
+                return i;
+        }
+        if (event == max_events) {
+            // share the last slot rather than fail, so record() never needs a check
+            LOG(Error) << "EventLog is full, \"" << message << "\" will be reported with \"" << m_slots[event - 1].message << "\".";
+            return event - 1;
+        }
+        Slot& slot = m_slots[event];
+        slot.count = 0;
+        slot.total = 0;
+        slot.last = to_bits(0);
+        slot.peak = to_bits(0);
+        slot.severity = severity;
+        slot.message = message;
+        slot.unit = unit;
+        m_count.store(event + 1, std::memory_order_release);
+        return event;
+    }
+
+    void EventLog::record(std::size_t event, double value) {
+        Slot& slot = m_slots[event];
+        slot.count.fetch_add(1, std::memory_order_relaxed);
+        slot.total.fetch_add(1, std::memory_order_relaxed);
+        uint64 bits = to_bits(value);
+        slot.last.store(bits, std::memory_order_relaxed);
+        uint64 peak = slot.peak.load(std::memory_order_relaxed);
+        while (std::abs(value) > std::abs(from_bits(peak)) &&
+               !slot.peak.compare_exchange_weak(peak, bits, std::memory_order_relaxed)) { }
+    }
+
+    std::size_t EventLog::flush() {
+        std::lock_guard<std::mutex> lock(m_report_mutex);
+        int64 now_us = Clock::get_current_time().as_microseconds();
+        double window = (now_us - m_last_report_us) * 1e-6;
+        m_last_report_us = now_us;
+
+        std::size_t logged = 0;
+        std::size_t n_events = m_count.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < n_events; ++i) {
+            Slot& slot = m_slots[i];
+            uint64 count = slot.count.exchange(0, std::memory_order_relaxed);
+            if (count == 0)
+                continue;
+            double peak = from_bits(slot.peak.exchange(to_bits(0), std::memory_order_relaxed));
+            double last = from_bits(slot.last.load(std::memory_order_relaxed));
+
+            std::ostringstream text;
+            text << slot.message;
+            if (count == 1)
+                text << " with a value of " << last;
+            else
+                text << ": " << count << " times in the last " << std::fixed << std::setprecision(1) << window << " s, peak " << std::defaultfloat << std::setprecision(6) << peak;
+            if (!slot.unit.empty())
+                text << " " << slot.unit;
+
+            switch (slot.severity) {
+                case Fatal:
+                case Error:
+                    LOG(Error) << text.str();
+                    break;
+                case Warning:
+                    LOG(Warning) << text.str();
+                    break;
+                default:
+                    LOG(Info) << text.str();
+                    break;
+            }
+            logged++;
+        }
+        return logged;
+    }
+
+    void EventLog::report_loop() {
+        std::unique_lock<std::mutex> lock(m_stop_mutex);
+        while (!m_stop_cv.wait_for(lock, std::chrono::microseconds(m_window.as_microseconds()), [this] { return m_stop; })) {
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+    EventLog& event_log() {
+        static EventLog log;
+        return log;
+    }
+
+} // namespace meii
@@ -0,0 +1,34 @@
+#include <MEII/Utility/LoopClock.hpp>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    LoopClock::LoopClock(Time period, Mode mode) :
+        m_period(period),
+        m_mode(mode),
+        m_timer(period, Timer::Hybrid),
+        m_ticks(0)
+    { }
+
+    Time LoopClock::wait() {
+        m_ticks++;
+        if (m_mode == RealTime)
+            return m_timer.wait();
+        return get_elapsed_time();
+    }
+
+    Time LoopClock::get_elapsed_time() const {
+        if (m_mode == RealTime)
+            return m_timer.get_elapsed_time();
+        return microseconds(m_period.as_microseconds() * m_ticks);
+    }
+
+    Time LoopClock::restart() {
+        Time elapsed = get_elapsed_time();
+        m_ticks = 0;
+        m_timer.restart();
+        return elapsed;
+    }
+
+} // namespace meii
@@ -0,0 +1,287 @@
+#include <MEII/Utility/SessionRecorder.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include <Mahi/Util/Timing/Clock.hpp>
+#include "Crc32.hpp"
+#include <algorithm>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+        const char file_magic[8] = { 'M', 'E', 'I', 'I', 'R', 'E', 'C', '\0' };
+        const char chunk_magic[4] = { 'C', 'H', 'N', 'K' };
+        const uint32 file_version = 1;
+
+        /// header written in front of every chunk of records
+        struct ChunkHeader {
+            char magic[4];      // "CHNK"
+            uint32 n_records;   // records in the chunk
+            uint64 first;       // index of the first record in the session
+            uint32 crc;         // CRC-32 of the records
+            uint32 reserved;    // zero
+        };
+    }
+
+    std::size_t record_type_size(RecordType type) {
+        switch (type) {
+            case RecordType::Float64: return 8;
+            case RecordType::Float32: return 4;
+            case RecordType::Int64:   return 8;
+            case RecordType::Int32:   return 4;
+            case RecordType::UInt8:   return 1;
+        }
+        return 0;
+    }
+
+    ///////////////////////// RECORD SCHEMA /////////////////////////
+
+    std::size_t RecordSchema::add_field(const std::string& name, RecordType type) {
+        Field field;
+        field.name = name.substr(0, 255);
+        field.type = type;
+        field.offset = m_record_size;
+        m_fields.push_back(field);
+        m_record_size += record_type_size(type);
+        return m_fields.size() - 1;
+    }
+
+    double RecordSchema::get_double(const uint8* record, std::size_t field) const {
+        const uint8* src = record + m_fields[field].offset;
+        switch (m_fields[field].type) {
+            case RecordType::Float64: { double v; std::memcpy(&v, src, sizeof(v)); return v; }
+            case RecordType::Float32: { float v;  std::memcpy(&v, src, sizeof(v)); return v; }
+            case RecordType::Int64:   { int64 v;  std::memcpy(&v, src, sizeof(v)); return (double)v; }
+            case RecordType::Int32:   { int32 v;  std::memcpy(&v, src, sizeof(v)); return v; }
+            case RecordType::UInt8:   return *src;
+        }
+        return 0;
+    }
+
+    int64 RecordSchema::get_int(const uint8* record, std::size_t field) const {
+        const uint8* src = record + m_fields[field].offset;
+        switch (m_fields[field].type) {
+            case RecordType::Int64: { int64 v; std::memcpy(&v, src, sizeof(v)); return v; }
+            case RecordType::Int32: { int32 v; std::memcpy(&v, src, sizeof(v)); return v; }
+            case RecordType::UInt8: return *src;
+            default:                return (int64)get_double(record, field);
+        }
+    }
+
+    ///////////////////////// SESSION RECORDER /////////////////////////
+
+    SessionRecorder::SessionRecorder(const RecordSchema& schema, std::size_t capacity, std::size_t chunk_records, Time max_chunk_age) :
+        m_schema(schema),
+        m_record_size(schema.get_record_size()),
+        m_capacity(std::max<std::size_t>(capacity, 1)),
+        m_chunk_records(std::max<std::size_t>(std::min(chunk_records, m_capacity), 1)),
+        m_max_chunk_age(max_chunk_age),
+        m_ring(m_capacity * m_record_size),
+        m_staging(m_record_size, 0),
+        m_closing(false),
+        m_write_failed(false),
+        m_head(0),
+        m_tail(0),
+        m_dropped(0),
+        m_chunks(0)
+    { }
+
+    SessionRecorder::~SessionRecorder() {
+        close();
+    }
+
+    bool SessionRecorder::open(const std::string& filepath) {
+        if (is_open()) {
+            LOG(Error) << "SessionRecorder already has a file open.";
+            return false;
+        }
+        m_file = std::fopen(filepath.c_str(), "wb");
+        if (m_file == nullptr) {
+            LOG(Error) << "Failed to open " << filepath << " for writing.";
+            return false;
+        }
+
+        // schema header
+        uint32 record_size = (uint32)m_record_size;
+        uint32 n_fields = (uint32)m_schema.get_field_count();
+        std::fwrite(file_magic, sizeof(file_magic), 1, m_file);
+        std::fwrite(&file_version, sizeof(file_version), 1, m_file);
+        std::fwrite(&record_size, sizeof(record_size), 1, m_file);
+        std::fwrite(&n_fields, sizeof(n_fields), 1, m_file);
+        for (std::size_t i = 0; i < n_fields; ++i) {
+            uint8 type = (uint8)m_schema.get_field_type(i);
+            uint8 length = (uint8)m_schema.get_field_name(i).size();
+            std::fwrite(&type, 1, 1, m_file);
+            std::fwrite(&length, 1, 1, m_file);
+            std::fwrite(m_schema.get_field_name(i).data(), 1, length, m_file);
+        }
+        if (std::fflush(m_file) != 0 || std::ferror(m_file)) {
+            LOG(Error) << "Failed to write the header of " << filepath << ".";
+            std::fclose(m_file);
+            m_file = nullptr;
+            return false;
+        }
+
+        m_head = 0;
+        m_tail = 0;
+        m_dropped = 0;
+        m_chunks = 0;
+        m_closing = false;
+        m_write_failed = false;
+        m_writer = std::thread(&SessionRecorder::write_loop, this);
+        return true;
+    }
+
+    void SessionRecorder::close() {
+        if (!is_open())
+            return;
+        m_closing = true;
+        if (m_writer.joinable())
+            m_writer.join();
+        std::fclose(m_file);
+        m_file = nullptr;
+        if (m_dropped > 0)
+            LOG(Warning) << "SessionRecorder dropped " << m_dropped << " records because the writer fell behind.";
+    }
+
+    bool SessionRecorder::record(const void* record) {
+        uint64 head = m_head.load(std::memory_order_relaxed);
+        if (m_file == nullptr || head - m_tail.load(std::memory_order_acquire) >= m_capacity) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        std::memcpy(&m_ring[(head % m_capacity) * m_record_size], record, m_record_size);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void SessionRecorder::write_loop() {
+        // the age of the oldest waiting record is measured from when the writer first saw it
+        Clock waiting;
+        bool any_waiting = false;
+        while (true) {
+            bool closing = m_closing.load(std::memory_order_acquire);
+            uint64 tail = m_tail.load(std::memory_order_relaxed);
+            std::size_t n = (std::size_t)(m_head.load(std::memory_order_acquire) - tail);
+            if (n > 0 && !any_waiting) {
+                waiting.restart();
+                any_waiting = true;
+            }
+            if (n >= m_chunk_records || (n > 0 && (closing || waiting.get_elapsed_time() >= m_max_chunk_age))) {
+                if (!m_write_failed && !write_chunk(std::min(n, m_chunk_records)))
+                    m_write_failed = true;
+                if (m_write_failed) // keep draining so the recording thread is not blocked, the records are lost
+                    m_tail.store(tail + std::min(n, m_chunk_records), std::memory_order_release);
+                any_waiting = m_head.load(std::memory_order_acquire) != m_tail.load(std::memory_order_relaxed);
+                if (any_waiting)
+                    waiting.restart();
+                continue;
+            }
+            if (closing && n == 0)
+                break;
+            sleep(milliseconds(2));
+        }
+    }
+
+    bool SessionRecorder::write_chunk(std::size_t n) {
+        uint64 tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t start = (std::size_t)(tail % m_capacity);
+        std::size_t first = std::min(n, m_capacity - start); // records before the ring wraps
+        const uint8* a = &m_ring[start * m_record_size];
+        const uint8* b = &m_ring[0];
+
+        ChunkHeader header;
+        std::memcpy(header.magic, chunk_magic, sizeof(chunk_magic));
+        header.n_records = (uint32)n;
+        header.first = tail;
+        header.crc = crc32(crc32(0, a, first * m_record_size), b, (n - first) * m_record_size);
+        header.reserved = 0;
+
+        bool ok = std::fwrite(&header, sizeof(header), 1, m_file) == 1;
+        ok = ok && std::fwrite(a, m_record_size, first, m_file) == first;
+        ok = ok && std::fwrite(b, m_record_size, n - first, m_file) == n - first;
+        // hand each chunk to the OS as soon as it is complete, so a crash loses at most the next one
+        ok = ok && std::fflush(m_file) == 0;
+        if (!ok) {
+            LOG(Error) << "Failed to write a chunk of " << n << " records, recording stopped.";
+            return false;
+        }
+        m_tail.store(tail + n, std::memory_order_release);
+        m_chunks.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    ///////////////////////// SESSION READER /////////////////////////
+
+    bool SessionReader::open(const std::string& filepath) {
+        close();
+        m_file = std::fopen(filepath.c_str(), "rb");
+        if (m_file == nullptr) {
+            LOG(Error) << "Failed to open " << filepath << " for reading.";
+            return false;
+        }
+        char magic[8];
+        uint32 version = 0, record_size = 0, n_fields = 0;
+        bool ok = std::fread(magic, sizeof(magic), 1, m_file) == 1 && std::memcmp(magic, file_magic, sizeof(magic)) == 0;
+        ok = ok && std::fread(&version, sizeof(version), 1, m_file) == 1 && version == file_version;
+        ok = ok && std::fread(&record_size, sizeof(record_size), 1, m_file) == 1;
+        ok = ok && std::fread(&n_fields, sizeof(n_fields), 1, m_file) == 1;
+        m_schema = RecordSchema();
+        for (uint32 i = 0; ok && i < n_fields; ++i) {
+            uint8 type, length;
+            char name[256];
+            ok = std::fread(&type, 1, 1, m_file) == 1 && type <= (uint8)RecordType::UInt8;
+            ok = ok && std::fread(&length, 1, 1, m_file) == 1;
+            ok = ok && std::fread(name, 1, length, m_file) == length;
+            if (ok)
+                m_schema.add_field(std::string(name, length), (RecordType)type);
+        }
+        // the chunks that follow can claim no more records than the rest of the file holds
+        long start = ok ? std::ftell(m_file) : -1;
+        long end = start >= 0 && std::fseek(m_file, 0, SEEK_END) == 0 ? std::ftell(m_file) : -1;
+        ok = ok && end >= start && std::fseek(m_file, start, SEEK_SET) == 0;
+        if (!ok || m_schema.get_record_size() != record_size) {
+            LOG(Error) << filepath << " is not a MEII session file of version " << file_version << ".";
+            close();
+            return false;
+        }
+        m_remaining = (uint64)(end - start);
+        m_next = 0;
+        m_damaged = false;
+        return true;
+    }
+
+    void SessionReader::close() {
+        if (m_file != nullptr) {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    std::size_t SessionReader::read_chunk(std::vector<uint8>& records) {
+        if (m_file == nullptr || m_damaged)
+            return 0;
+        ChunkHeader header;
+        std::size_t got = std::fread(&header, 1, sizeof(header), m_file);
+        if (got == 0 && std::feof(m_file))
+            return 0;
+        std::size_t size = m_schema.get_record_size();
+        bool ok = got == sizeof(header) && std::memcmp(header.magic, chunk_magic, sizeof(chunk_magic)) == 0 && header.first == m_next;
+        // checked before allocating, since a damaged header can claim any number of records
+        ok = ok && header.n_records <= (m_remaining - sizeof(header)) / size;
+        if (ok) {
+            m_remaining -= sizeof(header) + header.n_records * size;
+            records.resize(header.n_records * size);
+            ok = std::fread(records.data(), size, header.n_records, m_file) == header.n_records &&
+                 crc32(0, records.data(), records.size()) == header.crc;
+        }
+        if (!ok) {
+            m_damaged = true;
+            records.clear();
+            return 0;
+        }
+        m_next += header.n_records;
+        return header.n_records;
+    }
+
+} // namespace meii
@@ -0,0 +1,130 @@
+#include <MEII/Utility/TraceRecorder.hpp>
+#include <MEII/Utility/CycleClock.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+        struct Span {
+            const char* name;
+            uint64 begin;
+            uint64 end;
+            int32 index;
+        };
+
+        /// writes s as a JSON string
+        void write_string(std::ostream& out, const char* s) {
+            out << '"';
+            for (; *s; ++s) {
+                if (*s == '"' || *s == '\\')
+                    out << '\\';
+                out << *s;
+            }
+            out << '"';
+        }
+    }
+
+    TraceRecorder::TraceRecorder() :
+        m_mask(0),
+        m_enabled(false),
+        m_claimed(0),
+        m_committed(0)
+    { }
+
+    bool TraceRecorder::allocate(std::size_t capacity) {
+        if (is_enabled()) {
+            LOG(Error) << "Cannot allocate a TraceRecorder while it is recording.";
+            return false;
+        }
+        std::size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+        m_slots.reset(new Slot[size]);
+        m_mask = size - 1;
+        m_claimed.store(0, std::memory_order_relaxed);
+        m_committed.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    void TraceRecorder::set_enabled(bool enabled) {
+        if (enabled && !m_slots) {
+            LOG(Error) << "Cannot enable a TraceRecorder before allocate() has been called.";
+            return;
+        }
+        m_enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool TraceRecorder::write_json(const std::string& filepath, Time window, const std::string& thread_name) const {
+        if (!m_slots) {
+            LOG(Error) << "Cannot write a trace from a TraceRecorder that was never allocated.";
+            return false;
+        }
+
+        // copy the spans held, then drop any the recording thread may have overwritten meanwhile
+        uint64 committed = m_committed.load(std::memory_order_acquire);
+        uint64 first = committed > m_mask + 1 ? committed - (m_mask + 1) : 0;
+        std::vector<Span> spans;
+        spans.reserve(static_cast<std::size_t>(committed - first));
+        for (uint64 n = first; n < committed; ++n) {
+            const Slot& slot = m_slots[n & m_mask];
+            Span span = { slot.name.load(std::memory_order_relaxed), slot.begin.load(std::memory_order_relaxed),
+                          slot.end.load(std::memory_order_relaxed), slot.index.load(std::memory_order_relaxed) };
+            spans.push_back(span);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64 claimed = m_claimed.load(std::memory_order_relaxed);
+        std::size_t overwritten = 0;
+        if (claimed > m_mask + 1 && claimed - (m_mask + 1) > first)
+            overwritten = static_cast<std::size_t>(std::min<uint64>(claimed - (m_mask + 1) - first, spans.size()));
+
+        // keep only the spans that ended within window of the newest
+        uint64 newest = 0;
+        for (std::size_t i = overwritten; i < spans.size(); ++i)
+            newest = std::max(newest, spans[i].end);
+        uint64 window_ticks = static_cast<uint64>(window.as_microseconds() * 1000.0 / CycleClock::ns_per_tick());
+        uint64 cutoff = (window_ticks > 0 && newest > window_ticks) ? newest - window_ticks : 0;
+        uint64 origin = newest;
+        for (std::size_t i = overwritten; i < spans.size(); ++i) {
+            if (spans[i].end >= cutoff)
+                origin = std::min(origin, spans[i].begin);
+        }
+
+        std::ofstream file(filepath);
+        if (!file.is_open()) {
+            LOG(Error) << "Failed to open trace file " << filepath << ".";
+            return false;
+        }
+        double us_per_tick = CycleClock::ns_per_tick() * 1e-3;
+        file << std::fixed << std::setprecision(3);
+        file << "{\"traceEvents\":[\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":";
+        write_string(file, thread_name.c_str());
+        file << "}}";
+        for (std::size_t i = overwritten; i < spans.size(); ++i) {
+            const Span& span = spans[i];
+            if (span.end < cutoff)
+                continue;
+            file << ",\n{\"name\":";
+            write_string(file, span.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << (span.begin - origin) * us_per_tick
+                 << ",\"dur\":" << (span.end - span.begin) * us_per_tick;
+            if (span.index >= 0)
+                file << ",\"args\":{\"index\":" << span.index << "}";
+            file << "}";
+        }
+        file << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        file.close();
+        if (file.fail()) {
+            LOG(Error) << "Failed to write trace file " << filepath << ".";
+            return false;
+        }
+        return true;
+    }
+
+} // namespace meii
@@ -0,0 +1,114 @@
+#include <MEII/Utility/WorkStealingPool.hpp>
+#include <Mahi/Util/Logging/Log.hpp>
+#include <algorithm>
+#include <exception>
+
+using namespace mahi::util;
+
+namespace meii {
+
+    namespace {
+        // pool and index of the worker running on this thread, so submit() can keep a worker's tasks on its own deque
+        thread_local const WorkStealingPool* t_pool = nullptr;
+        thread_local std::size_t t_worker = 0;
+    }
+
+    WorkStealingPool::WorkStealingPool(std::size_t threads) :
+        m_next(0),
+        m_queued(0),
+        m_unfinished(0),
+        m_steals(0),
+        m_stop(false)
+    {
+        if (threads == 0)
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+        for (std::size_t i = 0; i < threads; ++i)
+            m_deques.emplace_back(new Deque());
+        for (std::size_t i = 0; i < threads; ++i)
+            m_threads.emplace_back(&WorkStealingPool::work, this, i);
+    }
+
+    WorkStealingPool::~WorkStealingPool() {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_work_cv.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    void WorkStealingPool::submit(std::function<void()> task) {
+        std::size_t worker = t_pool == this ? t_worker : m_next.fetch_add(1, std::memory_order_relaxed) % m_deques.size();
+        m_unfinished.fetch_add(1, std::memory_order_relaxed);
+        // counted under m_mutex so an idle worker cannot miss it between checking and waiting, and before
+        // it is queued so a worker taking it never counts it below zero
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queued.fetch_add(1, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_deques[worker]->mutex);
+            m_deques[worker]->tasks.push_back(std::move(task));
+        }
+        m_work_cv.notify_one();
+    }
+
+    void WorkStealingPool::wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_cv.wait(lock, [this] { return m_unfinished.load(std::memory_order_acquire) == 0; });
+    }
+
+    bool WorkStealingPool::take(std::size_t worker, std::function<void()>& task) {
+        {
+            Deque& own = *m_deques[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < m_deques.size(); ++i) {
+            Deque& victim = *m_deques[(worker + i) % m_deques.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                m_steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void WorkStealingPool::work(std::size_t worker) {
+        t_pool = this;
+        t_worker = worker;
+        std::function<void()> task;
+        while (true) {
+            if (take(worker, task)) {
+                try {
+                    task();
+                }
+                catch (const std::exception& e) {
+                    LOG(Error) << "Task on worker " << worker << " threw: " << e.what();
+                }
+                task = nullptr;
+                if (m_unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done_cv.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_cv.wait(lock, [this] { return m_stop || m_queued.load(std::memory_order_relaxed) > 0; });
+            if (m_stop)
+                return;
+        }
+    }
+
+} // namespace meii